@@ -0,0 +1,212 @@
+#include "benchmark/benchmark.h"
+
+#include "storage/DataView.h"
+#include "storage/exvector.h"
+#include "storage/Matrix.h"
+#include "storage/MCTask.h"
+#include "storage/MLTask.h"
+#include "storage/Random.h"
+#include "storage/StorageConstants.h"
+#include "storage/UnorderedMatrix.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace obamadb {
+
+  namespace {
+    int const kNumColumns = 10000;
+    int const kMatrixBytes = 4e6;
+
+    /**
+     * @param sparsity_permille Thousandths of each row which are zero.
+     * @return A shared random matrix for the sparsity, built on first use.
+     */
+    Matrix const & randomMatrix(int sparsity_permille) {
+      static std::mutex mutex;
+      static std::vector<std::unique_ptr<Matrix>> matrices(1001);
+      std::lock_guard<std::mutex> lock(mutex);
+      std::unique_ptr<Matrix> & matrix = matrices[sparsity_permille];
+      if (!matrix) {
+        matrix.reset(Matrix::GetRandomMatrix(kMatrixBytes, kNumColumns, sparsity_permille / 1e3, 1337));
+      }
+      return *matrix;
+    }
+
+    void fillRandom(int dimension, dvector<num_t> * vec) {
+      rng::CounterRng rng(1337, dimension);
+      for (int i = 0; i < dimension; i++) {
+        vec->push_back(rng.nextFloat());
+      }
+    }
+
+    void sparsityArgs(benchmark::internal::Benchmark * b) {
+      b->Arg(900)->Arg(990)->Arg(999);
+    }
+  }
+
+  void BM_DenseDot(benchmark::State & state) {
+    int const dimension = state.range(0);
+    dvector<num_t> v1(dimension);
+    dvector<num_t> v2(dimension);
+    fillRandom(dimension, &v1);
+    fillRandom(dimension, &v2);
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(ml::dot(v1, v2.values_));
+    }
+    state.SetItemsProcessed(state.iterations() * dimension);
+  }
+  BENCHMARK(BM_DenseDot)->RangeMultiplier(4)->Range(16, 1 << 14);
+
+  void BM_DenseScaleAndAdd(benchmark::State & state) {
+    int const dimension = state.range(0);
+    dvector<num_t> v1(dimension);
+    dvector<num_t> v2(dimension);
+    fillRandom(dimension, &v1);
+    fillRandom(dimension, &v2);
+    for (auto _ : state) {
+      ml::scale_and_add(v1, v2, 1e-6);
+      benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * dimension);
+  }
+  BENCHMARK(BM_DenseScaleAndAdd)->RangeMultiplier(4)->Range(16, 1 << 14);
+
+  /**
+   * Sparse dot products of every training row against a model, as in an SVM epoch.
+   */
+  void BM_SparseDot(benchmark::State & state) {
+    Matrix const & matrix = randomMatrix(state.range(0));
+    fvector theta = fvector::GetRandomFVector(kNumColumns);
+    DataView view;
+    for (SparseDataBlock<num_t> const * block : matrix.blocks_) {
+      view.appendBlock(block);
+    }
+    svector<num_t> row(0, nullptr);
+    std::int64_t nnz = 0;
+    for (auto _ : state) {
+      if (!view.getNext(&row)) {
+        view.reset();
+        view.getNext(&row);
+      }
+      benchmark::DoNotOptimize(ml::dot(row, theta.values_));
+      nnz += row.numElements();
+    }
+    state.SetItemsProcessed(nnz);
+  }
+  BENCHMARK(BM_SparseDot)->Apply(sparsityArgs);
+
+  void BM_SparseScaleAndAdd(benchmark::State & state) {
+    Matrix const & matrix = randomMatrix(state.range(0));
+    fvector theta = fvector::GetRandomFVector(kNumColumns);
+    DataView view;
+    for (SparseDataBlock<num_t> const * block : matrix.blocks_) {
+      view.appendBlock(block);
+    }
+    svector<num_t> row(0, nullptr);
+    std::int64_t nnz = 0;
+    for (auto _ : state) {
+      if (!view.getNext(&row)) {
+        view.reset();
+        view.getNext(&row);
+      }
+      ml::scale_and_add(theta.values_, row, 1e-6);
+      benchmark::ClobberMemory();
+      nnz += row.numElements();
+    }
+    state.SetItemsProcessed(nnz);
+  }
+  BENCHMARK(BM_SparseScaleAndAdd)->Apply(sparsityArgs);
+
+  /**
+   * The SVM update of rows of a matrix without zeros, which is stored in dense blocks. Arg 0 goes
+   * through the index like a sparse row, arg 1 uses the contiguous kernels SVMTask uses for them.
+   */
+  void BM_DenseRowUpdate(benchmark::State & state) {
+    bool const contiguous = state.range(0) == 1;
+    // Dense blocks are opt in. The other benchmarks never build a matrix this dense.
+    FLAGS_dense_block_density = 0.5;
+    Matrix const & matrix = randomMatrix(0);
+    fvector theta = fvector::GetRandomFVector(kNumColumns);
+    DataView view;
+    for (SparseDataBlock<num_t> const * block : matrix.blocks_) {
+      view.appendBlock(block);
+    }
+    svector<num_t> row(0, nullptr);
+    bool dense = false;
+    std::int64_t nnz = 0;
+    for (auto _ : state) {
+      if (!view.getNext(&row, &dense)) {
+        view.reset();
+        view.getNext(&row, &dense);
+      }
+      if (contiguous && dense) {
+        num_t const wxy = ml::dot(row.values_, theta.values_, row.num_elements_);
+        ml::scale_and_add(theta.values_, row.values_, row.num_elements_, 1e-6 * wxy);
+      } else {
+        num_t const wxy = ml::dot(row, theta.values_);
+        ml::scale_and_add(theta.values_, row, 1e-6 * wxy);
+      }
+      benchmark::ClobberMemory();
+      nnz += row.numElements();
+    }
+    state.SetItemsProcessed(nnz);
+    state.counters["dense"] = dense;
+  }
+  BENCHMARK(BM_DenseRowUpdate)->Arg(0)->Arg(1);
+
+  /**
+   * A dot product and update per row into one shared model from several threads, like the
+   * Hogwild SVM workers. Scaling with the thread count shows the cost of write sharing.
+   */
+  void BM_HogwildUpdate(benchmark::State & state) {
+    Matrix const & matrix = randomMatrix(state.range(0));
+    static fvector theta = fvector::GetRandomFVector(kNumColumns);
+    // Each thread starts on its own block.
+    std::vector<SparseDataBlock<num_t> const *> blocks;
+    for (int b = 0; b < matrix.blocks_.size(); b++) {
+      blocks.push_back(matrix.blocks_[(b + state.thread_index()) % matrix.blocks_.size()]);
+    }
+    DataView view(blocks);
+    svector<num_t> row(0, nullptr);
+    std::int64_t nnz = 0;
+    for (auto _ : state) {
+      if (!view.getNext(&row)) {
+        view.reset();
+        view.getNext(&row);
+      }
+      num_t const wxy = ml::dot(row, theta.values_) * *row.getClassification();
+      if (wxy < 1) {
+        ml::scale_and_add(theta.values_, row, 1e-6 * *row.getClassification());
+      }
+      nnz += row.numElements();
+    }
+    state.SetItemsProcessed(nnz);
+  }
+  BENCHMARK(BM_HogwildUpdate)->Apply(sparsityArgs)->ThreadRange(1, 8)->UseRealTime();
+
+  /**
+   * One epoch of matrix completion updates at a given rank.
+   */
+  void BM_MCUpdate(benchmark::State & state) {
+    int const rank = state.range(0);
+    int const num_users = 2000;
+    int const num_items = 1000;
+    int const num_entries = 100000;
+    UnorderedMatrix entries;
+    rng::CounterRng rng(1337, 0);
+    for (int i = 0; i < num_entries; i++) {
+      entries.append(rng.nextInt(num_users), rng.nextInt(num_items), 1 + rng.nextInt(5));
+    }
+    std::shared_ptr<MCStatistics const> statistics(new MCStatistics(&entries, 1));
+    MCState mc_state(&entries, statistics, rank, 1);
+    MCTask task(1, &entries, &mc_state);
+    for (auto _ : state) {
+      task.execute(0, nullptr);
+    }
+    state.SetItemsProcessed(state.iterations() * num_entries);
+  }
+  BENCHMARK(BM_MCUpdate)->Arg(10)->Arg(50)->Arg(100)->Unit(benchmark::kMillisecond);
+
+} // namespace obamadb
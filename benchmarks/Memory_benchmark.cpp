@@ -0,0 +1,68 @@
+#include "benchmark/benchmark.h"
+
+#include "storage/HugePages.h"
+#include "storage/PerfCounters.h"
+#include "storage/Random.h"
+#include "storage/StorageConstants.h"
+
+#include <memory>
+#include <vector>
+
+namespace obamadb {
+
+  namespace {
+    int const kReadsPerIteration = 1 << 16;
+
+    /**
+     * Reads the model at random indices, as ml::dot does for the columns of sparse rows, and
+     * reports the dTLB misses per read if the machine can count them.
+     */
+    void gather(benchmark::State & state, num_t const * model, int dimension) {
+      rng::CounterRng rng(1337, 0);
+      std::vector<int> indices(kReadsPerIteration);
+      for (int & index : indices) {
+        index = rng.nextInt(dimension);
+      }
+      perf::ThreadCounters counters;
+      counters.start();
+      for (auto _ : state) {
+        num_t sum = 0;
+        for (int index : indices) {
+          sum += model[index];
+        }
+        benchmark::DoNotOptimize(sum);
+      }
+      perf::Sample const sample = counters.stop();
+      double const reads = static_cast<double>(state.iterations()) * kReadsPerIteration;
+      state.SetItemsProcessed(reads);
+      if (sample.valid[perf::kDTLBMisses]) {
+        state.counters["dtlb_misses_per_read"] = sample.values[perf::kDTLBMisses] / reads;
+      }
+    }
+  }
+
+  /**
+   * A model on the heap, as fvector was allocated before hugepages::allocate. With transparent
+   * huge pages set to always, the heap may get huge pages as well.
+   */
+  void BM_ModelGatherHeap(benchmark::State & state) {
+    int const dimension = state.range(0);
+    std::unique_ptr<num_t[]> model(new num_t[dimension]);
+    rng::fillUniform(model.get(), dimension, -1, 1);
+    gather(state, model.get(), dimension);
+  }
+  BENCHMARK(BM_ModelGatherHeap)->RangeMultiplier(16)->Range(1 << 16, 1 << 24);
+
+  /**
+   * The same model from hugepages::allocate, as used by fvector and the MC factor matrices.
+   */
+  void BM_ModelGatherHugePages(benchmark::State & state) {
+    int const dimension = state.range(0);
+    num_t* model = hugepages::allocateArray<num_t>(dimension);
+    rng::fillUniform(model, dimension, -1, 1);
+    gather(state, model, dimension);
+    hugepages::release(model);
+  }
+  BENCHMARK(BM_ModelGatherHugePages)->RangeMultiplier(16)->Range(1 << 16, 1 << 24);
+
+} // namespace obamadb
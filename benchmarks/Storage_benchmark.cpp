@@ -0,0 +1,110 @@
+#include "benchmark/benchmark.h"
+
+#include "storage/DataView.h"
+#include "storage/exvector.h"
+#include "storage/Matrix.h"
+#include "storage/Random.h"
+#include "storage/SparseDataBlock.h"
+#include "storage/Utils.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace obamadb {
+
+  namespace {
+    int const kNumColumns = 10000;
+    int const kBlockBytes = 4e6;
+  }
+
+  /**
+   * Random access to the rows of one block.
+   */
+  void BM_GetRowVectorFast(benchmark::State & state) {
+    std::unique_ptr<SparseDataBlock<num_t>> block(
+      GetRandomSparseDataBlock(kBlockBytes, kNumColumns, state.range(0) / 1e3, 1337));
+    int const num_rows = block->num_rows_;
+    rng::CounterRng rng(1337, 0);
+    std::vector<int> order(num_rows);
+    for (int i = 0; i < num_rows; i++) {
+      order[i] = rng.nextInt(num_rows);
+    }
+    svector<num_t> row(0, nullptr);
+    int i = 0;
+    for (auto _ : state) {
+      block->getRowVectorFast(order[i], &row);
+      benchmark::DoNotOptimize(row.values_[0]);
+      i = i + 1 == num_rows ? 0 : i + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+  BENCHMARK(BM_GetRowVectorFast)->Arg(900)->Arg(990)->Arg(999);
+
+  /**
+   * A full pass over a matrix through a DataView, touching every value, as the task loops do.
+   */
+  void BM_DataViewScan(benchmark::State & state) {
+    std::unique_ptr<Matrix> matrix(Matrix::GetRandomMatrix(4 * kBlockBytes, kNumColumns, state.range(0) / 1e3, 1337));
+    DataView view;
+    for (SparseDataBlock<num_t> const * block : matrix->blocks_) {
+      view.appendBlock(block);
+    }
+    svector<num_t> row(0, nullptr);
+    std::int64_t rows = 0;
+    std::int64_t bytes = 0;
+    for (auto _ : state) {
+      view.reset();
+      num_t sum = 0;
+      while (view.getNext(&row)) {
+        for (int j = 0; j < row.numElements(); j++) {
+          sum += row.values_[j];
+        }
+        rows++;
+        bytes += row.numElements() * (sizeof(int) + sizeof(num_t));
+      }
+      benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(rows);
+    state.SetBytesProcessed(bytes);
+  }
+  BENCHMARK(BM_DataViewScan)->Arg(900)->Arg(990)->Arg(999)->Unit(benchmark::kMillisecond);
+
+  /**
+   * Parsing a TSV training file of sparse rows with the Scanner.
+   */
+  void BM_ScannerParse(benchmark::State & state) {
+    std::unique_ptr<SparseDataBlock<num_t>> block(
+      GetRandomSparseDataBlock(kBlockBytes, kNumColumns, state.range(0) / 1e3, 1337));
+    char file_name[] = "/tmp/obamadb_scanner_XXXXXX";
+    int const fd = mkstemp(file_name);
+    CHECK_NE(-1, fd);
+    FILE* file = fdopen(fd, "w");
+    svector<num_t> row(0, nullptr);
+    for (int i = 0; i < block->num_rows_; i++) {
+      block->getRowVectorFast(i, &row);
+      for (int j = 0; j < row.numElements(); j++) {
+        fprintf(file, "%d %d %f\n", i, row.index_[j], row.values_[j]);
+      }
+    }
+    long const file_bytes = ftell(file);
+    fclose(file);
+
+    std::int64_t values = 0;
+    for (auto _ : state) {
+      Scanner scanner(file_name);
+      std::vector<double> line = scanner.scanLine();
+      while (!line.empty()) {
+        values += line.size();
+        line = scanner.scanLine();
+      }
+    }
+    unlink(file_name);
+    state.SetItemsProcessed(values);
+    state.SetBytesProcessed(state.iterations() * file_bytes);
+  }
+  BENCHMARK(BM_ScannerParse)->Arg(990)->Arg(999)->Unit(benchmark::kMillisecond);
+
+} // namespace obamadb
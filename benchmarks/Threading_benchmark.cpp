@@ -0,0 +1,37 @@
+#include "benchmark/benchmark.h"
+
+#include "storage/ThreadPool.h"
+
+#include <thread>
+#include <vector>
+
+namespace obamadb {
+
+  /**
+   * Round trips through a barrier shared with range(0) - 1 other threads, i.e. the
+   * synchronization cost the ThreadPool pays twice per cycle.
+   */
+  void BM_BarrierWait(benchmark::State & state) {
+    int const num_threads = state.range(0);
+    threading::barrier_t barrier(num_threads);
+    // The helpers wait as many times as the timed loop runs, so every round is complete.
+    benchmark::IterationCount const rounds = state.max_iterations;
+    std::vector<std::thread> helpers;
+    for (int t = 1; t < num_threads; t++) {
+      helpers.push_back(std::thread([&barrier, rounds]() {
+        for (benchmark::IterationCount i = 0; i < rounds; i++) {
+          barrier.wait();
+        }
+      }));
+    }
+    for (auto _ : state) {
+      barrier.wait();
+    }
+    for (std::thread & helper : helpers) {
+      helper.join();
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+  BENCHMARK(BM_BarrierWait)->DenseRange(1, 4)->Arg(8)->UseRealTime();
+
+} // namespace obamadb
@@ -1,13 +1,24 @@
+#include "storage/Checkpoint.h"
 #include "storage/DataBlock.h"
 #include "storage/DataView.h"
+#include "storage/Instrumentation.h"
 #include "storage/IO.h"
+#include "storage/LinearTask.h"
 #include "storage/Matrix.h"
+#include "storage/MemoryAccounting.h"
 #include "storage/MCTask.h"
 #include "storage/MLTask.h"
+#include "storage/PerfCounters.h"
+#include "storage/Results.h"
+#include "storage/RowPartitioning.h"
+#include "storage/Scorer.h"
 #include "storage/SVMTask.h"
+#include "storage/TopK.h"
+#include "storage/Trace.h"
 
 #include <algorithm>
 #include <gflags/gflags.h>
+#include <memory>
 #include <string>
 #include <unistd.h>
 #include <vector>
@@ -27,7 +38,7 @@ DEFINE_bool(measure_convergence, false, "If true, an observer thread will collec
   " as the algorithm does its first iteration. Useful for the SVM.");
 
 static bool ValidateAlgorithm(const char* flagname, std::string const & value) {
-  std::vector<std::string> valid_algorithms = {"svm", "mc"};
+  std::vector<std::string> valid_algorithms = {"svm", "mc", "lr", "ls"};
   if (std::find(valid_algorithms.begin(), valid_algorithms.end(), value) != valid_algorithms.end()) {
     return true;
   } else {
@@ -38,11 +49,31 @@ static bool ValidateAlgorithm(const char* flagname, std::string const & value) {
     return false;
   }
 }
-DEFINE_string(algorithm, "svm", "The machine learning algorithm to use. Select one of [svm, mc].");
+DEFINE_string(algorithm, "svm", "The machine learning algorithm to use. Select one of [svm, mc, lr, ls]."
+  " ls fits the label of each row as a real valued target, svm and lr read it as a class.");
 DEFINE_validator(algorithm, &ValidateAlgorithm);
 
+static bool ValidateMode(const char* flagname, std::string const & value) {
+  if (value.compare("train") == 0 || value.compare("predict") == 0 || value.compare("sweep") == 0) {
+    return true;
+  }
+  printf("Invalid mode. Choices are:\n\ttrain\n\tpredict\n\tsweep\n");
+  return false;
+}
+DEFINE_string(mode, "train", "Select one of [train, predict, sweep]. Predict applies the model in model_file"
+  " to the examples in test_file. Sweep loads the data once and trains every combination of"
+  " sweep_algorithms, sweep_core_affinities and sweep_threads, then reports the speedup curves.");
+DEFINE_validator(mode, &ValidateMode);
+
 DEFINE_string(train_file, "", "The TSV format file to train the algorithm over.");
-DEFINE_string(test_file, "", "The TSV format file to test the algorithm over.");
+DEFINE_string(test_file, "", "The TSV format file to test the algorithm over. In predict mode, the file to score.");
+DEFINE_string(model_file, "", "In predict mode, a checkpoint of the model to apply. See checkpoint_file.");
+DEFINE_string(predictions_file, "predictions.out", "In predict mode, the file predictions are written to.");
+
+DEFINE_int64(topk, 0, "If greater than 0, the top K items for every user of an MC model are written to"
+  " topk_file. Runs after training, or in predict mode on the model_file.");
+DEFINE_string(topk_file, "topk.out", "The file top K recommendations are written to.");
+DEFINE_bool(topk_prune, true, "Skip items which cannot make a user's top K based on the norms of the factors.");
 
 DEFINE_bool(verbose, false, "Print out extra diagnostic information.");
 
@@ -51,12 +82,66 @@ DEFINE_int64(num_epochs, 10, "The number of passes over the training data while
 DEFINE_int64(num_trials, 1, "The number of trials to perform."
   "This means the number of times we will train a model."
   "This is useful for computing the variance/stddev between trials.");
-DEFINE_string(core_affinities, "-1", "A comma separated list of cores to have threads bind to."
-  " The program will greedily use core, so over specify if you like. Ex: "
-  " -core_affinities 0,1,2,3 -threads 2 is valid");
+DEFINE_int64(trial_pause_ms, 0, "Milliseconds to sleep between trials, e.g. to let the machine cool down.");
+
+DEFINE_string(sweep_threads, "1,2,4", "In sweep mode, a comma separated list of thread counts to train with."
+  " Speedups are relative to the first.");
+DEFINE_string(sweep_algorithms, "", "In sweep mode, a comma separated list of algorithms to train. All must be"
+  " mc, or none, and ls cannot be mixed with svm or lr. Empty for just the algorithm flag.");
+DEFINE_string(sweep_core_affinities, "", "In sweep mode, a semicolon separated list of core_affinities values"
+  " to train with, e.g. \"0,1,2,3;0,2,4,6\". Empty for just the core_affinities flag.");
+
+DEFINE_uint64(seed, 1337, "Seed for the random numbers used to initialize and sample models. Synthetic"
+  " datasets carry their own seed in their spec.");
 
 DEFINE_int64(rank, 10, "The rank of the LR factoring matrices used in Matrix Completion");
 
+static bool ValidateMCOrder(const char* flagname, std::string const & value) {
+  if (value.compare("file") == 0 || value.compare("row") == 0 || value.compare("hilbert") == 0) {
+    return true;
+  }
+  printf("Invalid MC entry order. Choices are:\n\tfile\n\trow\n\thilbert\n");
+  return false;
+}
+DEFINE_string(mc_order, "file", "The order matrix completion visits training entries in. Select one of"
+  " [file, row, hilbert]. Row sorts entries by row then column; hilbert sorts tiles of the matrix along"
+  " a Hilbert curve so that consecutive updates reuse factor rows from cache.");
+DEFINE_validator(mc_order, &ValidateMCOrder);
+
+static bool ValidateSVMPartition(const char* flagname, std::string const & value) {
+  if (value.compare("row") == 0 || value.compare("column") == 0) {
+    return true;
+  }
+  printf("Invalid SVM partitioning. Choices are:\n\trow\n\tcolumn\n");
+  return false;
+}
+DEFINE_string(svm_partition, "row", "How SVM training is split between threads. Select one of [row, column]."
+  " Row gives each thread a share of the rows and updates a shared model Hogwild style. Column gives"
+  " each thread a range of the features, so model writes never conflict, at the cost of a barrier"
+  " every svm_batch_size rows.");
+DEFINE_validator(svm_partition, &ValidateSVMPartition);
+DEFINE_int64(svm_batch_size, 256, "Rows per batch when svm_partition is column.");
+
+static bool ValidateRowPartition(const char* flagname, std::string const & value) {
+  if (value.compare("block") == 0 || value.compare("minhash") == 0) {
+    return true;
+  }
+  printf("Invalid row partitioning. Choices are:\n\tblock\n\tminhash\n");
+  return false;
+}
+DEFINE_string(row_partition, "block", "How training rows are placed on threads for svm, lr and ls. Select one"
+  " of [block, minhash]. Block deals whole blocks out round robin. Minhash groups rows which write the same"
+  " cache lines of the model onto one thread and reports the write conflict rates of both placements.");
+DEFINE_validator(row_partition, &ValidateRowPartition);
+
+DEFINE_string(checkpoint_file, "", "If set, the model is written to this file every checkpoint_interval epochs"
+  " and at the end of training. Writes happen in a background thread.");
+DEFINE_int64(checkpoint_interval, 1, "The number of epochs between checkpoints.");
+DEFINE_string(warm_start, "", "A checkpoint file to initialize the model from instead of a random model."
+  " The model's dimensions must match the training data.");
+DEFINE_string(results_file, "", "If set, the configuration and the results of every epoch and trial are written to"
+  " this file as JSON lines. Writes happen in a background thread.");
+
 
 #define VPRINT(str) { if(FLAGS_verbose) { printf(str); } }
 #define VPRINTF(str, ...) { if(FLAGS_verbose) { printf(str, __VA_ARGS__); } }
@@ -64,6 +149,82 @@ DEFINE_int64(rank, 10, "The rank of the LR factoring matrices used in Matrix Com
 
 namespace obamadb {
 
+  // Set in main if results_file is given.
+  std::unique_ptr<ResultsWriter> results_writer;
+
+  /**
+   * @return A record of the epoch's results, or null if there is no results_file. Left to the
+   *    caller to add the epoch's metrics to and submit with submitEpochRecord.
+   */
+  ResultRecord* newEpochRecord(int trial, int epoch, double time) {
+    if (!results_writer) {
+      return nullptr;
+    }
+    ResultRecord* record = new ResultRecord("epoch");
+    record->add("trial", trial).add("epoch", epoch).add("time", time);
+    return record;
+  }
+
+  /**
+   * Adds the hardware counts and the memory use of each subsystem and of the process to the
+   * record and submits it.
+   */
+  void submitEpochRecord(ResultRecord * record, ThreadPool const & tp) {
+    if (FLAGS_perf_counters) {
+      perf::Sample const total = perf::sum(tp.getCounters());
+      for (int e = 0; e < perf::kNumEvents; e++) {
+        if (total.valid[e]) {
+          record->add(perf::eventName(static_cast<perf::Event>(e)),
+                      static_cast<std::int64_t>(total.values[e]));
+        }
+      }
+    }
+    memory::Usage const usage = memory::usage();
+    for (int s = 0; s < memory::kNumSubsystems; s++) {
+      record->add(std::string(memory::subsystemName(static_cast<memory::Subsystem>(s))) + "_bytes",
+                  usage.current[s]);
+    }
+    std::int64_t const rss = memory::peakResidentBytes();
+    if (rss >= 0) {
+      record->add("max_rss_bytes", rss);
+    }
+    results_writer->submit(*record);
+  }
+
+  void submitConfigRecord() {
+    ResultRecord record("config");
+    record.add("mode", FLAGS_mode)
+      .add("algorithm", FLAGS_algorithm)
+      .add("threads", FLAGS_threads)
+      .add("train_file", FLAGS_train_file)
+      .add("test_file", FLAGS_test_file)
+      .add("num_epochs", FLAGS_num_epochs)
+      .add("num_trials", FLAGS_num_trials)
+      .add("seed", static_cast<std::int64_t>(FLAGS_seed))
+      .add("core_affinities", FLAGS_core_affinities)
+      .add("block_size", FLAGS_block_size)
+      .add("rank", FLAGS_rank)
+      .add("mc_order", FLAGS_mc_order)
+      .add("svm_partition", FLAGS_svm_partition)
+      .add("svm_batch_size", FLAGS_svm_batch_size)
+      .add("row_partition", FLAGS_row_partition)
+      .add("perf_counters", FLAGS_perf_counters);
+    results_writer->submit(record);
+  }
+
+  /**
+   * Summarizes the epoch times of all trials.
+   */
+  void submitSummaryRecord(std::vector<double> const & epoch_times) {
+    ResultRecord record("summary");
+    record.add("epochs", static_cast<int>(epoch_times.size()))
+      .add("mean_time", stats::mean<double>(epoch_times))
+      .add("variance_time", stats::variance<double>(epoch_times))
+      .add("stddev_time", stats::stddev<double>(epoch_times))
+      .add("stderr_time", stats::stderr<double>(epoch_times));
+    results_writer->submit(record);
+  }
+
   /**
    * Used to snoop on the inter-epoch values of the model.
    */
@@ -124,60 +285,184 @@ namespace obamadb {
 
   /**
    * Allocates Datablocks to DataViews. Dataviews will then be given to threads in the form of tasks.
-   * @param num_threads How many dataviews to allocate and distribute amongst.
-   * @param data_blocks The set of training data.
-   * @return Vector of Dataviews.
+   * @param placement The blocks of each thread.
+   * @param views Receives one DataView per thread.
    */
-  template<class T>
-  void allocateBlocks(const int num_threads,
-                      const std::vector<SparseDataBlock<T> *> &data_blocks,
+  void allocateBlocks(partitioning::Placement const & placement,
                       std::vector<std::unique_ptr<DataView>>& views) {
     CHECK(views.size() == 0) << "Only accepts empty view vectors";
-    CHECK_GE(data_blocks.size(), views.size())
-      << "Partitioned data would not distribute to all threads."
-      << " Use fewer threads.";
-
-    for (int i = 0; i < data_blocks.size(); i++) {
-      if (i < num_threads) {
-        views.push_back(std::unique_ptr<DataView>(new DataView()));
-      }
-      SparseDataBlock<T> const *dbptr = data_blocks[i];
-      views[i % num_threads]->appendBlock(dbptr);
+    for (auto const & thread_blocks : placement) {
+      CHECK(!thread_blocks.empty())
+        << "Partitioned data would not distribute to all threads."
+        << " Use fewer threads.";
+      views.push_back(std::unique_ptr<DataView>(new DataView(thread_blocks)));
     }
   }
 
-  void printSVMEpochStats(Matrix const * matTrain,
-                        Matrix const * matTest,
-                        fvector const & theta,
-                        int iteration,
-                        float timeTrain) {
+  /**
+   * @return Caller-owned parameters shared by the workers of a linear model task.
+   */
+  SVMParams* defaultParams(Matrix * mat_train, SVMTask const *) {
+    SVMParams* svm_params = DefaultSVMParams(*mat_train, FLAGS_threads);
+    DCHECK_EQ(svm_params->degrees.size(), mat_train->maxColumns());
+    return svm_params;
+  }
 
-    if (!FLAGS_verbose) {
+  LinearParams* defaultParams(Matrix *, LRTask const *) {
+    return DefaultLRParams();
+  }
+
+  LinearParams* defaultParams(Matrix *, LSTask const *) {
+    return DefaultLSParams();
+  }
+
+  template<class TaskT>
+  void printLinearEpochStats(Matrix const * matTrain,
+                             Matrix const * matTest,
+                             fvector const & theta,
+                             int iteration,
+                             float timeTrain,
+                             ResultRecord * record) {
+
+    if (!FLAGS_verbose && record == nullptr) {
       return;
     }
 
-    double const trainRmsLoss = SVMTask::rmsErrorLoss(theta, matTrain->blocks_);
-    double const testRmsLoss = SVMTask::rmsErrorLoss(theta, matTest->blocks_);
-    double const trainFractionMisclassified = SVMTask::fractionMisclassified(theta,matTrain->blocks_);
-    double const testFractionMisclassified = SVMTask::fractionMisclassified(theta,matTest->blocks_);
-
+    trace::Scope scope("evaluate", "eval");
+    double const trainLoss = TaskT::loss(theta, matTrain->blocks_);
+    double const testLoss = TaskT::loss(theta, matTest->blocks_);
+    double const trainError = TaskT::error(theta, matTrain->blocks_);
+    double const testError = TaskT::error(theta, matTest->blocks_);
+
+    if (record != nullptr) {
+      record->add("train_loss", trainLoss)
+        .add("test_loss", testLoss)
+        .add(std::string("train_") + TaskT::errorName(), trainError)
+        .add(std::string("test_") + TaskT::errorName(), testError);
+    }
+    if (!FLAGS_verbose) {
+      return;
+    }
     printf("%-3d, %.3f, %.4f, %.2f, %.4f, %.2f\n",
            iteration,
            timeTrain,
-           trainFractionMisclassified,
-           trainRmsLoss,
-           testFractionMisclassified,
-           testRmsLoss);
+           trainError,
+           trainLoss,
+           testError,
+           testLoss);
+  }
+
+  /**
+   * @return A random linear model, counted as model memory.
+   */
+  fvector newLinearModel(int dimension) {
+    memory::SubsystemScope scope(memory::kModel);
+    return fvector::GetRandomFVector(dimension);
   }
 
   /**
+   * Linear model checkpoints hold theta followed by the current step size.
+   * @return Caller-owned snapshot.
+   */
+  template<class ParamsT>
+  ModelSnapshot* snapshotLinearModel(int epoch, fvector const & theta, ParamsT const * params) {
+    ModelSnapshot* snapshot = new ModelSnapshot(epoch);
+    snapshot->add(theta);
+    snapshot->add(std::vector<num_t>({params->step_size}));
+    return snapshot;
+  }
+
+  template<class ParamsT>
+  void warmStartLinearModel(std::string const & file_name, fvector * theta, ParamsT * params) {
+    std::unique_ptr<ModelSnapshot> snapshot(checkpoint::load(file_name));
+    CHECK_EQ(2, snapshot->records.size()) << file_name << " is not a linear model checkpoint.";
+    checkpoint::restore(snapshot->records[0], theta);
+    params->step_size = snapshot->records[1].values[0];
+    VPRINTF("Warm start from %s (epoch %d)\n", file_name.c_str(), snapshot->epoch);
+  }
+
+  /**
+   * Cycles a started thread pool of linear model workers through the training epochs, printing
+   * stats and checkpointing along the way, then stops it.
    * @return A vector of the epoch times.
    */
-  std::vector<double> trainSVM(Matrix *mat_train,
-                               Matrix *mat_test) {
-    SVMParams* svm_params = DefaultSVMParams<num_t>(mat_train->blocks_);
-    DCHECK_EQ(svm_params->degrees.size(), maxColumns(mat_train->blocks_));
-    fvector sharedTheta = fvector::GetRandomFVector(mat_train->numColumns_);
+  template<class TaskT>
+  std::vector<double> runLinearEpochs(int trial,
+                                      ThreadPool * tp,
+                                      Matrix const * mat_train,
+                                      Matrix const * mat_test,
+                                      fvector const & sharedTheta,
+                                      typename TaskT::Params const * params,
+                                      CheckpointWriter * checkpointer) {
+    VPRINTF("epoch, train_time, train_%s, train_loss, test_%s, test_loss\n", TaskT::errorName(), TaskT::errorName());
+    printLinearEpochStats<TaskT>(mat_train, mat_test, sharedTheta, -1, -1, nullptr);
+    double totalTrainTime = 0.0;
+    std::vector<double> epoch_times;
+    for (int cycle = 0; cycle < FLAGS_num_epochs; cycle++) {
+      auto time_start = std::chrono::steady_clock::now();
+      tp->cycle();
+      auto time_end = std::chrono::steady_clock::now();
+      std::chrono::duration<double, std::milli> time_ms = time_end - time_start;
+      double elapsedTimeSec = (time_ms.count())/ 1e3;
+      totalTrainTime += elapsedTimeSec;
+
+      std::unique_ptr<ResultRecord> record(newEpochRecord(trial, cycle, elapsedTimeSec));
+      printLinearEpochStats<TaskT>(mat_train, mat_test, sharedTheta, cycle, elapsedTimeSec, record.get());
+      INSTRUMENT(instrument::printEpoch(cycle);)
+      if (FLAGS_perf_counters) {
+        perf::printEpoch(cycle, tp->getCounters());
+      }
+      if (record) {
+        submitEpochRecord(record.get(), *tp);
+      }
+      epoch_times.push_back(elapsedTimeSec);
+
+      // Workers are waiting on the barrier, so the model is consistent here.
+      if (checkpointer && (checkpointer->shouldCheckpoint(cycle) || cycle == FLAGS_num_epochs - 1)) {
+        checkpointer->submit(snapshotLinearModel(cycle, sharedTheta, params));
+      }
+    }
+    tp->stop();
+
+    double const testError = TaskT::error(sharedTheta, mat_test->blocks_);
+    printf("num_threads,avg_train_time,test_%s\n", TaskT::errorName());
+    printf(">>>\n%d,%f,%f\n",
+           (int)FLAGS_threads,
+           totalTrainTime / FLAGS_num_epochs,
+           testError);
+    if (results_writer) {
+      ResultRecord record("trial");
+      record.add("trial", trial)
+        .add("threads", FLAGS_threads)
+        .add("mean_epoch_time", totalTrainTime / FLAGS_num_epochs)
+        .add("train_time", totalTrainTime)
+        .add(std::string("test_") + TaskT::errorName(), testError);
+      results_writer->submit(record);
+    }
+
+    return epoch_times;
+  }
+
+  /**
+   * Trains a linear model (SVM, LR, LS) with Hogwild over the sparse training blocks.
+   * @return A vector of the epoch times.
+   */
+  template<class TaskT>
+  std::vector<double> trainLinearModel(int trial,
+                                       Matrix *mat_train,
+                                       Matrix *mat_test,
+                                       partitioning::Placement const & placement) {
+    std::unique_ptr<typename TaskT::Params> params(
+      defaultParams(mat_train, static_cast<TaskT const *>(nullptr)));
+    fvector sharedTheta = newLinearModel(mat_train->numColumns_);
+    if (!FLAGS_warm_start.empty()) {
+      warmStartLinearModel(FLAGS_warm_start, &sharedTheta, params.get());
+    }
+
+    std::unique_ptr<CheckpointWriter> checkpointer;
+    if (!FLAGS_checkpoint_file.empty()) {
+      checkpointer.reset(new CheckpointWriter(FLAGS_checkpoint_file, FLAGS_checkpoint_interval));
+    }
 
     // Arguments to the thread pool.
     std::vector<void*> threadStates;
@@ -196,19 +481,24 @@ namespace obamadb {
     // Roughly allocates work.
     std::vector<std::unique_ptr<DataView>> data_views;
 
-    allocateBlocks(FLAGS_threads, mat_train->blocks_, data_views);
+    allocateBlocks(placement, data_views);
     // Create tasks
     auto update_fn = [](int tid, void* state) {
-      SVMTask* task = reinterpret_cast<SVMTask*>(state);
+      TaskT* task = reinterpret_cast<TaskT*>(state);
       task->execute(tid, nullptr);
     };
-    std::vector<std::unique_ptr<SVMTask>> tasks(FLAGS_threads);
+    std::vector<std::unique_ptr<TaskT>> tasks(FLAGS_threads);
     for (int i = 0; i < tasks.size(); i++) {
-      tasks[i].reset(new SVMTask(data_views[i].release(), &sharedTheta, svm_params));
+      tasks[i].reset(new TaskT(data_views[i].release(), &sharedTheta, params.get()));
       threadStates.push_back(tasks[i].get());
       threadFns.push_back(update_fn);
     }
 
+    INSTRUMENT(
+      instrument::WriteTracker tracker(FLAGS_threads, FLAGS_instrument_sample_period);
+      tracker.addRegion(sharedTheta.values_, sizeof(num_t) * sharedTheta.dimension_);
+      instrument::setTracker(&tracker);)
+
     ThreadPool tp(threadFns, threadStates);
 
     // If we are observing convergence, the thread pool must be referenced.
@@ -218,28 +508,8 @@ namespace obamadb {
 
     tp.begin();
 
-    VPRINT("epoch, train_time, train_fraction_misclassified, train_RMS_loss, test_fraction_misclassified, test_RMS_loss\n");
-    printSVMEpochStats(mat_train, mat_test, sharedTheta, -1, -1);
-    double totalTrainTime = 0.0;
-    std::vector<double> epoch_times;
-    for (int cycle = 0; cycle < FLAGS_num_epochs; cycle++) {
-      auto time_start = std::chrono::steady_clock::now();
-      tp.cycle();
-      auto time_end = std::chrono::steady_clock::now();
-      std::chrono::duration<double, std::milli> time_ms = time_end - time_start;
-      double elapsedTimeSec = (time_ms.count())/ 1e3;
-      totalTrainTime += elapsedTimeSec;
-
-      printSVMEpochStats(mat_train, mat_test, sharedTheta, cycle, elapsedTimeSec);
-      epoch_times.push_back(elapsedTimeSec);
-    }
-    tp.stop();
-
-    printf("num_threads,avg_train_time,frac_mispredicted_test\n");
-    printf(">>>\n%d,%f,%f\n",
-           (int)FLAGS_threads,
-           totalTrainTime / FLAGS_num_epochs,
-           SVMTask::fractionMisclassified(sharedTheta, mat_test->blocks_));
+    std::vector<double> epoch_times =
+      runLinearEpochs<TaskT>(trial, &tp, mat_train, mat_test, sharedTheta, params.get(), checkpointer.get());
 
     if (FLAGS_measure_convergence) {
       printf("Convergence Info (%d measures)\n", (int)observer->observedModels_.size());
@@ -250,44 +520,168 @@ namespace obamadb {
         printf("%d,%llu,%.4f,%.4f\n",
                (int)FLAGS_threads,
                timeObs,
-               SVMTask::rmsErrorLoss(thetaObs, mat_test->blocks_),
-               SVMTask::fractionMisclassified(thetaObs, mat_test->blocks_));
+               TaskT::loss(thetaObs, mat_test->blocks_),
+               TaskT::error(thetaObs, mat_test->blocks_));
       }
     }
     return epoch_times;
   }
 
-  void runSvmExperiment() {
-    std::unique_ptr<Matrix> mat_train;
-    std::unique_ptr<Matrix> mat_test;
+  /**
+   * Trains the SVM with each thread owning a range of the features. See ColumnPartitionedSVMTask.
+   * @return A vector of the epoch times.
+   */
+  std::vector<double> trainColumnPartitionedSVM(int trial,
+                                                Matrix *mat_train,
+                                                Matrix *mat_test) {
+    CHECK(!FLAGS_measure_convergence) << "measure_convergence needs svm_partition=row";
+    std::unique_ptr<SVMParams> params(defaultParams(mat_train, static_cast<SVMTask const *>(nullptr)));
+    fvector sharedTheta = newLinearModel(mat_train->numColumns_);
+    if (!FLAGS_warm_start.empty()) {
+      warmStartLinearModel(FLAGS_warm_start, &sharedTheta, params.get());
+    }
 
+    std::unique_ptr<CheckpointWriter> checkpointer;
+    if (!FLAGS_checkpoint_file.empty()) {
+      checkpointer.reset(new CheckpointWriter(FLAGS_checkpoint_file, FLAGS_checkpoint_interval));
+    }
+
+    ColumnPartitionedSVMTask task(mat_train, &sharedTheta, params.get(), FLAGS_threads, FLAGS_svm_batch_size);
+    if (FLAGS_verbose) {
+      printf("Column ranges:");
+      for (int column : task.columnBounds()) {
+        printf(" %d", column);
+      }
+      printf("\n");
+    }
+    auto update_fn = [](int tid, void* state) {
+      reinterpret_cast<ColumnPartitionedSVMTask*>(state)->execute(tid, nullptr);
+    };
+    INSTRUMENT(
+      instrument::WriteTracker tracker(FLAGS_threads, FLAGS_instrument_sample_period);
+      tracker.addRegion(sharedTheta.values_, sizeof(num_t) * sharedTheta.dimension_);
+      instrument::setTracker(&tracker);)
+
+    ThreadPool tp(update_fn, &task, FLAGS_threads);
+    tp.begin();
+
+    return runLinearEpochs<SVMTask>(trial, &tp, mat_train, mat_test, sharedTheta, params.get(), checkpointer.get());
+  }
+
+  std::vector<double> trainLinearModel(int trial,
+                                       Matrix *mat_train,
+                                       Matrix *mat_test,
+                                       partitioning::Placement const & placement) {
+    if (FLAGS_algorithm.compare("svm") == 0 && FLAGS_svm_partition.compare("column") == 0) {
+      return trainColumnPartitionedSVM(trial, mat_train, mat_test);
+    } else if (FLAGS_algorithm.compare("lr") == 0) {
+      return trainLinearModel<LRTask>(trial, mat_train, mat_test, placement);
+    } else if (FLAGS_algorithm.compare("ls") == 0) {
+      return trainLinearModel<LSTask>(trial, mat_train, mat_test, placement);
+    }
+    return trainLinearModel<SVMTask>(trial, mat_train, mat_test, placement);
+  }
+
+  /**
+   * @return How the row labels of data files are read for a linear algorithm. Least squares
+   *    fits real valued targets, the others (-1,1) classes.
+   */
+  IO::LabelType labelTypeFor(std::string const & algorithm) {
+    return algorithm.compare("ls") == 0 ? IO::LabelType::kTarget : IO::LabelType::kClass;
+  }
+
+  /**
+   * Loads the train and test files. Without a test file, a sample of the train file is used.
+   * @param labels How the row labels are read.
+   */
+  void loadLinearData(IO::LabelType labels, std::unique_ptr<Matrix> * mat_train, std::unique_ptr<Matrix> * mat_test) {
+    if (FLAGS_memory_report) {
+      memory::beginPhase("load");
+    }
+    std::uint64_t const block_size = tuneBlockSize(IO::estimateBytes(FLAGS_train_file), FLAGS_threads);
+    VPRINTF("Block size: %llu bytes\n", static_cast<unsigned long long>(block_size));
     VPRINT("Reading input files...\n");
     VPRINTF("Loading: %s\n", FLAGS_train_file.c_str());
-    PRINT_TIMING({mat_train.reset(IO::load(FLAGS_train_file));});
-    VSTREAM(*mat_train);
+    PRINT_TIMING({
+      memory::SubsystemScope scope(memory::kTrainingData);
+      mat_train->reset(IO::load(FLAGS_train_file, FLAGS_threads, labels));
+    });
+    VSTREAM(**mat_train);
 
+    memory::SubsystemScope scope(memory::kTestData);
     if (FLAGS_test_file.size() == 0) {
       VPRINT("Test file not specified, using a sample of the train file\n");
-      mat_test.reset(mat_train->sample(0.2));
-      VSTREAM(*mat_test);
+      mat_test->reset((*mat_train)->sample(0.2));
+      VSTREAM(**mat_test);
     } else {
       VPRINTF("Loading: %s\n", FLAGS_test_file.c_str());
-      PRINT_TIMING({mat_test.reset(IO::load(FLAGS_test_file));});
-      VSTREAM(*mat_test);
+      PRINT_TIMING({mat_test->reset(IO::load(FLAGS_test_file, FLAGS_threads, labels));});
+      VSTREAM(**mat_test);
     }
-    CHECK_EQ(mat_test->numColumns_, mat_train->numColumns_)
+    CHECK_EQ((*mat_test)->numColumns_, (*mat_train)->numColumns_)
       << "Train and Test matrices had differing number of features.";
+    if (FLAGS_memory_report) {
+      memory::printPhase();
+    }
+  }
+
+  /**
+   * Restarts the memory peaks for a trial if memory_report is set.
+   */
+  void beginTrialMemoryPhase(int trial) {
+    if (FLAGS_memory_report) {
+      memory::beginPhase(("trial " + std::to_string(trial)).c_str());
+    }
+  }
+
+  /**
+   * Sleeps between trials if asked to.
+   */
+  void pauseBetweenTrials(int trial) {
+    if (FLAGS_trial_pause_ms > 0 && trial != FLAGS_num_trials - 1) {
+      usleep(FLAGS_trial_pause_ms * 1000);
+    }
+  }
+
+  /**
+   * Places the rows on threads, then trains num_trials models.
+   * @return The epoch times of all the trials.
+   */
+  std::vector<double> runLinearTrials(Matrix * mat_train, Matrix * mat_test) {
+    // Rows are placed on threads once, every trial trains over the same placement.
+    partitioning::Placement placement = partitioning::roundRobin(mat_train->blocks_, FLAGS_threads);
+    std::unique_ptr<Matrix> placed_train;
+    if (FLAGS_row_partition.compare("minhash") == 0) {
+      partitioning::ConflictStats const before = partitioning::measureConflicts(placement, mat_train->numColumns_);
+      PRINT_TIMING({placed_train.reset(partitioning::minHash(*mat_train, FLAGS_threads, FLAGS_threads, &placement));});
+      mat_train = placed_train.get();
+      partitioning::ConflictStats const after = partitioning::measureConflicts(placement, mat_train->numColumns_);
+      printf("row placement, shared_write_fraction, workers_per_line\n");
+      printf("block,%f,%f\nminhash,%f,%f\n",
+             before.shared_write_fraction, before.workers_per_line,
+             after.shared_write_fraction, after.workers_per_line);
+    } else if (FLAGS_verbose) {
+      partitioning::ConflictStats const stats = partitioning::measureConflicts(placement, mat_train->numColumns_);
+      printf("Row placement conflicts: %f of writes to shared lines, %f workers per line\n",
+             stats.shared_write_fraction, stats.workers_per_line);
+    }
 
     std::vector<double> all_epoch_times;
     for (int i = 0; i < FLAGS_num_trials; i++) {
-      std::vector<double> times = trainSVM(mat_train.get(), mat_test.get());
-      all_epoch_times.insert(all_epoch_times.end(), times.begin(), times.end());
-
-      if (FLAGS_num_trials != i -1) {
-        usleep(1e7);
+      // Every trial's workers get the same cores.
+      threading::resetCoreAffinities();
+      beginTrialMemoryPhase(i);
+      std::vector<double> times = trainLinearModel(i, mat_train, mat_test, placement);
+      if (FLAGS_memory_report) {
+        memory::printPhase();
       }
+      all_epoch_times.insert(all_epoch_times.end(), times.begin(), times.end());
+      pauseBetweenTrials(i);
     }
+    return all_epoch_times;
+  }
 
+  void printEpochTimeSummary(std::vector<double> const & all_epoch_times) {
     // calculate variance, etc.
     if (FLAGS_verbose) {
       printf("epoch runtimes:\n");
@@ -301,21 +695,88 @@ namespace obamadb {
            stats::variance<double>(all_epoch_times),
            stats::stddev<double>(all_epoch_times),
            stats::stderr<double>(all_epoch_times));
+    if (results_writer) {
+      submitSummaryRecord(all_epoch_times);
+    }
   }
 
-  void printMCEpochStats(int epoch, double time, MCState const * state, UnorderedMatrix const * probe_mat) {
-    if (FLAGS_verbose) {
+  void runLinearExperiment() {
+    std::unique_ptr<Matrix> mat_train;
+    std::unique_ptr<Matrix> mat_test;
+    loadLinearData(labelTypeFor(FLAGS_algorithm), &mat_train, &mat_test);
+    printEpochTimeSummary(runLinearTrials(mat_train.get(), mat_test.get()));
+  }
+
+  void printMCEpochStats(int epoch,
+                         double time,
+                         MCState const * state,
+                         UnorderedMatrix const * probe_mat,
+                         ResultRecord * record) {
+    if (FLAGS_verbose || record != nullptr) {
+      trace::Scope scope("evaluate", "eval");
       double rmse = MCTask::rmse(state, probe_mat);
-      printf("%d,%.6f,%.4f\n",epoch, time, rmse);
+      if (record != nullptr) {
+        record->add("probe_rmse", rmse);
+      }
+      VPRINTF("%d,%.6f,%.4f\n",epoch, time, rmse);
     }
   }
 
-  std::vector<double> trainMC(const UnorderedMatrix* train_matrix,
-                              const UnorderedMatrix* probe_matrix) {
+  /**
+   * MC checkpoints hold the L and R factors followed by the global mean and current step size.
+   * @return Caller-owned snapshot.
+   */
+  ModelSnapshot* snapshotMCModel(int epoch, MCState const * state) {
+    ModelSnapshot* snapshot = new ModelSnapshot(epoch);
+    snapshot->add(*state->mat_l);
+    snapshot->add(*state->mat_r);
+    snapshot->add(std::vector<num_t>({static_cast<num_t>(state->mean), state->step_size}));
+    return snapshot;
+  }
+
+  void warmStartMCModel(std::string const & file_name, MCState * state) {
+    std::unique_ptr<ModelSnapshot> snapshot(checkpoint::load(file_name));
+    CHECK_EQ(3, snapshot->records.size()) << file_name << " is not a matrix completion checkpoint.";
+    checkpoint::restore(snapshot->records[0], state->mat_l.get());
+    checkpoint::restore(snapshot->records[1], state->mat_r.get());
+    state->mean = snapshot->records[2].values[0];
+    state->step_size = snapshot->records[2].values[1];
+    VPRINTF("Warm start from %s (epoch %d)\n", file_name.c_str(), snapshot->epoch);
+  }
+
+  /**
+   * Writes the top K items for every user of an MC model to the topk_file.
+   */
+  void recommendTopK(DenseDataBlock<num_t> const * mat_l, DenseDataBlock<num_t> const * mat_r, double mean) {
+    std::unique_ptr<TopKRecommender> recommender;
+    std::vector<Recommendation> recommendations;
+    PRINT_TIMING({
+      recommender.reset(new TopKRecommender(mat_l, mat_r, mean, FLAGS_topk, FLAGS_topk_prune));
+      recommendations = recommender->recommendAll(FLAGS_threads);
+    });
+    recommender->write(FLAGS_topk_file, recommendations);
+    VPRINTF("Wrote top %d items for %d users to %s\n",
+            recommender->k(), recommender->numUsers(), FLAGS_topk_file.c_str());
+  }
+
+  std::vector<double> trainMC(int trial,
+                              const UnorderedMatrix* train_matrix,
+                              const UnorderedMatrix* probe_matrix,
+                              std::shared_ptr<MCStatistics const> statistics) {
     int const rank = FLAGS_rank;
-    MCState* mcstate = new MCState(train_matrix, rank); // TODO: this is a memory leak which
-		// fixes a mysterious memory corruption bug on ubuntu systems. It should be a smart pointer
-		// and also, there should be no memory corruption
+    std::unique_ptr<MCState> mcstate_ptr;
+    PRINT_TIMING({
+      memory::SubsystemScope scope(memory::kModel);
+      mcstate_ptr.reset(new MCState(train_matrix, statistics, rank, FLAGS_threads));
+    });
+    MCState* mcstate = mcstate_ptr.get();
+    if (!FLAGS_warm_start.empty()) {
+      warmStartMCModel(FLAGS_warm_start, mcstate);
+    }
+    std::unique_ptr<CheckpointWriter> checkpointer;
+    if (!FLAGS_checkpoint_file.empty()) {
+      checkpointer.reset(new CheckpointWriter(FLAGS_checkpoint_file, FLAGS_checkpoint_interval));
+    }
     if (FLAGS_verbose) {
       printf("Model matrix properties (L,R):\n");
       std::cout << *mcstate->mat_l << std::endl;
@@ -336,11 +797,17 @@ namespace obamadb {
       threadFns.push_back(update_fn);
     }
 
+    INSTRUMENT(
+      instrument::WriteTracker tracker(FLAGS_threads, FLAGS_instrument_sample_period);
+      tracker.addRegion(mcstate->mat_l->store_, mcstate->mat_l->block_size_bytes_);
+      tracker.addRegion(mcstate->mat_r->store_, mcstate->mat_r->block_size_bytes_);
+      instrument::setTracker(&tracker);)
+
     ThreadPool tp(threadFns, tp_states);
     tp.begin();
 
     VPRINT("epoch, train_time, probe_RMS_loss\n");
-    printMCEpochStats(-1, -1, mcstate, probe_matrix);
+    printMCEpochStats(-1, -1, mcstate, probe_matrix, nullptr);
     double totalTrainTime = 0.0;
     std::vector<double> epoch_times;
     for (int cycle = 0; cycle < FLAGS_num_epochs; cycle++) {
@@ -351,52 +818,288 @@ namespace obamadb {
       double elapsedTimeSec = (time_ms.count())/ 1e3;
       totalTrainTime += elapsedTimeSec;
 
-      printMCEpochStats(cycle, elapsedTimeSec, mcstate, probe_matrix);
+      std::unique_ptr<ResultRecord> record(newEpochRecord(trial, cycle, elapsedTimeSec));
+      printMCEpochStats(cycle, elapsedTimeSec, mcstate, probe_matrix, record.get());
+      INSTRUMENT(instrument::printEpoch(cycle);)
+      if (FLAGS_perf_counters) {
+        perf::printEpoch(cycle, tp.getCounters());
+      }
+      if (record) {
+        submitEpochRecord(record.get(), tp);
+      }
       epoch_times.push_back(elapsedTimeSec);
+
+      if (checkpointer && (checkpointer->shouldCheckpoint(cycle) || cycle == FLAGS_num_epochs - 1)) {
+        checkpointer->submit(snapshotMCModel(cycle, mcstate));
+      }
     }
     tp.stop();
+
+    if (results_writer) {
+      ResultRecord record("trial");
+      record.add("trial", trial)
+        .add("threads", FLAGS_threads)
+        .add("mean_epoch_time", totalTrainTime / FLAGS_num_epochs)
+        .add("train_time", totalTrainTime)
+        .add("probe_rmse", MCTask::rmse(mcstate, probe_matrix));
+      results_writer->submit(record);
+    }
+
+    if (FLAGS_topk > 0) {
+      recommendTopK(mcstate->mat_l.get(), mcstate->mat_r.get(), mcstate->mean);
+    }
     return epoch_times;
   }
 
-  void trainMC() {
-    std::unique_ptr<UnorderedMatrix> train_matrix;
-    std::unique_ptr<UnorderedMatrix> probe_matrix;
-
+  /**
+   * Loads the train and probe files and the statistics of the training entries, which every
+   * trial shares.
+   */
+  void loadMCData(std::unique_ptr<UnorderedMatrix> * train_matrix,
+                  std::unique_ptr<UnorderedMatrix> * probe_matrix,
+                  std::shared_ptr<MCStatistics const> * statistics) {
+    if (FLAGS_memory_report) {
+      memory::beginPhase("load");
+    }
     VPRINT("Reading input files...\n");
     VPRINTF("Loading: %s\n", FLAGS_train_file.c_str());
-    PRINT_TIMING({train_matrix.reset(IO::loadUnorderedMatrix(FLAGS_train_file));});
-    VSTREAM(*train_matrix);
+    memory::SubsystemScope scope(memory::kTrainingData);
+    PRINT_TIMING({train_matrix->reset(IO::loadUnorderedMatrix(FLAGS_train_file, FLAGS_threads));});
+    VSTREAM(**train_matrix);
+
+    if (FLAGS_mc_order.compare("file") != 0) {
+      EntryOrder const order = FLAGS_mc_order.compare("row") == 0 ? EntryOrder::kRowMajor : EntryOrder::kHilbert;
+      VPRINTF("Sorting training entries in %s order\n", FLAGS_mc_order.c_str());
+      PRINT_TIMING({(*train_matrix)->reorder(order, FLAGS_threads);});
+    }
 
     VPRINTF("Loading: %s\n", FLAGS_test_file.c_str());
-    PRINT_TIMING({probe_matrix.reset(IO::loadUnorderedMatrix(FLAGS_test_file));});
-    VSTREAM(*probe_matrix);
-
-    CHECK_LE(probe_matrix->numColumns(), train_matrix->numColumns());
-    CHECK_LE(probe_matrix->numRows(), train_matrix->numRows());
+    PRINT_TIMING({
+      memory::SubsystemScope probe_scope(memory::kTestData);
+      probe_matrix->reset(IO::loadUnorderedMatrix(FLAGS_test_file, FLAGS_threads));
+    });
+    VSTREAM(**probe_matrix);
+
+    CHECK_LE((*probe_matrix)->numColumns(), (*train_matrix)->numColumns());
+    CHECK_LE((*probe_matrix)->numRows(), (*train_matrix)->numRows());
+
+    // Degrees and mean only depend on the data, so every trial shares them.
+    PRINT_TIMING({statistics->reset(new MCStatistics(train_matrix->get(), FLAGS_threads));});
+    if (FLAGS_memory_report) {
+      memory::printPhase();
+    }
+  }
 
+  /**
+   * @return The epoch times of num_trials MC models.
+   */
+  std::vector<double> runMCTrials(UnorderedMatrix const * train_matrix,
+                                  UnorderedMatrix const * probe_matrix,
+                                  std::shared_ptr<MCStatistics const> statistics) {
     std::vector<double> all_epoch_times;
     for (int i = 0; i < FLAGS_num_trials; i++) {
-      std::vector<double> times = trainMC(train_matrix.get(), probe_matrix.get());
+      threading::resetCoreAffinities();
+      beginTrialMemoryPhase(i);
+      std::vector<double> times = trainMC(i, train_matrix, probe_matrix, statistics);
+      if (FLAGS_memory_report) {
+        memory::printPhase();
+      }
       all_epoch_times.insert(all_epoch_times.end(), times.begin(), times.end());
+      pauseBetweenTrials(i);
+    }
+    return all_epoch_times;
+  }
+
+  void trainMC() {
+    std::unique_ptr<UnorderedMatrix> train_matrix;
+    std::unique_ptr<UnorderedMatrix> probe_matrix;
+    std::shared_ptr<MCStatistics const> statistics;
+    loadMCData(&train_matrix, &probe_matrix, &statistics);
+    printEpochTimeSummary(runMCTrials(train_matrix.get(), probe_matrix.get(), statistics));
+  }
+
+  /**
+   * Binds the calling thread to the first of the core_affinities, or core 0 if there are none.
+   */
+  void bindMainThread() {
+    std::vector<int> affinities = GetIntList(FLAGS_core_affinities);
+    if (affinities[0] != -1) {
+      threading::setCoreAffinity(affinities[0]);
+    } else {
+      LOG(INFO) << "Main thread affinitized to core 0";
+      threading::setCoreAffinity(0);
+    }
+  }
 
-      if (FLAGS_num_trials != i - 1) {
-        usleep(1e7);
+  /**
+   * @return The pieces of a list like "a;b;c".
+   */
+  std::vector<std::string> splitList(std::string const & list, char delimiter) {
+    std::vector<std::string> pieces;
+    std::size_t begin = 0;
+    while (begin <= list.size()) {
+      std::size_t end = list.find(delimiter, begin);
+      if (end == std::string::npos) {
+        end = list.size();
       }
+      pieces.push_back(list.substr(begin, end - begin));
+      begin = end + 1;
     }
+    return pieces;
+  }
 
-    // calculate variance, etc.
-    if (FLAGS_verbose) {
-      printf("epoch runtimes:\n");
-      for (double time : all_epoch_times) {
-        printf("%f\n", time);
+  /**
+   * Training over the same data with one algorithm, set of cores and thread count.
+   */
+  struct SweepPoint {
+    std::string algorithm;
+    std::string core_affinities;
+    int threads;
+    std::vector<double> epoch_times;
+  };
+
+  /**
+   * Loads the data once, then trains every combination of the sweep flags and prints the
+   * epoch time, speedup and parallel efficiency of each. Speedups are relative to the first of
+   * the sweep_threads with the same algorithm and cores.
+   */
+  void runSweep() {
+    std::vector<int> const thread_counts = GetIntList(FLAGS_sweep_threads);
+    for (int threads : thread_counts) {
+      CHECK(ValidateThreads("sweep_threads", threads));
+    }
+    std::vector<std::string> const algorithms =
+      FLAGS_sweep_algorithms.empty() ? std::vector<std::string>({FLAGS_algorithm}) : splitList(FLAGS_sweep_algorithms, ',');
+    std::vector<std::string> const core_affinities =
+      FLAGS_sweep_core_affinities.empty()
+      ? std::vector<std::string>({FLAGS_core_affinities}) : splitList(FLAGS_sweep_core_affinities, ';');
+    bool const mc = algorithms[0].compare("mc") == 0;
+    for (std::string const & algorithm : algorithms) {
+      CHECK(ValidateAlgorithm("sweep_algorithms", algorithm));
+      CHECK_EQ(mc, algorithm.compare("mc") == 0) << "sweep_algorithms cannot mix mc with the linear algorithms.";
+      CHECK(labelTypeFor(algorithm) == labelTypeFor(algorithms[0]))
+        << "sweep_algorithms cannot mix ls, which reads regression targets, with the classifiers.";
+    }
+    CHECK(!FLAGS_measure_convergence) << "measure_convergence is not supported in sweep mode.";
+
+    std::unique_ptr<Matrix> mat_train;
+    std::unique_ptr<Matrix> mat_test;
+    std::unique_ptr<UnorderedMatrix> train_matrix;
+    std::unique_ptr<UnorderedMatrix> probe_matrix;
+    std::shared_ptr<MCStatistics const> statistics;
+    if (mc) {
+      loadMCData(&train_matrix, &probe_matrix, &statistics);
+    } else {
+      // Blocks are sized for the most threads, so every point gets enough blocks per thread.
+      FLAGS_threads = *std::max_element(thread_counts.begin(), thread_counts.end());
+      loadLinearData(labelTypeFor(algorithms[0]), &mat_train, &mat_test);
+    }
+
+    // The rest of the program reads its configuration from the flags.
+    std::vector<SweepPoint> points;
+    for (std::string const & algorithm : algorithms) {
+      for (std::string const & cores : core_affinities) {
+        for (int threads : thread_counts) {
+          FLAGS_algorithm = algorithm;
+          FLAGS_core_affinities = cores;
+          FLAGS_threads = threads;
+          bindMainThread();
+          if (results_writer) {
+            submitConfigRecord();
+          }
+          VPRINTF("Sweep: %s, cores %s, %d threads\n", algorithm.c_str(), cores.c_str(), threads);
+
+          SweepPoint point;
+          point.algorithm = algorithm;
+          point.core_affinities = cores;
+          point.threads = threads;
+          point.epoch_times = mc
+                              ? runMCTrials(train_matrix.get(), probe_matrix.get(), statistics)
+                              : runLinearTrials(mat_train.get(), mat_test.get());
+          points.push_back(point);
+        }
       }
     }
 
-    printf("epoch runtime summary:\nmean,variance,stddev,stderr\n%f,%f,%f,%f\n",
-           stats::mean<double>(all_epoch_times),
-           stats::variance<double>(all_epoch_times),
-           stats::stddev<double>(all_epoch_times),
-           stats::stderr<double>(all_epoch_times));
+    printf("algorithm,core_affinities,threads,mean_epoch_time,ci95,speedup,efficiency\n");
+    for (std::size_t i = 0; i < points.size(); i++) {
+      SweepPoint const & point = points[i];
+      SweepPoint const & baseline = points[i - i % thread_counts.size()];
+      double const mean = stats::mean<double>(point.epoch_times);
+      // Normal approximation of a 95% confidence interval of the mean.
+      double const ci95 = 1.96 * stats::stderr<double>(point.epoch_times);
+      double const speedup = stats::mean<double>(baseline.epoch_times) / mean;
+      double const efficiency = speedup * baseline.threads / point.threads;
+      printf("%s,\"%s\",%d,%f,%f,%.3f,%.3f\n",
+             point.algorithm.c_str(), point.core_affinities.c_str(), point.threads, mean, ci95, speedup, efficiency);
+      if (results_writer) {
+        ResultRecord record("sweep");
+        record.add("algorithm", point.algorithm)
+          .add("core_affinities", point.core_affinities)
+          .add("threads", point.threads)
+          .add("mean_epoch_time", mean)
+          .add("ci95_epoch_time", ci95)
+          .add("speedup", speedup)
+          .add("efficiency", efficiency);
+        results_writer->submit(record);
+      }
+    }
+  }
+
+  MLAlgorithm algorithmFromFlag() {
+    if (FLAGS_algorithm.compare("mc") == 0) {
+      return MLAlgorithm::kMC;
+    } else if (FLAGS_algorithm.compare("lr") == 0) {
+      return MLAlgorithm::kLR;
+    } else if (FLAGS_algorithm.compare("ls") == 0) {
+      return MLAlgorithm::kLS;
+    }
+    return MLAlgorithm::kSVM;
+  }
+
+  /**
+   * Applies a checkpointed model to the test file and writes out the predictions.
+   */
+  void runPrediction() {
+    CHECK(!FLAGS_model_file.empty()) << "Predict mode requires a model_file.";
+
+    std::unique_ptr<ModelSnapshot> snapshot(checkpoint::load(FLAGS_model_file));
+    MLAlgorithm const algorithm = algorithmFromFlag();
+    ScoreStats stats;
+    if (algorithm == MLAlgorithm::kMC) {
+      CHECK_EQ(3, snapshot->records.size()) << FLAGS_model_file << " is not a matrix completion checkpoint.";
+      std::unique_ptr<DenseDataBlock<num_t>> mat_l(checkpoint::toDenseDataBlock(snapshot->records[0]));
+      std::unique_ptr<DenseDataBlock<num_t>> mat_r(checkpoint::toDenseDataBlock(snapshot->records[1]));
+      if (FLAGS_topk > 0) {
+        recommendTopK(mat_l.get(), mat_r.get(), snapshot->records[2].values[0]);
+        return;
+      }
+      CHECK(!FLAGS_test_file.empty()) << "Predict mode requires a test_file to score.";
+      MCScorer scorer(mat_l.get(), mat_r.get(), snapshot->records[2].values[0], FLAGS_threads);
+      stats = scorer.score(FLAGS_test_file, FLAGS_predictions_file);
+    } else {
+      CHECK(!FLAGS_test_file.empty()) << "Predict mode requires a test_file to score.";
+      CHECK_EQ(2, snapshot->records.size()) << FLAGS_model_file << " is not a linear model checkpoint.";
+      std::unique_ptr<fvector> theta(checkpoint::toFVector(snapshot->records[0]));
+      std::uint64_t const block_size = tuneBlockSize(IO::estimateBytes(FLAGS_test_file), FLAGS_threads);
+      VPRINTF("Block size: %llu bytes\n", static_cast<unsigned long long>(block_size));
+      LinearScorer scorer(theta.get(), algorithm, FLAGS_threads);
+      stats = scorer.score(FLAGS_test_file, FLAGS_predictions_file);
+    }
+
+    printf("num_threads,rows,time,rows_per_sec\n%d,%llu,%f,%f\n",
+           (int)FLAGS_threads,
+           (unsigned long long) stats.rows,
+           stats.seconds,
+           stats.rowsPerSecond());
+    if (results_writer) {
+      ResultRecord record("prediction");
+      record.add("threads", FLAGS_threads)
+        .add("rows", static_cast<std::int64_t>(stats.rows))
+        .add("time", stats.seconds)
+        .add("rows_per_sec", stats.rowsPerSecond());
+      results_writer->submit(record);
+    }
   }
 
   int main(int argc, char** argv) {
@@ -404,17 +1107,28 @@ namespace obamadb {
     ::gflags::SetUsageMessage(std::string(argv[0]) + " -help");
     ::gflags::SetVersionString("0.0");
     ::gflags::ParseCommandLineFlags(&argc, &argv, true);
-
-    std::vector<int> affinities = GetIntList(FLAGS_core_affinities);
-    if (affinities[0] != -1) {
-      threading::setCoreAffinity(affinities[0]);
-    } else {
-      LOG(INFO) << "Main thread affinitized to core 0";
-      threading::setCoreAffinity(0);
+    rng::setSeed(FLAGS_seed);
+    if (!FLAGS_trace_file.empty()) {
+      trace::start();
+      trace::setThreadName("main");
+    }
+    if (!FLAGS_results_file.empty()) {
+      results_writer.reset(new ResultsWriter(FLAGS_results_file));
+      if (FLAGS_mode.compare("sweep") != 0) {
+        submitConfigRecord();
+      }
     }
 
-    if (FLAGS_algorithm.compare("svm") == 0) {
-      runSvmExperiment();
+    bindMainThread();
+
+    if (FLAGS_mode.compare("predict") == 0) {
+      runPrediction();
+    } else if (FLAGS_mode.compare("sweep") == 0) {
+      runSweep();
+    } else if (FLAGS_algorithm.compare("svm") == 0
+        || FLAGS_algorithm.compare("lr") == 0
+        || FLAGS_algorithm.compare("ls") == 0) {
+      runLinearExperiment();
     } else if (FLAGS_algorithm.compare("mc") == 0) {
       LOG_IF(WARNING, FLAGS_measure_convergence)
         << "Measure convergence not implemented for MC";
@@ -423,6 +1137,11 @@ namespace obamadb {
       LOG(FATAL) << "unknown training algorithm";
     }
 
+    // Waits for the pending records.
+    results_writer.reset();
+    if (trace::enabled()) {
+      trace::dump(FLAGS_trace_file);
+    }
     return 0;
   }
 } // namespace obamadb
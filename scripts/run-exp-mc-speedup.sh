@@ -1,21 +1,34 @@
 #!/bin/bash
 
 # used to test increasing model size's effect on HW!
+# Each model size is loaded once and swept over the thread counts by obamadb_main itself.
 set -e
-EXE=/fastdisk/obamadb/build/obamadb_main
-DAT=/fastdisk/obamadb/data/
+EXE=${EXE:-../build/obamadb_main}
+DAT=${DAT:-../data}
+THREADS=${THREADS:-1,2,4,8,10}
+CORES=${CORES:-0,1,2,3,4,5,6,7,8,9}
+
+# Appends the sweep records of a results file to the csv, prefixed with the model size.
+sweep_to_csv() {
+  python - "$1" "$2" >> results_mc_model_size.csv <<'PY'
+import csv, json, sys
+writer = csv.writer(sys.stdout, lineterminator='\n')
+for line in open(sys.argv[2]):
+    record = json.loads(line)
+    if record['type'] == 'sweep':
+        writer.writerow([sys.argv[1]] + [record[k] for k in
+            ['algorithm', 'core_affinities', 'threads', 'mean_epoch_time', 'ci95_epoch_time', 'speedup', 'efficiency']])
+PY
+}
 
 test_epoch() {
-  rm *.out
-  echo "" > results_mc_model_size.csv
+  rm -f *.out
+  echo "model_size,algorithm,core_affinities,threads,mean_epoch_time,ci95,speedup,efficiency" > results_mc_model_size.csv
   for model_size in 0 1 2
   do
-    for thread in 1 2 4 8 10
-    do
-    	FNAME=s$sparsity_t$thread.out
-    	$EXE -train_file $DAT/_synth_mc_d$model_size.train.tsv -test_file $DAT/_synth_mc_d$model_size.probe.tsv -threads $thread -num_epochs 20 -num_trials 5 -core_affinities=0,1,2,3,4,5,6,7,8,9 -verbose true -rank 12 -algorithm mc > $FNAME 
-    	echo $model_size,$thread,`tail -n 1 $FNAME` >> results_mc_model_size.csv
-	  done
+    FNAME=d$model_size.out
+    $EXE -mode sweep -train_file $DAT/_synth_mc_d$model_size.train.tsv -test_file $DAT/_synth_mc_d$model_size.probe.tsv -sweep_threads $THREADS -num_epochs 20 -num_trials 5 -core_affinities=$CORES -rank 12 -algorithm mc -results_file d$model_size.json > $FNAME
+    sweep_to_csv $model_size d$model_size.json
   done
 }
 
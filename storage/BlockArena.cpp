@@ -0,0 +1,200 @@
+#include "storage/BlockArena.h"
+
+#include "storage/HugePages.h"
+#include "storage/MemoryAccounting.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <map>
+#include <mutex>
+#include <sched.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace obamadb {
+
+  namespace arena {
+
+    namespace {
+      // The regions of a size class start at one block and double with each region mapped, up
+      // to this many blocks, so small matrices do not map or reserve much more than they need.
+      int const kMaxRegionBlocks = 64;
+
+      struct Region {
+        std::size_t bytes;
+        std::size_t block_bytes;
+        int node;
+        int used;
+        // Subsystem of each block handed out, to give the bytes back to on release.
+        std::vector<memory::Subsystem> owners;
+      };
+
+      // Blocks are only handed out by size and node, so the lists are keyed by both.
+      typedef std::pair<std::size_t, int> SizeClass;
+
+      std::mutex mutex;
+      std::map<char*, Region> regions;
+      std::map<SizeClass, std::vector<char*>> free_blocks;
+      // Regions mapped for each size class.
+      std::map<SizeClass, int> region_counts;
+      std::vector<int> cpu_nodes;
+
+      std::size_t pageRoundUp(std::size_t bytes) {
+        std::size_t const page = sysconf(_SC_PAGESIZE);
+        return ((bytes + page - 1) / page) * page;
+      }
+
+      /**
+       * @return The NUMA node of a cpu, from the nodeN entry of its sysfs directory, or 0.
+       */
+      int readNode(int cpu) {
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+        DIR* dir = opendir(path);
+        if (dir == nullptr) {
+          return 0;
+        }
+        int node = 0;
+        while (dirent* entry = readdir(dir)) {
+          if (sscanf(entry->d_name, "node%d", &node) == 1) {
+            break;
+          }
+        }
+        closedir(dir);
+        return node;
+      }
+
+      /**
+       * Call while holding the mutex.
+       * @return The NUMA node the calling thread runs on.
+       */
+      int currentNode() {
+#ifdef __linux__
+        int const cpu = sched_getcpu();
+        if (cpu < 0) {
+          return 0;
+        }
+        while (cpu_nodes.size() <= cpu) {
+          cpu_nodes.push_back(readNode(cpu_nodes.size()));
+        }
+        return cpu_nodes[cpu];
+#else
+        return 0;
+#endif
+      }
+
+      /**
+       * Call while holding the mutex. Maps a region for a size class and frees all its blocks.
+       */
+      void addRegion(SizeClass size_class) {
+        std::size_t const block_bytes = size_class.first;
+        int & region_count = region_counts[size_class];
+        int const blocks = std::min(kMaxRegionBlocks, 1 << std::min(region_count, 6));
+        region_count++;
+        std::size_t const bytes = hugepages::roundUp(block_bytes * blocks);
+        char* base = static_cast<char*>(hugepages::map(bytes));
+        Region & region = regions[base];
+        region.bytes = bytes;
+        region.block_bytes = block_bytes;
+        region.node = size_class.second;
+        region.used = 0;
+        region.owners.resize(bytes / block_bytes, memory::kScratch);
+        // Handed out from the lowest address up.
+        std::vector<char*> & free_list = free_blocks[size_class];
+        for (int b = region.owners.size() - 1; b >= 0; b--) {
+          free_list.push_back(base + b * block_bytes);
+        }
+      }
+
+      /**
+       * Call while holding the mutex.
+       */
+      std::map<char*, Region>::iterator findRegion(char * block) {
+        auto it = regions.upper_bound(block);
+        CHECK(it != regions.begin()) << "Block was not allocated by the arena.";
+        --it;
+        CHECK_LT(block, it->first + it->second.bytes) << "Block was not allocated by the arena.";
+        return it;
+      }
+    }
+
+    void* allocate(std::size_t bytes) {
+      std::size_t const block_bytes = pageRoundUp(bytes);
+      memory::Subsystem const subsystem = memory::current();
+      char* block;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        SizeClass const size_class(block_bytes, currentNode());
+        if (free_blocks[size_class].empty()) {
+          addRegion(size_class);
+        }
+        std::vector<char*> & free_list = free_blocks[size_class];
+        block = free_list.back();
+        free_list.pop_back();
+        auto it = findRegion(block);
+        it->second.used++;
+        it->second.owners[(block - it->first) / block_bytes] = subsystem;
+      }
+      memory::add(subsystem, block_bytes);
+      return block;
+    }
+
+    void release(void * ptr) {
+      if (ptr == nullptr) {
+        return;
+      }
+      char* block = static_cast<char*>(ptr);
+      std::size_t block_bytes;
+      memory::Subsystem subsystem;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = findRegion(block);
+        char* base = it->first;
+        Region & region = it->second;
+        block_bytes = region.block_bytes;
+        subsystem = region.owners[(block - base) / block_bytes];
+        SizeClass const size_class(block_bytes, region.node);
+        std::vector<char*> & free_list = free_blocks[size_class];
+        if (--region.used > 0) {
+          free_list.push_back(block);
+        } else {
+          free_list.erase(std::remove_if(free_list.begin(), free_list.end(), [base, &region](char* free_block) {
+            return free_block >= base && free_block < base + region.bytes;
+          }), free_list.end());
+          hugepages::unmap(base, region.bytes);
+          regions.erase(it);
+          region_counts[size_class]--;
+        }
+      }
+      memory::add(subsystem, -static_cast<std::int64_t>(block_bytes));
+    }
+
+    std::size_t compactBytes(std::size_t block_bytes, std::size_t used_bytes) {
+      std::size_t const page = pageRoundUp(1);
+      std::size_t bytes = block_bytes;
+      while (bytes / 2 >= std::max(used_bytes, page)) {
+        bytes /= 2;
+      }
+      return bytes;
+    }
+
+    Stats stats() {
+      std::lock_guard<std::mutex> lock(mutex);
+      Stats stats = {0, 0, 0};
+      for (auto const & entry : regions) {
+        stats.regions++;
+        stats.mapped_bytes += entry.second.bytes;
+        stats.used_bytes += entry.second.used * entry.second.block_bytes;
+      }
+      return stats;
+    }
+
+  } // namespace arena
+
+} // namespace obamadb
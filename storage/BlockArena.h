@@ -0,0 +1,53 @@
+#ifndef OBAMADB_BLOCKARENA_H
+#define OBAMADB_BLOCKARENA_H
+
+#include <cstddef>
+
+namespace obamadb {
+
+  /**
+   * Carves the storage of data blocks out of large huge page backed regions instead of one heap
+   * allocation per block. Blocks of the same size which are made on the same NUMA node share
+   * regions, so a pass over a matrix touches few huge pages rather than many small ones, and a
+   * region is unmapped as soon as the last of its blocks is released, e.g. when its Matrix is
+   * deleted. Thread safe.
+   */
+  namespace arena {
+
+    /**
+     * @param bytes Size of the block's storage.
+     * @return Page aligned memory, counted against the current memory::Subsystem. The pages are
+     *    placed on the node of the thread which first writes them.
+     */
+    void* allocate(std::size_t bytes);
+
+    /**
+     * Returns a block's storage to the arena. Null is ignored.
+     */
+    void release(void * block);
+
+    /**
+     * @param block_bytes Size of a block's storage.
+     * @param used_bytes Bytes of it in use.
+     * @return The smallest of block_bytes halved any number of times, but at least a page, which
+     *    holds used_bytes. Compacted blocks which came from the same size class then share a few
+     *    smaller classes, and so regions, rather than each getting a class of its own.
+     */
+    std::size_t compactBytes(std::size_t block_bytes, std::size_t used_bytes);
+
+    struct Stats {
+      int regions;
+      std::size_t mapped_bytes;
+      std::size_t used_bytes;
+    };
+
+    /**
+     * @return The regions currently mapped and how much of them is handed out.
+     */
+    Stats stats();
+
+  } // namespace arena
+
+} // namespace obamadb
+
+#endif //OBAMADB_BLOCKARENA_H
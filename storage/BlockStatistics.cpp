@@ -0,0 +1,79 @@
+#include "storage/BlockStatistics.h"
+
+#include <algorithm>
+
+namespace obamadb {
+
+  BlockStatistics BlockStatistics::Of(SparseDataBlock<num_t> const & block) {
+    BlockStatistics statistics;
+    svector<num_t> row(0, nullptr);
+    for (int i = 0; i < block.getNumRows(); i++) {
+      block.getRowVectorFast(i, &row);
+      if (block.isDense()) {
+        statistics.addDenseRow(row);
+      } else {
+        statistics.addRow(row);
+      }
+    }
+    return statistics;
+  }
+
+  void BlockStatistics::addLabel(svector<num_t> const & row) {
+    num_rows++;
+    if (*row.class_ > 0) {
+      positive_labels++;
+    } else {
+      negative_labels++;
+    }
+  }
+
+  void BlockStatistics::addRow(svector<num_t> const & row) {
+    addLabel(row);
+
+    int const elements = row.numElements();
+    if (elements == 0) {
+      return;
+    }
+    if (nnz == 0) {
+      min_column = row.index_[0];
+      max_column = row.index_[0];
+      min_value = row.values_[0];
+      max_value = row.values_[0];
+    }
+    nnz += elements;
+    for (int j = 0; j < elements; j++) {
+      int const column = row.index_[j];
+      min_column = std::min(min_column, column);
+      max_column = std::max(max_column, column);
+      min_value = std::min(min_value, row.values_[j]);
+      max_value = std::max(max_value, row.values_[j]);
+      column_sketch.set(column % kSketchBits);
+    }
+  }
+
+  void BlockStatistics::addDenseRow(svector<num_t> const & row) {
+    addLabel(row);
+
+    int const elements = row.numElements();
+    if (elements == 0) {
+      return;
+    }
+    // The row covers columns 0 to elements - 1, as the sparse rows it was made of did.
+    min_column = 0;
+    max_column = std::max(max_column, row.index_[elements - 1]);
+    for (int j = 0; j < elements; j++) {
+      // Zeros were filled in, they are not elements.
+      if (row.values_[j] == 0) {
+        continue;
+      }
+      if (nnz++ == 0) {
+        min_value = row.values_[j];
+        max_value = row.values_[j];
+      }
+      min_value = std::min(min_value, row.values_[j]);
+      max_value = std::max(max_value, row.values_[j]);
+      column_sketch.set(row.index_[j] % kSketchBits);
+    }
+  }
+
+}  // namespace obamadb
@@ -0,0 +1,84 @@
+#ifndef OBAMADB_BLOCKSTATISTICS_H
+#define OBAMADB_BLOCKSTATISTICS_H
+
+#include "storage/exvector.h"
+#include "storage/SparseDataBlock.h"
+#include "storage/StorageConstants.h"
+
+#include <bitset>
+#include <cstdint>
+
+namespace obamadb {
+
+  /**
+   * A summary of the contents of one SparseDataBlock. Matrix keeps one per block so schedulers,
+   * samplers and evaluators can decide whether a block is worth touching, or how to balance
+   * blocks across threads, without reading its rows.
+   */
+  struct BlockStatistics {
+    // Number of bits in the column sketch.
+    static int const kSketchBits = 1024;
+
+    BlockStatistics()
+      : num_rows(0),
+        nnz(0),
+        min_column(-1),
+        max_column(-1),
+        min_value(0),
+        max_value(0),
+        positive_labels(0),
+        negative_labels(0),
+        column_sketch() { }
+
+    /**
+     * Computes the statistics of a whole block.
+     */
+    static BlockStatistics Of(SparseDataBlock<num_t> const & block);
+
+    /**
+     * Folds a row into the statistics. Used while a block is being filled.
+     */
+    void addRow(svector<num_t> const & row);
+
+    /**
+     * Folds a row of a dense block into the statistics. The zeros filled in for its unset
+     * columns are skipped, so the row counts like its sparse form.
+     */
+    void addDenseRow(svector<num_t> const & row);
+
+    /**
+     * @return False if no row of the block has column set. True means it may.
+     */
+    inline bool mayContainColumn(int column) const {
+      return column >= min_column && column <= max_column && column_sketch.test(column % kSketchBits);
+    }
+
+    /**
+     * @return An upper bound on the number of sketch bits two blocks share. Blocks which share
+     *    none touch disjoint columns.
+     */
+    inline int sharedSketchBits(BlockStatistics const & other) const {
+      return static_cast<int>((column_sketch & other.column_sketch).count());
+    }
+
+    std::uint32_t num_rows;
+    std::uint64_t nnz;
+    // -1 if the block has no non-zero elements.
+    int min_column;
+    int max_column;
+    // The range of the non-zero values. Both are 0 if there are none.
+    num_t min_value;
+    num_t max_value;
+    // Rows whose label is greater than zero, and the rest.
+    std::uint32_t positive_labels;
+    std::uint32_t negative_labels;
+    // Bit c % kSketchBits is set if some row has column c set.
+    std::bitset<kSketchBits> column_sketch;
+
+  private:
+    void addLabel(svector<num_t> const & row);
+  };
+
+}  // namespace obamadb
+
+#endif //OBAMADB_BLOCKSTATISTICS_H
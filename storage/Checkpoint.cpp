@@ -0,0 +1,197 @@
+#include "storage/Checkpoint.h"
+
+#include "storage/DenseDataBlock.h"
+#include "storage/Utils.h"
+
+#include <cstdio>
+#include <fstream>
+
+#include "glog/logging.h"
+
+namespace obamadb {
+
+  namespace {
+    std::uint32_t const kCheckpointMagic = 0x4244424f; // "OBDB"
+    std::uint32_t const kCheckpointVersion = 1;
+
+    template<class T>
+    void writeValue(std::ofstream & file, T const & value) {
+      file.write(reinterpret_cast<char const *>(&value), sizeof(T));
+    }
+
+    template<class T>
+    T readValue(std::ifstream & file) {
+      T value;
+      file.read(reinterpret_cast<char *>(&value), sizeof(T));
+      CHECK(file.good()) << "Checkpoint file is truncated.";
+      return value;
+    }
+  }
+
+  void ModelSnapshot::add(fvector const & vec) {
+    records.push_back(CheckpointRecord());
+    CheckpointRecord & record = records.back();
+    record.type = CheckpointRecordType::kFVector;
+    record.rows = 1;
+    record.columns = vec.dimension_;
+    record.values.assign(vec.values_, vec.values_ + vec.dimension_);
+  }
+
+  void ModelSnapshot::add(DenseDataBlock<num_t> const & block) {
+    records.push_back(CheckpointRecord());
+    CheckpointRecord & record = records.back();
+    record.type = CheckpointRecordType::kDenseDataBlock;
+    record.rows = block.getNumRows();
+    record.columns = block.getNumColumns();
+    record.values.resize(record.rows * record.columns);
+    dvector<num_t> row(0, nullptr);
+    for (int i = 0; i < record.rows; i++) {
+      block.getRowVectorFast(i, &row);
+      memcpy(&record.values[i * record.columns], row.values_, sizeof(num_t) * record.columns);
+    }
+  }
+
+  void ModelSnapshot::add(std::vector<num_t> const & scalars) {
+    records.push_back(CheckpointRecord());
+    CheckpointRecord & record = records.back();
+    record.type = CheckpointRecordType::kFVector;
+    record.rows = 1;
+    record.columns = scalars.size();
+    record.values = scalars;
+  }
+
+  namespace checkpoint {
+
+    void save(std::string const & file_name, ModelSnapshot const & snapshot) {
+      std::string const tmp_name = file_name + ".tmp";
+      std::ofstream file(tmp_name, std::ios::out | std::ios::binary | std::ios::trunc);
+      CHECK(file.is_open()) << "Unable to open " << tmp_name << " for output.";
+
+      writeValue<std::uint32_t>(file, kCheckpointMagic);
+      writeValue<std::uint32_t>(file, kCheckpointVersion);
+      writeValue<std::uint32_t>(file, snapshot.records.size());
+      writeValue<std::int32_t>(file, snapshot.epoch);
+      for (CheckpointRecord const & record : snapshot.records) {
+        DCHECK_EQ(record.rows * record.columns, record.values.size());
+        writeValue<std::uint32_t>(file, static_cast<std::uint32_t>(record.type));
+        writeValue<std::uint32_t>(file, 0);
+        writeValue<std::uint64_t>(file, record.rows);
+        writeValue<std::uint64_t>(file, record.columns);
+        file.write(reinterpret_cast<char const *>(record.values.data()), sizeof(num_t) * record.values.size());
+      }
+      file.close();
+      CHECK(!file.fail()) << "Error writing checkpoint " << tmp_name;
+      CHECK_EQ(0, std::rename(tmp_name.c_str(), file_name.c_str())) << "Unable to move checkpoint to " << file_name;
+    }
+
+    ModelSnapshot* load(std::string const & file_name) {
+      std::ifstream file(file_name, std::ios::in | std::ios::binary);
+      CHECK(file.is_open()) << "Unable to open checkpoint " << file_name;
+
+      CHECK_EQ(kCheckpointMagic, readValue<std::uint32_t>(file)) << file_name << " is not a checkpoint.";
+      CHECK_EQ(kCheckpointVersion, readValue<std::uint32_t>(file)) << "Unsupported checkpoint version.";
+      std::uint32_t const num_records = readValue<std::uint32_t>(file);
+      std::unique_ptr<ModelSnapshot> snapshot(new ModelSnapshot(readValue<std::int32_t>(file)));
+      for (int i = 0; i < num_records; i++) {
+        snapshot->records.push_back(CheckpointRecord());
+        CheckpointRecord & record = snapshot->records.back();
+        record.type = static_cast<CheckpointRecordType>(readValue<std::uint32_t>(file));
+        CHECK(record.type == CheckpointRecordType::kFVector || record.type == CheckpointRecordType::kDenseDataBlock)
+          << "Unknown checkpoint record type.";
+        readValue<std::uint32_t>(file);
+        record.rows = readValue<std::uint64_t>(file);
+        record.columns = readValue<std::uint64_t>(file);
+        record.values.resize(record.rows * record.columns);
+        file.read(reinterpret_cast<char *>(record.values.data()), sizeof(num_t) * record.values.size());
+        CHECK(file.good()) << "Checkpoint file is truncated.";
+      }
+      return snapshot.release();
+    }
+
+    void restore(CheckpointRecord const & record, fvector * vec) {
+      CHECK(record.type == CheckpointRecordType::kFVector) << "Checkpoint record is not a vector.";
+      CHECK_EQ(vec->dimension_, record.columns) << "Checkpointed model has a different dimension.";
+      memcpy(vec->values_, record.values.data(), sizeof(num_t) * record.values.size());
+    }
+
+    void restore(CheckpointRecord const & record, DenseDataBlock<num_t> * block) {
+      CHECK(record.type == CheckpointRecordType::kDenseDataBlock) << "Checkpoint record is not a block.";
+      CHECK_EQ(block->getNumRows(), record.rows) << "Checkpointed model has a different number of rows.";
+      CHECK_EQ(block->getNumColumns(), record.columns) << "Checkpointed model has a different rank.";
+      dvector<num_t> row(0, nullptr);
+      for (int i = 0; i < record.rows; i++) {
+        block->getRowVectorFast(i, &row);
+        memcpy(row.values_, &record.values[i * record.columns], sizeof(num_t) * record.columns);
+      }
+    }
+
+    fvector* toFVector(CheckpointRecord const & record) {
+      fvector* vec = new fvector(record.columns);
+      restore(record, vec);
+      return vec;
+    }
+
+    DenseDataBlock<num_t>* toDenseDataBlock(CheckpointRecord const & record) {
+      DenseDataBlock<num_t>* block = new DenseDataBlock<num_t>(record.rows, record.columns);
+      block->num_rows_ = record.rows;
+      restore(record, block);
+      block->finalize();
+      return block;
+    }
+
+  } // namespace checkpoint
+
+  CheckpointWriter::CheckpointWriter(std::string const & file_name, int interval)
+    : file_name_(file_name),
+      interval_(interval),
+      pending_(),
+      num_written_(0),
+      stop_(false),
+      mutex_(),
+      cond_(),
+      writer_() {
+    writer_ = std::thread(&CheckpointWriter::writerLoop, this);
+  }
+
+  CheckpointWriter::~CheckpointWriter() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cond_.notify_all();
+    writer_.join();
+  }
+
+  void CheckpointWriter::submit(ModelSnapshot * snapshot) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      LOG_IF(WARNING, pending_) << "Checkpoint of epoch " << pending_->epoch
+                                << " was not written before the next one arrived.";
+      pending_.reset(snapshot);
+    }
+    cond_.notify_all();
+  }
+
+  int CheckpointWriter::numWritten() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return num_written_;
+  }
+
+  void CheckpointWriter::writerLoop() {
+    while (true) {
+      std::unique_ptr<ModelSnapshot> snapshot;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this] { return stop_ || pending_; });
+        if (!pending_) {
+          return;
+        }
+        snapshot.reset(pending_.release());
+      }
+      checkpoint::save(file_name_, *snapshot);
+      std::lock_guard<std::mutex> lock(mutex_);
+      num_written_++;
+    }
+  }
+
+} // namespace obamadb
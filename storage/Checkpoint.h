@@ -0,0 +1,154 @@
+#ifndef OBAMADB_CHECKPOINT_H
+#define OBAMADB_CHECKPOINT_H
+
+#include "storage/DenseDataBlock.h"
+#include "storage/StorageConstants.h"
+#include "storage/Utils.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace obamadb {
+
+  enum class CheckpointRecordType : std::uint32_t {
+    kFVector = 1,
+    kDenseDataBlock = 2
+  };
+
+  /**
+   * A copy of one component of a model. For example, the theta of an SVM or one of the
+   * factor matrices of MC. An fvector is stored as a single row.
+   */
+  struct CheckpointRecord {
+    CheckpointRecordType type;
+    std::uint64_t rows;
+    std::uint64_t columns;
+    std::vector<num_t> values;
+  };
+
+  /**
+   * A consistent copy of a model. Taken between epochs so that it can be written out
+   * while the workers continue to modify the live model.
+   */
+  struct ModelSnapshot {
+    ModelSnapshot(int epoch)
+      : epoch(epoch),
+        records() {}
+
+    /**
+     * Appends a copy of the vector.
+     */
+    void add(fvector const & vec);
+
+    /**
+     * Appends a copy of the block's values. Classification slots are not copied.
+     */
+    void add(DenseDataBlock<num_t> const & block);
+
+    /**
+     * Appends a small vector of scalars, e.g. the current step size.
+     */
+    void add(std::vector<num_t> const & scalars);
+
+    int epoch;
+    std::vector<CheckpointRecord> records;
+  };
+
+  namespace checkpoint {
+
+    /**
+     * Writes the snapshot to a binary file. The snapshot is first written to a temporary
+     * file and then renamed so that a reader never sees a partially written checkpoint.
+     *
+     * Format:
+     *   [magic u32][version u32][num records u32][epoch i32]
+     *   per record: [type u32][reserved u32][rows u64][columns u64][rows * columns num_t]
+     */
+    void save(std::string const & file_name, ModelSnapshot const & snapshot);
+
+    /**
+     * Loads a checkpoint written by save.
+     * @return Caller-owned snapshot.
+     */
+    ModelSnapshot* load(std::string const & file_name);
+
+    /**
+     * Copies a record into an existing vector. The dimensions must match.
+     */
+    void restore(CheckpointRecord const & record, fvector * vec);
+
+    /**
+     * Copies a record into an existing block. The dimensions must match.
+     */
+    void restore(CheckpointRecord const & record, DenseDataBlock<num_t> * block);
+
+    /**
+     * @return A caller-owned vector with the record's values.
+     */
+    fvector* toFVector(CheckpointRecord const & record);
+
+    /**
+     * @return A caller-owned block with the record's dimensions and values.
+     */
+    DenseDataBlock<num_t>* toDenseDataBlock(CheckpointRecord const & record);
+
+  } // namespace checkpoint
+
+  /**
+   * Writes snapshots in a background thread so that training is only paused for the
+   * time it takes to copy the model. If a snapshot arrives while the previous one is still
+   * waiting to be written, only the newer one is kept.
+   */
+  class CheckpointWriter {
+  public:
+    /**
+     * @param file_name The checkpoint file. Overwritten on each write.
+     * @param interval Number of epochs between checkpoints.
+     */
+    CheckpointWriter(std::string const & file_name, int interval);
+
+    /**
+     * Blocks until the pending snapshot, if any, is written.
+     */
+    ~CheckpointWriter();
+
+    /**
+     * @return True if a snapshot should be taken after the given (0-indexed) epoch.
+     */
+    bool shouldCheckpoint(int epoch) const {
+      return interval_ > 0 && (epoch + 1) % interval_ == 0;
+    }
+
+    /**
+     * Queues the snapshot to be written. Takes ownership.
+     */
+    void submit(ModelSnapshot * snapshot);
+
+    /**
+     * @return Number of snapshots written so far.
+     */
+    int numWritten();
+
+  private:
+    void writerLoop();
+
+    std::string const file_name_;
+    int const interval_;
+    std::unique_ptr<ModelSnapshot> pending_;
+    int num_written_;
+    bool stop_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::thread writer_;
+
+    DISABLE_COPY_AND_ASSIGN(CheckpointWriter);
+  };
+
+} // namespace obamadb
+
+#endif //OBAMADB_CHECKPOINT_H
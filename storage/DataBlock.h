@@ -1,7 +1,10 @@
 #ifndef OBAMADB_DATABLOCK_H_
 #define OBAMADB_DATABLOCK_H_
 
+#include "storage/BlockArena.h"
 #include "storage/exvector.h"
+#include "storage/HugePages.h"
+#include "storage/MemoryAccounting.h"
 #include "storage/StorageConstants.h"
 #include "storage/Utils.h"
 
@@ -28,25 +31,27 @@ namespace obamadb {
       num_rows_(0),
       block_size_bytes_(kStorageBlockSize),
       store_(nullptr),
-      initializing_(true) {
+      initializing_(true),
+      store_source_(StoreSource::kHugePages) {
         std::uint64_t requested_size = ((numColumns + 1) * numRows) * sizeof(T);
         if(requested_size > block_size_bytes_) {
             block_size_bytes_ = requested_size;
         }
-        reinterpret_cast<T*>(new char[block_size_bytes_]);
+        store_ = static_cast<T*>(hugepages::allocate(block_size_bytes_));
     }
 
     DataBlock(unsigned size_bytes) :
       num_columns_(0),
       num_rows_(0),
       block_size_bytes_(size_bytes),
-      store_(reinterpret_cast<T*>(new char[size_bytes])),
-      initializing_(true) {}
+      store_(static_cast<T*>(arena::allocate(size_bytes))),
+      initializing_(true),
+      store_source_(StoreSource::kArena) {}
 
-    DataBlock() : DataBlock(kStorageBlockSize) {}
+    DataBlock() : DataBlock(storageBlockSize()) {}
 
     ~DataBlock() {
-      delete store_;
+      releaseStore();
     }
 
     /**
@@ -91,6 +96,47 @@ namespace obamadb {
     T* store_;
     bool initializing_;
 
+  protected:
+    // Blocks of rows come from the block arena. Blocks sized by their dimensions, like models,
+    // come from hugepages::allocate. Replaced stores come from either the arena or
+    // memory::allocate.
+    enum class StoreSource {
+      kArena,
+      kHugePages,
+      kHeap
+    };
+
+    /**
+     * Swaps the storage for a copy made by the subclass, e.g. to compact it.
+     * @param store The new storage. The block takes ownership.
+     * @param size_bytes Size of the new storage.
+     * @param source Where the new storage came from, to release it to.
+     */
+    void replaceStore(T* store, std::uint32_t size_bytes, StoreSource source) {
+      releaseStore();
+      store_ = store;
+      block_size_bytes_ = size_bytes;
+      store_source_ = source;
+    }
+
+  private:
+
+    void releaseStore() {
+      switch (store_source_) {
+        case StoreSource::kArena:
+          arena::release(store_);
+          break;
+        case StoreSource::kHugePages:
+          hugepages::release(store_);
+          break;
+        case StoreSource::kHeap:
+          memory::release(store_);
+          break;
+      }
+    }
+
+    StoreSource store_source_;
+
     DISABLE_COPY_AND_ASSIGN(DataBlock);
   };
 
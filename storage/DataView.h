@@ -31,6 +31,18 @@ namespace obamadb {
       return false;
     }
 
+    /**
+     * Like getNext, and tells whether the row came from a dense block. Its values are then the
+     * columns 0 to row->numElements() - 1, so they can go through the contiguous kernels of ml.
+     */
+    inline bool getNext(svector<num_t> * row, bool * dense) {
+      if (!getNext(row)) {
+        return false;
+      }
+      *dense = blocks_[current_block_]->isDense();
+      return true;
+    }
+
     void appendBlock(SparseDataBlock<num_t> const * block) {
       blocks_.push_back(block);
     }
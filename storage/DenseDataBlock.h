@@ -3,6 +3,7 @@
 
 #include "storage/exvector.h"
 #include "storage/DataBlock.h"
+#include "storage/Random.h"
 #include "storage/StorageConstants.h"
 #include "storage/Utils.h"
 
@@ -33,7 +34,7 @@ namespace obamadb {
       DataBlock<T>(size_bytes),
       maxElements(size_bytes / (sizeof(T))) {}
 
-    DenseDataBlock() : DenseDataBlock<T>(kStorageBlockSize) {}
+    DenseDataBlock() : DenseDataBlock<T>(storageBlockSize()) {}
 
     /**
      * Use this function while initializing to pack the block.
@@ -104,17 +105,40 @@ namespace obamadb {
       return this->num_columns_ + 1;
     }
 
+    /**
+     * Fills every row with values in [0, 1) from the calling thread's generator. The
+     * classification slots are filled too, which lets the whole block be filled in one pass.
+     */
     void randomize() {
-      dvector<T> row_vector(0, nullptr);
       this->num_rows_ = this->maxRows;
-      for (int row = 0; row < this->num_rows_; row++) {
+      rng::fillUniform(this->store_, static_cast<std::size_t>(this->num_rows_) * sizeRow(), 0, 1);
+    }
+
+    /**
+     * Fills rows [first_row, last_row) with values in [0, 1). Each row is drawn from its own
+     * counter based stream, so disjoint ranges of rows can be filled concurrently and the
+     * values do not depend on how the rows were split up. Does not change the row count,
+     * see setAllRowsUsed.
+     */
+    void randomizeRows(std::uint64_t seed, int first_row, int last_row) {
+      DCHECK_LE(last_row, this->maxRows);
+      dvector<T> row_vector(0, nullptr);
+      for (int row = first_row; row < last_row; row++) {
+        rng::CounterRng rng(seed, row);
         this->getRowVectorFast(row, &row_vector);
         for (int column = 0; column < this->num_columns_; column++) {
-          row_vector.values_[column] = (T) rand() / (T)INT_MAX; // TODO: this will not work with non-float types
+          row_vector.values_[column] = static_cast<T>(rng.nextFloat());
         }
       }
     }
 
+    /**
+     * Counts every row as used, for blocks whose rows are written in place rather than appended.
+     */
+    void setAllRowsUsed() {
+      this->num_rows_ = this->maxRows;
+    }
+
     template<class TT>
     friend std::ostream &operator<<(std::ostream &os, const DenseDataBlock<TT> &block);
 
@@ -0,0 +1,123 @@
+#include "storage/HugePages.h"
+
+#include "storage/MemoryAccounting.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <sys/mman.h>
+
+#include "glog/logging.h"
+
+DEFINE_string(huge_pages, "madvise", "How data blocks and models get huge pages. Select one of [none, madvise,"
+  " hugetlb]. madvise asks for transparent huge pages, hugetlb maps pages reserved in"
+  " /proc/sys/vm/nr_hugepages and falls back to madvise when there are not enough.");
+
+namespace obamadb {
+
+  namespace hugepages {
+
+    std::size_t const kHugePageBytes = 2 * 1024 * 1024;
+
+    namespace {
+      std::atomic<bool> warned_hugetlb(false);
+
+      // Precedes each allocation from allocate, so release tells mapped regions from heap memory
+      // without a shared lookup. Sized to keep the memory after it aligned like operator new.
+      struct alignas(alignof(std::max_align_t)) Header {
+        // Bytes of the region the allocation was mapped in, or 0 if it is from memory::allocate.
+        std::size_t mapped_bytes;
+        memory::Subsystem subsystem;
+      };
+
+      void* mapOrDie(std::size_t bytes, int extra_flags) {
+        void* region = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+        CHECK(region != MAP_FAILED) << "Unable to map " << bytes << " bytes: " << strerror(errno);
+        return region;
+      }
+
+      /**
+       * Maps bytes aligned to a huge page by over mapping and trimming either end.
+       */
+      void* mapAligned(std::size_t bytes) {
+        char* region = static_cast<char*>(mapOrDie(bytes + kHugePageBytes, 0));
+        std::uintptr_t const address = reinterpret_cast<std::uintptr_t>(region);
+        std::size_t const head = (kHugePageBytes - address % kHugePageBytes) % kHugePageBytes;
+        if (head > 0) {
+          munmap(region, head);
+        }
+        munmap(region + head + bytes, kHugePageBytes - head);
+        return region + head;
+      }
+    }
+
+    std::size_t roundUp(std::size_t bytes) {
+      return ((bytes + kHugePageBytes - 1) / kHugePageBytes) * kHugePageBytes;
+    }
+
+    void* map(std::size_t bytes) {
+      CHECK_EQ(0, bytes % kHugePageBytes);
+      CHECK(FLAGS_huge_pages == "none" || FLAGS_huge_pages == "madvise" || FLAGS_huge_pages == "hugetlb")
+        << "Unknown huge_pages " << FLAGS_huge_pages;
+#ifdef MAP_HUGETLB
+      if (FLAGS_huge_pages == "hugetlb") {
+        void* region = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (region != MAP_FAILED) {
+          return region;
+        }
+        if (!warned_hugetlb.exchange(true)) {
+          LOG(WARNING) << "Not enough reserved huge pages, falling back to transparent huge pages.";
+        }
+      }
+#endif
+      void* region = mapAligned(bytes);
+#ifdef MADV_HUGEPAGE
+      if (FLAGS_huge_pages != "none") {
+        // Only advice: transparent huge pages may be disabled.
+        madvise(region, bytes, MADV_HUGEPAGE);
+      }
+#endif
+      return region;
+    }
+
+    void unmap(void * region, std::size_t bytes) {
+      CHECK_EQ(0, munmap(region, bytes));
+    }
+
+    void* allocate(std::size_t bytes) {
+      Header* header;
+      if (bytes < kHugePageBytes / 2) {
+        header = static_cast<Header*>(memory::allocate(sizeof(Header) + bytes));
+        header->mapped_bytes = 0;
+      } else {
+        // The header shares the region, so the memory after it is still all on huge pages.
+        std::size_t const mapped_bytes = roundUp(sizeof(Header) + bytes);
+        header = static_cast<Header*>(map(mapped_bytes));
+        header->mapped_bytes = mapped_bytes;
+        header->subsystem = memory::current();
+        memory::add(header->subsystem, mapped_bytes);
+      }
+      return header + 1;
+    }
+
+    void release(void * ptr) {
+      if (ptr == nullptr) {
+        return;
+      }
+      Header* header = static_cast<Header*>(ptr) - 1;
+      if (header->mapped_bytes == 0) {
+        memory::release(header);
+        return;
+      }
+      std::size_t const mapped_bytes = header->mapped_bytes;
+      memory::Subsystem const subsystem = header->subsystem;
+      unmap(header, mapped_bytes);
+      memory::add(subsystem, -static_cast<std::int64_t>(mapped_bytes));
+    }
+
+  } // namespace hugepages
+
+} // namespace obamadb
@@ -0,0 +1,62 @@
+#ifndef OBAMADB_HUGEPAGES_H
+#define OBAMADB_HUGEPAGES_H
+
+#include <cstddef>
+
+#include <gflags/gflags.h>
+
+DECLARE_string(huge_pages);
+
+namespace obamadb {
+
+  /**
+   * Maps large regions of memory on huge pages, which cut the TLB misses of random access over
+   * data blocks and models. How is chosen by the huge_pages flag.
+   */
+  namespace hugepages {
+
+    // The default huge page size on x86-64 and aarch64.
+    extern std::size_t const kHugePageBytes;
+
+    /**
+     * @return Bytes rounded up to a whole number of huge pages.
+     */
+    std::size_t roundUp(std::size_t bytes);
+
+    /**
+     * Maps zeroed, readable and writable memory aligned to a huge page. Pages are not touched,
+     * so on NUMA machines they land on the node of the thread which first writes them.
+     * @param bytes Must be a multiple of kHugePageBytes.
+     * @return The region. Fails if there is no memory.
+     */
+    void* map(std::size_t bytes);
+
+    /**
+     * Unmaps a region from map.
+     */
+    void unmap(void * region, std::size_t bytes);
+
+    /**
+     * Allocates memory for a model, counted against the current memory::Subsystem. Allocations
+     * of at least half a huge page get a region of their own from map, smaller ones come from
+     * memory::allocate, where huge pages would only waste memory. A header in front of each
+     * allocation records which, so release needs no lock.
+     * @return Memory aligned at least like operator new.
+     */
+    void* allocate(std::size_t bytes);
+
+    /**
+     * Frees memory from allocate. Null is ignored.
+     */
+    void release(void * ptr);
+
+    template<class T>
+    T* allocateArray(std::size_t count) {
+      return static_cast<T*>(allocate(sizeof(T) * count));
+    }
+
+  } // namespace hugepages
+
+} // namespace obamadb
+
+#endif //OBAMADB_HUGEPAGES_H
@@ -5,11 +5,18 @@
 #include "storage/DenseDataBlock.h"
 #include "storage/Matrix.h"
 #include "storage/MLTask.h"
+#include "storage/Random.h"
 #include "storage/SparseDataBlock.h"
+#include "storage/ThreadPool.h"
+#include "storage/Trace.h"
 #include "storage/Utils.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <memory>
 #include <set>
+#include <sys/stat.h>
 
 #include "glog/logging.h"
 
@@ -18,47 +25,81 @@ namespace obamadb {
   typedef std::vector<obamadb::SparseDataBlock<num_t> *> BlockVector;
 
   namespace IO {
+    // Entries generated from one random stream. Fixing the size of the chunks makes the
+    // output independent of the number of threads.
+    int const kSyntheticChunkEntries = 1 << 16;
+
+    // Seed of the synthetic SVM datasets which do not specify one.
+    std::uint64_t const kDefaultSyntheticSeed = 1337;
+
     /**
-     * Creates a synthetic matrix with approximately some true rank.
+     * Creates a synthetic matrix completion dataset in parallel.
      * @param rows
      * @param cols
      * @param nnz Number of non-zero entries
-     * @param rank
+     * @param rank The approximate true rank of the matrix, or -1 for values with no structure.
+     * @param seed
+     * @param num_threads
      * @param derived_mat Matrix to add entries to.
      */
     void createSyntheticMcMatrix(
       int rows, int cols,
       int nnz, int rank,
+      std::uint64_t seed,
+      int num_threads,
       obamadb::UnorderedMatrix *derived_mat) {
 
-      DenseDataBlock<num_t> lmat(rows, rank);
-      DenseDataBlock<num_t> rmat(cols, rank);
-      lmat.randomize();
-      rmat.randomize();
-      dvector<num_t> lrow_vec(0, nullptr);
-      dvector<num_t> rrow_vec(0, nullptr);
-      while (nnz-- != 0) {
-        int rrow = rand() % rows;
-        int rcol = rand() % cols;
-        //dot, and add to derived mat.
-        lmat.getRowVectorFast(rrow, &lrow_vec);
-        rmat.getRowVectorFast(rcol, &rrow_vec);
-        // We could also opt to add some noise at this step.
-        derived_mat->append(rrow, rcol, obamadb::ml::dot(lrow_vec, rrow_vec.values_));
-      }
-      lmat.getRowVectorFast(rows, &lrow_vec);
-      rmat.getRowVectorFast(cols, &rrow_vec);
-      if (derived_mat->numRows() < rows || derived_mat->numColumns() < cols) {
-        derived_mat->append(rows, cols, obamadb::ml::dot(lrow_vec, rrow_vec.values_));
+      std::unique_ptr<DenseDataBlock<num_t>> lmat;
+      std::unique_ptr<DenseDataBlock<num_t>> rmat;
+      if (rank != -1) {
+        lmat.reset(new DenseDataBlock<num_t>(rows, rank));
+        rmat.reset(new DenseDataBlock<num_t>(cols, rank));
+        threading::runThreads(num_threads, [&](int thread_id) {
+          lmat->randomizeRows(rng::deriveSeed(seed, 1),
+                              (static_cast<std::int64_t>(rows) * thread_id) / num_threads,
+                              (static_cast<std::int64_t>(rows) * (thread_id + 1)) / num_threads);
+          rmat->randomizeRows(rng::deriveSeed(seed, 2),
+                              (static_cast<std::int64_t>(cols) * thread_id) / num_threads,
+                              (static_cast<std::int64_t>(cols) * (thread_id + 1)) / num_threads);
+        });
       }
+
+      MatrixEntry* entries = derived_mat->extend(nnz);
+      int const num_chunks = (nnz + kSyntheticChunkEntries - 1) / kSyntheticChunkEntries;
+      std::uint64_t const entry_seed = rng::deriveSeed(seed, 3);
+      threading::runThreads(num_threads, [&](int thread_id) {
+        dvector<num_t> lrow_vec(0, nullptr);
+        dvector<num_t> rrow_vec(0, nullptr);
+        for (int chunk = thread_id; chunk < num_chunks; chunk += num_threads) {
+          rng::CounterRng rng(entry_seed, chunk);
+          int const first = chunk * kSyntheticChunkEntries;
+          int const last = std::min(nnz, first + kSyntheticChunkEntries);
+          for (int i = first; i < last; i++) {
+            int rrow = rng.nextInt(rows);
+            int rcol = rng.nextInt(cols);
+            num_t value;
+            if (rank != -1) {
+              lmat->getRowVectorFast(rrow, &lrow_vec);
+              rmat->getRowVectorFast(rcol, &rrow_vec);
+              // We could also opt to add some noise at this step.
+              value = obamadb::ml::dot(lrow_vec, rrow_vec.values_);
+            } else {
+              value = 10 * rng.nextFloat();
+            }
+            entries[i] = MatrixEntry(rrow, rcol, value);
+          }
+        }
+      });
+      derived_mat->growDimensions(rows, cols);
     }
 
     /**
      * Creates a synthetic dataset for matrix completion testing.
      * @param file_name
+     * @param num_threads Threads to generate with. Does not affect the result.
      * @return a matrix completion matrix with the file's spec.
      */
-    UnorderedMatrix* loadSyntheticMcMatrix(const std::string& file_name) {
+    UnorderedMatrix* loadSyntheticMcMatrix(const std::string& file_name, int num_threads) {
       Scanner scanner(file_name);
       std::vector<double> params = scanner.scanLine();
       CHECK_EQ(5, params.size());
@@ -71,22 +112,11 @@ namespace obamadb {
       int const cols = static_cast<int>(params[1]);
       int nnz = static_cast<int>(params[2]);
       int const rank = static_cast<int>(params[3]);
-      int const seed = static_cast<int>(params[4]);
-
-      srand(seed);
+      std::uint64_t const seed = static_cast<std::uint64_t>(params[4]);
 
       obamadb::UnorderedMatrix *derived_mat = new obamadb::UnorderedMatrix();
-      if (rank != -1) {
-        // creates a matrix with a particular rank
-        createSyntheticMcMatrix(rows, cols, nnz, rank, derived_mat);
-      } else {
-        while (nnz-- != 1) {
-          int rrow = rand() % rows;
-          int rcol = rand() % cols;
-          derived_mat->append(rrow, rcol, std::fmod(rand() / 1e-6, 10.0));
-        }
-        derived_mat->append(rows, cols, std::fmod(rand() / 1e-6, 10.0));
-      }
+      createSyntheticMcMatrix(rows, cols, nnz, rank, seed, num_threads, derived_mat);
+      derived_mat->shrinkToFit();
       return derived_mat;
     }
 
@@ -99,10 +129,11 @@ namespace obamadb {
      * int3 specifies a value
      * Helper parser function which expects classifications to be set for each row.
      */
-    UnorderedMatrix* loadUnorderedMatrix(const std::string& file_name) {
+    UnorderedMatrix* loadUnorderedMatrix(const std::string& file_name, int num_threads) {
+      trace::Scope scope("load", "io");
       if (file_name.find("_synth_mc_") != std::string::npos) {
         LOG(INFO) << "Loading a synthetic dataset: " << file_name;
-        return loadSyntheticMcMatrix(file_name);
+        return loadSyntheticMcMatrix(file_name, num_threads);
       }
       UnorderedMatrix* mat = new UnorderedMatrix();
 
@@ -113,6 +144,7 @@ namespace obamadb {
         mat->append(static_cast<int>(row[0]), static_cast<int>(row[1]), row[2]);
         row = scanner.scanLine();
       }
+      mat->shrinkToFit();
 
       return mat;
     }
@@ -131,6 +163,42 @@ namespace obamadb {
       return (num_t) -1.0;
     }
 
+    bool LibLinearReader::readRow() {
+      std::vector<double> line = scanner_.scanLine();
+      if (line.size() == 0) {
+        return false;
+      }
+      DCHECK_EQ(1, line.size() % 2) << "encoding error in row";
+      row_.clear();
+      row_.setClassification(labels_ == LabelType::kClass ? liblinearClassHelper(line[0]) : (num_t) line[0]);
+      for (int i = 1; i < line.size(); i+=2) {
+        DCHECK_EQ(line[i], floor(line[i])) << "non-integral index";
+        row_.push_back((int) line[i], (num_t) line[i+1]);
+      }
+      rows_read_++;
+      return true;
+    }
+
+    SparseDataBlock<num_t>* LibLinearReader::next() {
+      if (!has_pending_row_ && !readRow()) {
+        return nullptr;
+      }
+      SparseDataBlock<num_t>* block = new SparseDataBlock<num_t>();
+      do {
+        if (!block->appendRow(row_)) {
+          CHECK_LT(0, block->num_rows_) << "Row " << rows_read_ << " needs " << row_.sizeBytes()
+                                        << " bytes, more than a block of " << block->block_size_bytes_
+                                        << " bytes holds. Raise -block_size.";
+          has_pending_row_ = true;
+          block->finalize();
+          return block;
+        }
+      } while (readRow());
+      has_pending_row_ = false;
+      block->finalize();
+      return block;
+    }
+
     /**
      * Loads blocks which are in the liblinear format
      * class index:value index:value ...
@@ -138,79 +206,87 @@ namespace obamadb {
      * @return Block vector
      */
     template<>
-    BlockVector loadBlocks(const std::string &file_name) {
+    BlockVector loadBlocks(const std::string &file_name, LabelType labels) {
       BlockVector blocks;
-
-      // Helper function to add row to block.
-      auto insertHelper = [&blocks](
-        obamadb::SparseDataBlock<num_t>* &block,
-        obamadb::svector<num_t> &sparse_row) {
-        if (!block->appendRow(sparse_row)) {
-          blocks.push_back(block);
-          block = new SparseDataBlock<num_t>();
-        }
-      };
-
-      obamadb::SparseDataBlock<num_t>* block = new obamadb::SparseDataBlock<num_t>();
-      obamadb::svector<num_t> sparse_row;
-
-      Scanner scanner(file_name);
-      std::vector<double> line = scanner.scanLine();
-      while(line.size() > 0) {
-        DCHECK_EQ(1, line.size() % 2) << "encoding error in row";
-        sparse_row.setClassification(liblinearClassHelper(line[0]));
-        for (int i = 1; i < line.size(); i+=2) {
-          DCHECK_EQ(line[i], floor(line[i])) << "non-integral index";
-          sparse_row.push_back((int) line[i], (num_t) line[i+1]);
-        }
-        insertHelper(block, sparse_row);
-        sparse_row.clear();
-        line = scanner.scanLine();
-      }
-
-      if (block->num_rows_ > 0) {
+      LibLinearReader reader(file_name, labels);
+      SparseDataBlock<num_t>* block;
+      while ((block = reader.next()) != nullptr) {
         blocks.push_back(block);
       }
       return blocks;
     }
 
-    BlockVector loadSyntheticBlocks(std::string const & file_name) {
+    /**
+     * Generates the blocks of a synthetic SVM dataset, num_threads blocks at a time. Block b is
+     * a function of the seed and b alone, so the dataset does not depend on the thread count.
+     */
+    BlockVector loadSyntheticBlocks(std::string const & file_name, int num_threads) {
       BlockVector blocks;
       Scanner scanner(file_name);
 
       std::vector<double> line = scanner.scanLine();
+      CHECK(line.size() == 3 || line.size() == 4) << "Expected: rows columns density [seed]";
 
       double m = static_cast<int>(line[0]);
       double n = static_cast<int>(line[1]);
       double sigma = line[2];
+      std::uint64_t const seed = line.size() == 4 ? static_cast<std::uint64_t>(line[3]) : kDefaultSyntheticSeed;
 
       CHECK_GT(m, 0);
       CHECK_GT(n, 0);
       CHECK(sigma <= 1.0 && sigma > 0.0);
       int total_rows = 0;
+      BlockVector wave(num_threads);
       while (total_rows < m) {
-        blocks.push_back(obamadb::GetRandomSparseDataBlock(kStorageBlockSize, n, 1.0 - sigma));
-        total_rows += blocks.back()->num_rows_;
+        int const first_block = blocks.size();
+        threading::runThreads(num_threads, [&](int thread_id) {
+          wave[thread_id] = obamadb::GetRandomSparseDataBlock(
+            storageBlockSize(), n, 1.0 - sigma, rng::deriveSeed(seed, first_block + thread_id));
+        });
+        for (SparseDataBlock<num_t>* block : wave) {
+          if (total_rows < m) {
+            blocks.push_back(block);
+            total_rows += block->num_rows_;
+          } else {
+            delete block;
+          }
+        }
       }
       blocks.back()->trimRows(total_rows - m);
       return blocks;
     }
 
-    Matrix *load(const std::string &filename) {
+    Matrix *load(const std::string &filename, int num_threads, LabelType labels) {
+      trace::Scope scope("load", "io");
       std::string const synth_str("_synth_svm_");
       Matrix *mat = nullptr;
       if (filename.find(synth_str) != std::string::npos) {
         LOG(INFO) << "Loading a synthetic dataset";
         // this file contains synthetic data params
-        std::vector<obamadb::SparseDataBlock<num_t> *> blocks = loadSyntheticBlocks(filename);
+        std::vector<obamadb::SparseDataBlock<num_t> *> blocks = loadSyntheticBlocks(filename, num_threads);
         mat = new Matrix(blocks);
       } else {
-        std::vector<obamadb::SparseDataBlock<num_t> *> blocks = loadBlocks<num_t>(filename);
+        std::vector<obamadb::SparseDataBlock<num_t> *> blocks = loadBlocks<num_t>(filename, labels);
         mat = new Matrix(blocks);
       }
       return mat;
     }
 
+    std::uint64_t estimateBytes(const std::string &filename) {
+      if (filename.find("_synth_svm_") != std::string::npos) {
+        Scanner scanner(filename);
+        std::vector<double> line = scanner.scanLine();
+        CHECK_GE(line.size(), 3) << "Expected: rows columns density [seed]";
+        double const nnz_per_row = line[1] * line[2];
+        double const row_bytes = nnz_per_row * (sizeof(int) + sizeof(num_t))
+                                 + sizeof(num_t) + sizeof(SparseDataBlock<num_t>::SDBEntry);
+        return static_cast<std::uint64_t>(line[0] * row_bytes);
+      }
+      struct stat file_stat;
+      CHECK_EQ(0, stat(filename.c_str(), &file_stat)) << "Unable to stat " << filename;
+      return file_stat.st_size;
+    }
+
     void save(const std::string& file_name, const Matrix& mat) {
       save(file_name, mat.blocks_, mat.blocks_.size());
     }
@@ -6,8 +6,10 @@
 #include "storage/SparseDataBlock.h"
 #include "storage/StorageConstants.h"
 #include "storage/UnorderedMatrix.h"
+#include "storage/Utils.h"
 
 #include <cctype>
+#include <cstdint>
 #include <fstream>
 #include <istream>
 #include <iterator>
@@ -19,6 +21,14 @@ namespace obamadb {
 
   namespace IO {
 
+    /**
+     * How the first value of a liblinear row is read.
+     */
+    enum class LabelType {
+      kClass,  // A (-1,1) or (1,2) class, converted to (-1,1).
+      kTarget  // A real valued regression target, kept as it is.
+    };
+
    /**
     * Expects the data to be in the format:
     * [ID][attribute index][value]
@@ -26,17 +36,28 @@ namespace obamadb {
     * of the training example in the [value] position.
     *
     * @param file_name
+    * @param labels How the label of each row is read.
     * @return nullptr if datafile did not exist or was corrupt.
     */
     template<class T>
-    std::vector<SparseDataBlock<T>*> loadBlocks(const std::string &file_name);
+    std::vector<SparseDataBlock<T>*> loadBlocks(const std::string &file_name,
+                                                LabelType labels = LabelType::kClass);
 
     /**
      * Load a sparse file representation of a dataset into a matrix.
      * @param filename The sparse datafile.
+     * @param num_threads Threads used to generate synthetic datasets.
+     * @param labels How the label of each row is read. Synthetic datasets are always classes.
      * @return Caller-owned matrix.
      */
-    Matrix* load(const std::string &filename);
+    Matrix* load(const std::string &filename, int num_threads, LabelType labels = LabelType::kClass);
+
+    /**
+     * @param filename A file load accepts.
+     * @return Roughly the bytes of blocks load would make of it, to size the blocks with. The
+     *    size of the file for text formats, which is usually a little more.
+     */
+    std::uint64_t estimateBytes(const std::string &filename);
 
     void save(const std::string& file_name, const Matrix& mat);
 
@@ -101,7 +122,55 @@ namespace obamadb {
       file.close();
     }
 
-    UnorderedMatrix* loadUnorderedMatrix(const std::string& file_name);
+    /**
+     * Loads a matrix completion dataset.
+     * @param file_name A TSV file of row, column, value triples or a synthetic dataset spec.
+     * @param num_threads Threads used to generate synthetic datasets. Does not affect the result.
+     * @return Caller-owned matrix.
+     */
+    UnorderedMatrix* loadUnorderedMatrix(const std::string& file_name, int num_threads);
+
+    /**
+     * Reads a liblinear format file one block at a time so that files larger than memory
+     * can be streamed.
+     */
+    class LibLinearReader {
+    public:
+      /**
+       * @param file_name The liblinear format file.
+       * @param labels How the label of each row is read.
+       */
+      LibLinearReader(const std::string &file_name, LabelType labels = LabelType::kClass)
+        : scanner_(file_name),
+          labels_(labels),
+          row_(),
+          has_pending_row_(false),
+          rows_read_(0) {}
+
+      /**
+       * @return A caller-owned, full block or nullptr if the file has been read. Fails if a row
+       *    does not fit in an empty block.
+       */
+      SparseDataBlock<num_t>* next();
+
+      /**
+       * @return The number of rows read so far.
+       */
+      std::uint64_t rowsRead() const {
+        return rows_read_;
+      }
+
+    private:
+      bool readRow();
+
+      Scanner scanner_;
+      LabelType const labels_;
+      svector<num_t> row_;
+      bool has_pending_row_; // A row which did not fit in the previous block.
+      std::uint64_t rows_read_;
+
+      DISABLE_COPY_AND_ASSIGN(LibLinearReader);
+    };
 
   }  // namespace IO
 }
@@ -0,0 +1,146 @@
+#include "storage/Instrumentation.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "glog/logging.h"
+
+DEFINE_int64(instrument_sample_period, 64, "In an instrumentation build, one in this many model updates of"
+  " a worker measures how stale the values it read were.");
+
+namespace obamadb {
+
+  namespace instrument {
+
+    namespace {
+      WriteTracker* active_tracker = nullptr;
+    }
+
+    WriteTracker::WriteTracker(int num_threads, int sample_period)
+      : sample_period_(sample_period),
+        regions_(),
+        num_lines_(0),
+        versions_(),
+        threads_(num_threads) {
+      CHECK_GT(sample_period, 0);
+    }
+
+    WriteTracker::~WriteTracker() {
+      if (active_tracker == this) {
+        active_tracker = nullptr;
+      }
+    }
+
+    void WriteTracker::addRegion(void const * base, std::size_t bytes) {
+      Region region;
+      region.first_address_line = reinterpret_cast<std::uintptr_t>(base) / kCacheLineBytes;
+      region.end_address_line = (reinterpret_cast<std::uintptr_t>(base) + bytes + kCacheLineBytes - 1) / kCacheLineBytes;
+      region.first_line = num_lines_;
+      regions_.push_back(region);
+      num_lines_ += region.end_address_line - region.first_address_line;
+
+      versions_.reset(new std::atomic<std::uint32_t>[num_lines_]);
+      for (std::size_t line = 0; line < num_lines_; line++) {
+        versions_[line].store(0);
+      }
+    }
+
+    void WriteTracker::read(int thread_id, num_t const * base, int const * indexes, int count) {
+      ThreadState & state = threads_[thread_id];
+      for (int i = 0; i < count; i++) {
+        recordRead(&state, lineOf(base + indexes[i]));
+      }
+    }
+
+    void WriteTracker::read(int thread_id, num_t const * values, int count) {
+      ThreadState & state = threads_[thread_id];
+      for (int i = 0; i < count; i += kCacheLineBytes / sizeof(num_t)) {
+        recordRead(&state, lineOf(values + i));
+      }
+      if (count > 0) {
+        recordRead(&state, lineOf(values + count - 1));
+      }
+    }
+
+    void WriteTracker::checkReads(int thread_id) {
+      ThreadState & state = threads_[thread_id];
+      EpochConflicts & counts = state.counts;
+      counts.sampled_updates++;
+      for (std::size_t i = 0; i < state.lines.size(); i++) {
+        std::uint32_t const foreign_writes =
+          versions_[state.lines[i]].load(std::memory_order_relaxed) - state.versions[i];
+        counts.sampled_lines++;
+        counts.stale_lines += foreign_writes > 0;
+        counts.staleness += foreign_writes;
+        counts.max_staleness = std::max(counts.max_staleness, foreign_writes);
+      }
+      state.lines.clear();
+      state.versions.clear();
+    }
+
+    void WriteTracker::write(int thread_id, num_t const * base, int const * indexes, int count) {
+      (void) thread_id;
+      std::size_t last_line = num_lines_;
+      for (int i = 0; i < count; i++) {
+        std::size_t const line = lineOf(base + indexes[i]);
+        if (line != last_line) {
+          bump(line);
+          last_line = line;
+        }
+      }
+    }
+
+    void WriteTracker::write(int thread_id, num_t const * values, int count) {
+      (void) thread_id;
+      if (count == 0) {
+        return;
+      }
+      std::size_t const first = lineOf(values);
+      std::size_t const last = lineOf(values + count - 1);
+      for (std::size_t line = first; line <= last; line++) {
+        bump(line);
+      }
+    }
+
+    EpochConflicts WriteTracker::endEpoch() {
+      EpochConflicts total;
+      for (ThreadState & state : threads_) {
+        EpochConflicts const & counts = state.counts;
+        total.updates += counts.updates;
+        total.sampled_updates += counts.sampled_updates;
+        total.sampled_lines += counts.sampled_lines;
+        total.stale_lines += counts.stale_lines;
+        total.staleness += counts.staleness;
+        total.max_staleness = std::max(total.max_staleness, counts.max_staleness);
+        state.counts = EpochConflicts();
+      }
+      return total;
+    }
+
+    void setTracker(WriteTracker * tracker) {
+      active_tracker = tracker;
+    }
+
+    WriteTracker* tracker() {
+      return active_tracker;
+    }
+
+    void printEpoch(int epoch) {
+      if (active_tracker == nullptr) {
+        return;
+      }
+      EpochConflicts const conflicts = active_tracker->endEpoch();
+      double const lines = std::max<std::uint64_t>(1, conflicts.sampled_lines);
+      printf("[CONFLICTS] epoch %d: %llu updates, %llu sampled, %.4f of lines read were stale,"
+             " %.3f mean staleness, %u max staleness\n",
+             epoch,
+             static_cast<unsigned long long>(conflicts.updates),
+             static_cast<unsigned long long>(conflicts.sampled_updates),
+             conflicts.stale_lines / lines,
+             conflicts.staleness / lines,
+             conflicts.max_staleness);
+    }
+
+  } // namespace instrument
+
+} // namespace obamadb
@@ -0,0 +1,195 @@
+#ifndef OBAMADB_INSTRUMENTATION_H
+#define OBAMADB_INSTRUMENTATION_H
+
+#include "storage/StorageConstants.h"
+#include "storage/Utils.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include "glog/logging.h"
+
+DECLARE_int64(instrument_sample_period);
+
+/**
+ * Wraps statements which only exist in an instrumentation build, configured with
+ * -DOBAMADB_INSTRUMENT=ON. Otherwise they compile to nothing, so hooks in the update loops
+ * cost nothing in a normal build.
+ */
+#ifdef OBAMADB_INSTRUMENT
+#define INSTRUMENT(...) __VA_ARGS__
+#else
+#define INSTRUMENT(...)
+#endif
+
+namespace obamadb {
+
+  /**
+   * Telemetry on how Hogwild workers interfere through the shared model.
+   */
+  namespace instrument {
+
+    /**
+     * Write conflicts seen by the sampled updates of an epoch.
+     */
+    struct EpochConflicts {
+      EpochConflicts()
+        : updates(0),
+          sampled_updates(0),
+          sampled_lines(0),
+          stale_lines(0),
+          staleness(0),
+          max_staleness(0) { }
+
+      std::uint64_t updates;
+      std::uint64_t sampled_updates;
+      // Model cache lines read by the sampled updates.
+      std::uint64_t sampled_lines;
+      // Of those, lines another worker wrote between the read and the update's own write.
+      std::uint64_t stale_lines;
+      // Writes by other workers to the sampled lines in the same window, summed.
+      std::uint64_t staleness;
+      // The most writes by other workers to one line in one window.
+      std::uint32_t max_staleness;
+    };
+
+    /**
+     * Keeps a version counter per cache line of the model which every update bumps for the
+     * lines it writes. A sampled update also records the versions of the lines it reads before
+     * computing with them, and compares them just before writing. Any difference is writes by
+     * other workers to values the update was computing with, so the difference is the staleness
+     * of what it read, counted in updates.
+     *
+     * Usage by a worker, per update:
+     *   bool sampled = tracker->beginUpdate(thread_id);
+     *   if (sampled) tracker->read(...);        for everything the update reads
+     *   ... compute ...
+     *   if (sampled) tracker->checkReads(thread_id);
+     *   tracker->write(...);                    for everything the update writes
+     */
+    class WriteTracker {
+    public:
+      /**
+       * @param num_threads Number of workers.
+       * @param sample_period One in sample_period updates of a worker is sampled.
+       */
+      WriteTracker(int num_threads, int sample_period);
+
+      /**
+       * Stops update loops from reporting to this tracker.
+       */
+      ~WriteTracker();
+
+      /**
+       * Tracks a region of the model. Call before the workers start.
+       */
+      void addRegion(void const * base, std::size_t bytes);
+
+      /**
+       * @return True if this update of the worker is sampled.
+       */
+      inline bool beginUpdate(int thread_id) {
+        ThreadState & state = threads_[thread_id];
+        state.counts.updates++;
+        return state.counts.updates % sample_period_ == 0;
+      }
+
+      /**
+       * Records the lines of a sparse read of base[indexes[0..count)]. Indexes are sorted.
+       */
+      void read(int thread_id, num_t const * base, int const * indexes, int count);
+
+      /**
+       * Records the lines of a dense read of values[0..count).
+       */
+      void read(int thread_id, num_t const * values, int count);
+
+      /**
+       * Compares the recorded lines against their current versions and clears them.
+       */
+      void checkReads(int thread_id);
+
+      void write(int thread_id, num_t const * base, int const * indexes, int count);
+
+      void write(int thread_id, num_t const * values, int count);
+
+      /**
+       * Sums and resets the counts of all workers. Call while the workers are waiting.
+       */
+      EpochConflicts endEpoch();
+
+    private:
+      struct ThreadState {
+        ThreadState()
+          : counts(),
+            lines(),
+            versions() { }
+
+        EpochConflicts counts;
+        std::vector<std::size_t> lines;
+        std::vector<std::uint32_t> versions;
+        // Keeps the counts of neighbouring workers off each other's cache lines.
+        char padding[kCacheLineBytes];
+      };
+
+      struct Region {
+        std::uintptr_t first_address_line;
+        std::uintptr_t end_address_line;
+        std::size_t first_line;
+      };
+
+      inline std::size_t lineOf(void const * address) const {
+        std::uintptr_t const address_line = reinterpret_cast<std::uintptr_t>(address) / kCacheLineBytes;
+        for (Region const & region : regions_) {
+          if (address_line >= region.first_address_line && address_line < region.end_address_line) {
+            return region.first_line + (address_line - region.first_address_line);
+          }
+        }
+        DLOG(FATAL) << "Address outside of the tracked model.";
+        return 0;
+      }
+
+      inline void recordRead(ThreadState * state, std::size_t line) {
+        if (state->lines.empty() || state->lines.back() != line) {
+          state->lines.push_back(line);
+          state->versions.push_back(versions_[line].load(std::memory_order_relaxed));
+        }
+      }
+
+      inline void bump(std::size_t line) {
+        versions_[line].fetch_add(1, std::memory_order_relaxed);
+      }
+
+      int const sample_period_;
+      std::vector<Region> regions_;
+      std::size_t num_lines_;
+      std::unique_ptr<std::atomic<std::uint32_t>[]> versions_;
+      std::vector<ThreadState> threads_;
+
+      DISABLE_COPY_AND_ASSIGN(WriteTracker);
+    };
+
+    /**
+     * Sets the tracker the update loops report to, or null for none.
+     */
+    void setTracker(WriteTracker * tracker);
+
+    /**
+     * @return The tracker of the model being trained, or null.
+     */
+    WriteTracker* tracker();
+
+    /**
+     * Prints the conflicts of the epoch, if a model is being tracked, and starts a new epoch.
+     */
+    void printEpoch(int epoch);
+
+  } // namespace instrument
+
+} // namespace obamadb
+
+#endif //OBAMADB_INSTRUMENTATION_H
@@ -0,0 +1 @@
+#include "LinearTask.h"
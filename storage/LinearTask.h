@@ -0,0 +1,219 @@
+#ifndef OBAMADB_LINEARTASK_H
+#define OBAMADB_LINEARTASK_H
+
+#include "storage/DataBlock.h"
+#include "storage/DataView.h"
+#include "storage/exvector.h"
+#include "storage/Instrumentation.h"
+#include "storage/MLTask.h"
+#include "storage/SparseDataBlock.h"
+#include "storage/Utils.h"
+
+#include <cmath>
+
+namespace obamadb {
+
+  /**
+   * Single params shared between many linear model tasks/workers.
+   */
+  struct LinearParams {
+    LinearParams(float step_size,
+                 float step_decay)
+      : step_size(step_size),
+        step_decay(step_decay) {}
+
+    float step_size;
+    float step_decay;
+  };
+
+  /**
+   * Logistic regression over (-1,1) labeled data. Minimizes log(1 + e^(-y * w.x)).
+   */
+  struct LogisticLoss {
+    static constexpr MLAlgorithm kType = MLAlgorithm::kLR;
+
+    /**
+     * @return The multiple of the row to add to theta, which is the negated gradient of the
+     *         loss scaled by the step size.
+     */
+    static num_t step(num_t wx, num_t y, num_t step_size) {
+      // d/dw log(1 + e^(-y w.x)) = -y x * sigmoid(-y w.x)
+      return step_size * y * ml::fast_sigmoid(-wx * y);
+    }
+
+    static double rowLoss(double wx, double y) {
+      double const wxy = wx * y;
+      // log(1 + e^-z), rearranged to stay finite for large |z|.
+      return wxy > 0 ? std::log1p(std::exp(-wxy)) : -wxy + std::log1p(std::exp(wxy));
+    }
+
+    /**
+     * @return The reported loss, the average logistic loss.
+     */
+    static double finishLoss(double total_loss, double total_examples) {
+      return total_loss / total_examples;
+    }
+
+    static char const * errorName() {
+      return "fraction_misclassified";
+    }
+
+    static double error(num_t const *theta, std::vector<SparseDataBlock<num_t> *> const &blocks) {
+      return ml::fractionMisclassified(theta, blocks);
+    }
+  };
+
+  /**
+   * Least squares regression. Minimizes (w.x - y)^2 / 2. The classification slot of each
+   * row holds the target, so the data must be loaded with IO::LabelType::kTarget.
+   */
+  struct SquaredLoss {
+    static constexpr MLAlgorithm kType = MLAlgorithm::kLS;
+
+    static num_t step(num_t wx, num_t y, num_t step_size) {
+      return -step_size * (wx - y);
+    }
+
+    static double rowLoss(double wx, double y) {
+      double const err = wx - y;
+      return err * err / 2;
+    }
+
+    /**
+     * @return The reported loss, the average squared loss.
+     */
+    static double finishLoss(double total_loss, double total_examples) {
+      return total_loss / total_examples;
+    }
+
+    static char const * errorName() {
+      return "rmse";
+    }
+
+    static double error(num_t const *theta, std::vector<SparseDataBlock<num_t> *> const &blocks) {
+      return ml::rmse(theta, blocks);
+    }
+  };
+
+  /**
+   * A linear model trained with Hogwild style updates to a shared theta. The loss policy
+   * gives the gradient step, the loss of each row and the error to report.
+   */
+  template<class LossT>
+  class LinearTask : MLTask {
+  public:
+    typedef LinearParams Params;
+
+    LinearTask(DataView *dataView,
+               fvector *sharedTheta,
+               LinearParams *sharedParams)
+      : MLTask(dataView),
+        shared_theta_(sharedTheta),
+        shared_params_(sharedParams) {}
+
+    MLAlgorithm getType() override {
+      return LossT::kType;
+    }
+
+    /**
+     * Calculates and applies the gradient of the loss.
+     */
+    void execute(int threadId, void *ml_state) override {
+      (void) ml_state;
+
+      data_view_->reset();
+      svector<num_t> row(0, nullptr);
+      bool dense = false;
+      num_t *theta = shared_theta_->values_;
+      const num_t step_size = shared_params_->step_size;
+      INSTRUMENT(instrument::WriteTracker* tracker = instrument::tracker();)
+
+      while (data_view_->getNext(&row, &dense)) {
+        INSTRUMENT(
+          bool const sampled = tracker != nullptr && tracker->beginUpdate(threadId);
+          if (sampled) {
+            tracker->read(threadId, theta, row.index_, row.numElements());
+          })
+        // Dense rows start at column 0, so they skip the index and vectorize.
+        num_t const wx = dense ? ml::dot(row.values_, theta, row.num_elements_) : ml::dot(row, theta);
+        num_t const e = LossT::step(wx, *row.getClassification(), step_size);
+        INSTRUMENT(
+          if (sampled) {
+            tracker->checkReads(threadId);
+          }
+          if (tracker != nullptr) {
+            tracker->write(threadId, theta, row.index_, row.numElements());
+          })
+        if (dense) {
+          ml::scale_and_add(theta, row.values_, row.num_elements_, e);
+        } else {
+          ml::scale_and_add(theta, row, e);
+        }
+      }
+
+      if (threadId == 0) {
+        shared_params_->step_size = step_size * shared_params_->step_decay;
+      }
+    }
+
+    /**
+     * The loss reported while training.
+     * @param theta The trained weights.
+     * @param blocks All the data.
+     */
+    static double loss(const fvector &theta, std::vector<SparseDataBlock<num_t> *> const &blocks) {
+      double total_examples = 0;
+      double total_loss = 0;
+      svector<num_t> row(0, nullptr);
+      for (int i = 0; i < blocks.size(); i++) {
+        SparseDataBlock<num_t> const &block = *blocks[i];
+        for (int j = 0; j < block.getNumRows(); j++) {
+          block.getRowVectorFast(j, &row);
+          total_loss += LossT::rowLoss(ml::dot(row, theta.values_), *row.getClassification());
+        }
+        total_examples += block.getNumRows();
+      }
+      return LossT::finishLoss(total_loss, total_examples);
+    }
+
+    /**
+     * @return The name of the error error() reports, to label its output with.
+     */
+    static char const * errorName() {
+      return LossT::errorName();
+    }
+
+    /**
+     * The error reported while training: the fraction of misclassified examples for a
+     * classifier, the root mean squared error for a regression.
+     */
+    static double error(const fvector &theta, std::vector<SparseDataBlock<num_t> *> const &blocks) {
+      return LossT::error(theta.values_, blocks);
+    }
+
+    fvector *shared_theta_;
+    LinearParams *shared_params_;
+
+    DISABLE_COPY_AND_ASSIGN(LinearTask);
+  };
+
+  typedef LinearTask<LogisticLoss> LRTask;
+  typedef LinearTask<SquaredLoss> LSTask;
+
+  /**
+   * @return Caller-owned LR params.
+   */
+  inline LinearParams *DefaultLRParams() {
+    return new LinearParams(0.1, 0.95);
+  }
+
+  /**
+   * @return Caller-owned LS params.
+   */
+  inline LinearParams *DefaultLSParams() {
+    return new LinearParams(0.01, 0.95);
+  }
+
+} // namespace obamadb
+
+#endif //OBAMADB_LINEARTASK_H
@@ -1,6 +1,10 @@
 #include "storage/exvector.h"
+#include "storage/Instrumentation.h"
+#include "storage/Random.h"
+#include "storage/ThreadPool.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <vector>
 
 #include "MCTask.h"
@@ -8,6 +12,85 @@
 
 namespace obamadb {
 
+  MCStatistics::MCStatistics(UnorderedMatrix const * training_matrix, int num_threads)
+    : degrees_l(training_matrix->numRows(), 0),
+      degrees_r(training_matrix->numColumns(), 0),
+      mean(0) {
+    std::int64_t const num_entries = training_matrix->numElements();
+    std::vector<std::vector<int>> partial_l(num_threads);
+    std::vector<std::vector<int>> partial_r(num_threads);
+    std::vector<double> partial_sums(num_threads, 0);
+    threading::barrier_t counted(num_threads);
+
+    threading::runThreads(num_threads, [&](int thread_id) {
+      partial_l[thread_id].resize(degrees_l.size(), 0);
+      partial_r[thread_id].resize(degrees_r.size(), 0);
+      std::vector<int> & local_l = partial_l[thread_id];
+      std::vector<int> & local_r = partial_r[thread_id];
+      double sum = 0;
+      int const first = (num_entries * thread_id) / num_threads;
+      int const last = (num_entries * (thread_id + 1)) / num_threads;
+      for (int i = first; i < last; i++) {
+        MatrixEntry const & entry = training_matrix->get(i);
+        local_l[entry.row]++;
+        local_r[entry.column]++;
+        sum += entry.value;
+      }
+      partial_sums[thread_id] = sum;
+      counted.wait();
+
+      // Reduce, each thread summing a range of rows and a range of columns.
+      auto reduce = [num_threads, thread_id](std::vector<std::vector<int>> const & partials,
+                                             std::vector<int>* degrees) {
+        std::int64_t const size = degrees->size();
+        std::int64_t const first_index = (size * thread_id) / num_threads;
+        std::int64_t const last_index = (size * (thread_id + 1)) / num_threads;
+        for (std::vector<int> const & partial : partials) {
+          for (std::int64_t i = first_index; i < last_index; i++) {
+            (*degrees)[i] += partial[i];
+          }
+        }
+      };
+      reduce(partial_l, &degrees_l);
+      reduce(partial_r, &degrees_r);
+    });
+
+    double sum = 0;
+    for (double partial_sum : partial_sums) {
+      sum += partial_sum;
+    }
+    mean = sum / num_entries;
+  }
+
+  MCState::MCState(UnorderedMatrix const * training_matrix,
+                   std::shared_ptr<MCStatistics const> statistics,
+                   int rank,
+                   int num_threads)
+    : mu(-1),
+      step_size(0.001),
+      step_decay(0.9),
+      statistics(statistics),
+      mean(statistics->mean),
+      rank(rank),
+      mat_l(new DenseDataBlock<num_t>(training_matrix->numRows(), rank)),
+      mat_r(new DenseDataBlock<num_t>(training_matrix->numColumns(), rank)) {
+    // Drawn from the calling thread so every trial starts from a different model.
+    std::uint64_t const seed = rng::threadLocal().next();
+    int const rows_l = training_matrix->numRows();
+    int const rows_r = training_matrix->numColumns();
+    threading::runThreads(num_threads, [&](int thread_id) {
+      threading::setCoreAffinity(threading::peekCoreAffinity(thread_id));
+      mat_l->randomizeRows(rng::deriveSeed(seed, 0),
+                           (static_cast<std::int64_t>(rows_l) * thread_id) / num_threads,
+                           (static_cast<std::int64_t>(rows_l) * (thread_id + 1)) / num_threads);
+      mat_r->randomizeRows(rng::deriveSeed(seed, 1),
+                           (static_cast<std::int64_t>(rows_r) * thread_id) / num_threads,
+                           (static_cast<std::int64_t>(rows_r) * (thread_id + 1)) / num_threads);
+    });
+    mat_l->setAllRowsUsed();
+    mat_r->setAllRowsUsed();
+  }
+
   void MCTask::execute(int threadId, void *state) {
     int const allocSize = examples_->numElements()/total_threads_;
     int const start_index = allocSize * threadId;
@@ -15,14 +98,15 @@ namespace obamadb {
     double const mean = shared_state_->mean;
     double const step_size = shared_state_->step_size;
     double const mu = shared_state_->mu;
-    std::vector<int> const & degrees_l = shared_state_->degrees_l;
-    std::vector<int> const & degrees_r = shared_state_->degrees_r;
+    std::vector<int> const & degrees_l = shared_state_->statistics->degrees_l;
+    std::vector<int> const & degrees_r = shared_state_->statistics->degrees_r;
     DenseDataBlock<num_t>* mat_l = shared_state_->mat_l.get();
     DenseDataBlock<num_t>* mat_r = shared_state_->mat_r.get();
 
     dvector<num_t> lrow(0, nullptr);
     dvector<num_t> rrow(0, nullptr);
     dvector<num_t> lrow_temp;
+    INSTRUMENT(instrument::WriteTracker* tracker = instrument::tracker();)
 
     for (int i = start_index; i < end_index; i++) {
       MatrixEntry const &entry = examples_->get(i);
@@ -32,10 +116,25 @@ namespace obamadb {
 
       mat_l->getRowVectorFast(row_index, &lrow);
       mat_r->getRowVectorFast(col_index, &rrow);
+      INSTRUMENT(
+        bool const sampled = tracker != nullptr && tracker->beginUpdate(threadId);
+        if (sampled) {
+          tracker->read(threadId, lrow.values_, lrow.size());
+          tracker->read(threadId, rrow.values_, rrow.size());
+        })
 
       double err = ml::dot(lrow, rrow.values_) + mean - value;
       double e = -(step_size * err);
 
+      INSTRUMENT(
+        if (sampled) {
+          tracker->checkReads(threadId);
+        }
+        if (tracker != nullptr) {
+          tracker->write(threadId, lrow.values_, lrow.size());
+          tracker->write(threadId, rrow.values_, rrow.size());
+        })
+
       lrow_temp.copy(lrow);
       ml::scale(lrow_temp, (num_t) (1 - mu * step_size / ((double) degrees_l[row_index])));
       ml::scale_and_add(lrow_temp, rrow, e);
@@ -11,41 +11,45 @@
 
 namespace obamadb {
 
+  /**
+   * Statistics of a training matrix which the model updates need: the number of entries in
+   * each row and column, and the mean value. They depend only on the data, so they are
+   * computed once and shared by every trial.
+   */
+  struct MCStatistics {
+    /**
+     * Computes the statistics with a parallel histogram. Each thread counts its slice of the
+     * entries into private arrays, then the arrays are summed in parallel by index range.
+     */
+    MCStatistics(UnorderedMatrix const * training_matrix, int num_threads);
+
+    std::vector<int> degrees_l;
+    std::vector<int> degrees_r;
+    double mean;
+
+    DISABLE_COPY_AND_ASSIGN(MCStatistics);
+  };
+
   /**
    * There is a single MC state per set of matrix completion tasks.
    * Contains factorization info.
    */
   struct MCState {
-    MCState(UnorderedMatrix const * training_matrix, int rank)
-      : mu(-1),
-        step_size(0.001),
-        step_decay(0.9),
-        degrees_l(training_matrix->numRows(), 0),
-        degrees_r(training_matrix->numColumns(), 0),
-        mean(0),
-        rank(rank),
-        mat_l(nullptr),
-        mat_r(nullptr){
-      mat_l.reset(new DenseDataBlock<num_t>(training_matrix->numRows(), rank));
-      mat_r.reset(new DenseDataBlock<num_t>(training_matrix->numColumns(), rank));
-      mat_l->randomize();
-      mat_r->randomize();
-
-      double sum = 0;
-      for (int i = 0; i < training_matrix->numElements(); i++) {
-        MatrixEntry const & entry = training_matrix->get(i);
-        degrees_l[entry.row]++;
-        degrees_r[entry.column]++;
-        sum += entry.value;
-      }
-      mean = sum / training_matrix->numElements();
-    }
+    /**
+     * The factor matrices are randomized in parallel. Thread t writes the t-th slice of rows
+     * while bound to the core which the t-th worker of the next ThreadPool will get, so on
+     * NUMA machines the pages start out near the threads that use them. Row values come from
+     * counter based streams, so the model does not depend on the thread count.
+     */
+    MCState(UnorderedMatrix const * training_matrix,
+            std::shared_ptr<MCStatistics const> statistics,
+            int rank,
+            int num_threads);
 
     float mu;
     float step_size;
     float step_decay;
-    std::vector<int> degrees_l;
-    std::vector<int> degrees_r;
+    std::shared_ptr<MCStatistics const> statistics;
     double mean;
 
     int rank;
@@ -32,7 +32,7 @@ namespace obamadb {
     /**
      * Dot product
      */
-    num_t dot(const svector <num_t> &v1, num_t *d2) {
+    num_t dot(const svector <num_t> &v1, num_t const *d2) {
       num_t sum = 0;
       num_t const *const __restrict__ pv1 = v1.values_;
       int const *const __restrict__ pvi1 = v1.index_;
@@ -58,6 +58,71 @@ namespace obamadb {
         tptr[idx] = tptr[idx] + (vptr[i] * e);
       }
     }
+
+    num_t dot(num_t const *values, num_t const *theta, int size) {
+      // Separate sums break the dependency between additions, so the loop vectorizes without
+      // reassociating floating point math.
+      int const kLanes = 8;
+      num_t sums[kLanes] = {0};
+      num_t const *__restrict__ const pv = values;
+      num_t const *__restrict__ const pt = theta;
+      int i = 0;
+      for (; i + kLanes <= size; i += kLanes) {
+        for (int l = 0; l < kLanes; l++) {
+          sums[l] += pv[i + l] * pt[i + l];
+        }
+      }
+      num_t sum = 0;
+      for (; i < size; i++) {
+        sum += pv[i] * pt[i];
+      }
+      for (int l = 0; l < kLanes; l++) {
+        sum += sums[l];
+      }
+      return sum;
+    }
+
+    void scale_and_add(num_t *theta, num_t const *delta, int size, const num_t e) {
+      num_t *__restrict__ const tptr = theta;
+      num_t const *__restrict__ const dptr = delta;
+      for (int i = 0; i < size; i++) {
+        tptr[i] += dptr[i] * e;
+      }
+    }
+
+    double fractionMisclassified(num_t const *theta, std::vector<SparseDataBlock<num_t> *> const &blocks) {
+      long total_misclassified = 0;
+      long total_examples = 0;
+      svector<num_t> row(0, nullptr);
+      for (int i = 0; i < blocks.size(); i++) {
+        SparseDataBlock<num_t> const &block = *blocks[i];
+        for (int j = 0; j < block.getNumRows(); j++) {
+          block.getRowVectorFast(j, &row);
+          const num_t dot_prod = dot(row, theta);
+          const num_t classification = *row.getClassification();
+          DCHECK(classification == 1 || classification == -1) << "Expected binary classification.";
+          total_misclassified += (classification == 1 && dot_prod < 0) || (classification == -1 && dot_prod >= 0);
+        }
+        total_examples += block.getNumRows();
+      }
+      return (double) total_misclassified / (double) total_examples;
+    }
+
+    double rmse(num_t const *theta, std::vector<SparseDataBlock<num_t> *> const &blocks) {
+      double sq_err = 0;
+      long total_examples = 0;
+      svector<num_t> row(0, nullptr);
+      for (int i = 0; i < blocks.size(); i++) {
+        SparseDataBlock<num_t> const &block = *blocks[i];
+        for (int j = 0; j < block.getNumRows(); j++) {
+          block.getRowVectorFast(j, &row);
+          double const err = dot(row, theta) - *row.getClassification();
+          sq_err += err * err;
+        }
+        total_examples += block.getNumRows();
+      }
+      return std::sqrt(sq_err / total_examples);
+    }
   }  // namespace ml
 
 } // namespace obamadb
\ No newline at end of file
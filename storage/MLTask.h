@@ -1,7 +1,10 @@
 #ifndef OBAMADB_MLTASK_H
 #define OBAMADB_MLTASK_H
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <mutex>
 
 #include "storage/DataBlock.h"
@@ -21,7 +24,7 @@ namespace obamadb {
     /**
      * Sparse dot product
      */
-    num_t dot(const svector <num_t> &v1, num_t *d2);
+    num_t dot(const svector <num_t> &v1, num_t const *d2);
 
     void scale(dvector <num_t> &v1, num_t e);
 
@@ -35,11 +38,63 @@ namespace obamadb {
      */
     void scale_and_add(num_t *theta, const svector <num_t> &delta, const num_t e);
 
+    /**
+     * Dot product of contiguous values, like the rows of a dense block.
+     */
+    num_t dot(num_t const *values, num_t const *theta, int size);
+
+    /**
+     * Scale and add of contiguous values, like the rows of a dense block.
+     */
+    void scale_and_add(num_t *theta, num_t const *delta, int size, const num_t e);
+
+    /**
+     * Approximates e^x. The integral part of x*log2(e) is written directly into the exponent
+     * bits of a float and the fractional part is covered by a 4th degree polynomial fit of 2^f.
+     * Relative error is around 1e-5 over the range of a float, which is plenty for a gradient.
+     */
+    inline float fast_exp(float x) {
+      x = std::min(std::max(x, -87.0f), 88.0f);
+      float const t = x * 1.442695041f;
+      float const ipart = std::floor(t);
+      float const f = t - ipart;
+      float const pow2f =
+        1.000005256f + f * (0.692974285f + f * (0.241508801f + f * (0.051989599f + f * 0.013511545f)));
+      std::int32_t const exponent = (static_cast<std::int32_t>(ipart) + 127) << 23;
+      float pow2i;
+      memcpy(&pow2i, &exponent, sizeof(float));
+      return pow2f * pow2i;
+    }
+
+    /**
+     * Logistic function 1 / (1 + e^-x) built on fast_exp.
+     */
+    inline float fast_sigmoid(float x) {
+      return 1.0f / (1.0f + fast_exp(-x));
+    }
+
+    /**
+     * Gets the fraction of misclassified examples for a linear model over (-1,1) labeled data.
+     * @param theta The trained weights.
+     * @param blocks A sample of the data.
+     * @return Fraction of misclassified examples.
+     */
+    double fractionMisclassified(num_t const *theta, std::vector<SparseDataBlock<num_t> *> const &blocks);
+
+    /**
+     * Root mean squared error of a linear model's predictions w.x of the row labels.
+     * @param theta The trained weights.
+     * @param blocks A sample of the data.
+     */
+    double rmse(num_t const *theta, std::vector<SparseDataBlock<num_t> *> const &blocks);
+
   }  // namespace ml
 
   enum class MLAlgorithm {
     kSVM,
-    kMC
+    kMC,
+    kLR,
+    kLS
   };
 
   class MLTask {
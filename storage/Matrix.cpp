@@ -1,9 +1,62 @@
+#include <atomic>
+#include <cstdint>
 #include <iostream>
 
 #include "storage/Matrix.h"
 
 namespace obamadb {
 
+  ColumnStatistics const & Matrix::columnStatistics(int num_threads) const {
+    std::lock_guard<std::mutex> lock(column_statistics_lock_);
+    if (!column_statistics_) {
+      column_statistics_.reset(computeColumnStatistics(num_threads));
+    }
+    return *column_statistics_;
+  }
+
+  ColumnStatistics* Matrix::computeColumnStatistics(int num_threads) const {
+    ColumnStatistics* statistics = new ColumnStatistics();
+    statistics->degrees.resize(numColumns_, 0);
+    num_threads = std::max<int>(1, std::min<int>(num_threads, blocks_.size()));
+
+    std::vector<std::vector<int>> partial_degrees(num_threads);
+    std::atomic<int> next_block(0);
+    threading::barrier_t counted(num_threads);
+    threading::runThreads(num_threads, [&](int thread_id) {
+      // Blocks are handed out one at a time, which balances blocks of different density.
+      std::vector<int> & degrees = partial_degrees[thread_id];
+      degrees.resize(numColumns_, 0);
+      svector<num_t> row(0, nullptr);
+      for (int b = next_block++; b < blocks_.size(); b = next_block++) {
+        SparseDataBlock<num_t> const & block = *blocks_[b];
+        for (int i = 0; i < block.getNumRows(); i++) {
+          block.getRowVectorFast(i, &row);
+          if (block.isDense()) {
+            // Rows of dense blocks have zeros filled in, which do not add to a degree.
+            for (int j = 0; j < row.numElements(); j++) {
+              degrees[row.index_[j]] += row.values_[j] != 0;
+            }
+            continue;
+          }
+          for (int j = 0; j < row.numElements(); j++) {
+            degrees[row.index_[j]]++;
+          }
+        }
+      }
+      counted.wait();
+
+      // Each thread sums a range of columns across the partial histograms.
+      std::int64_t const first = (static_cast<std::int64_t>(numColumns_) * thread_id) / num_threads;
+      std::int64_t const last = (static_cast<std::int64_t>(numColumns_) * (thread_id + 1)) / num_threads;
+      for (std::vector<int> const & partial : partial_degrees) {
+        for (std::int64_t c = first; c < last; c++) {
+          statistics->degrees[c] += partial[c];
+        }
+      }
+    });
+    return statistics;
+  }
+
   std::ostream& operator<<(std::ostream& os, const Matrix& matrix)
   {
     os << "Matrix: (" << matrix.numRows_ << ", " << matrix.numColumns_ << ") "
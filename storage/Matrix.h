@@ -1,7 +1,9 @@
 #ifndef OBAMADB_MATRIX_H
 #define OBAMADB_MATRIX_H
 
+#include "storage/BlockStatistics.h"
 #include "storage/exvector.h"
+#include "storage/Random.h"
 #include "storage/SparseDataBlock.h"
 #include "storage/StorageConstants.h"
 #include "storage/ThreadPool.h"
@@ -13,6 +15,14 @@
 
 namespace obamadb {
 
+  /**
+   * Per column statistics of a Matrix.
+   */
+  struct ColumnStatistics {
+    // The number of rows with a non-zero value in each column.
+    std::vector<int> degrees;
+  };
+
   class Matrix {
   public:
     /**
@@ -21,7 +31,10 @@ namespace obamadb {
     Matrix(const std::vector<SparseDataBlock<num_t> *> &blocks)
       : numColumns_(0),
         numRows_(0),
-        blocks_() {
+        blocks_(),
+        block_statistics_(),
+        column_statistics_(),
+        column_statistics_lock_() {
       for (int i = 0; i < blocks.size(); i++) {
         addBlock(blocks[i]);
       }
@@ -33,7 +46,10 @@ namespace obamadb {
     Matrix()
       : numColumns_(0),
         numRows_(0),
-        blocks_() {}
+        blocks_(),
+        block_statistics_(),
+        column_statistics_(),
+        column_statistics_lock_() {}
 
     ~Matrix() {
       for(auto block : blocks_) {
@@ -55,6 +71,8 @@ namespace obamadb {
       }
       numRows_ += block->getNumRows();
       blocks_.push_back(block);
+      block_statistics_.push_back(BlockStatistics::Of(*block));
+      column_statistics_.reset();
     }
 
     /**
@@ -78,6 +96,7 @@ namespace obamadb {
           max_feat_idx = src.index_[src.num_elements_ - 1];
         }
         if (!dst->appendRow(src)) {
+          dst->finalize();
           blocks.push_back(dst);
           dst = new SparseDataBlock<num_t>();
           CHECK(dst->appendRow(src));
@@ -85,11 +104,12 @@ namespace obamadb {
       };
 
       // sample evenly across the blocks.
+      rng::Xoshiro256 & generator = rng::threadLocal();
       svector<num_t> rand_row(0, nullptr);
       SparseDataBlock<num_t> * curr_block = new SparseDataBlock<num_t>();
       for(auto & block : this->blocks_) {
         for (int row = 0; row < rows_per_block; row++) {
-          int rrow = rand() % block->num_rows_;
+          int rrow = generator.nextInt(block->num_rows_);
           block->getRowVectorFast(rrow, &rand_row);
           insertInto(rand_row, curr_block);
           total_sampled++;
@@ -98,9 +118,9 @@ namespace obamadb {
 
       // cap off the sample to remove rounding error
       while (total_sampled < expected_sample) {
-        int rblock = static_cast<int>(rand() % blocks_.size());
+        int rblock = static_cast<int>(generator.nextInt(blocks_.size()));
         auto & block = this->blocks_[rblock];
-        int rrow = rand() % block->num_rows_;
+        int rrow = generator.nextInt(block->num_rows_);
         block->getRowVectorFast(rrow, &rand_row);
         insertInto(rand_row, curr_block);
         total_sampled++;
@@ -122,6 +142,7 @@ namespace obamadb {
             break;
         }
       }
+      curr_block->finalize();
       blocks.push_back(curr_block);
       Matrix* matrix = new Matrix(blocks);
       CHECK_EQ(matrix->numColumns_, this->numColumns_);
@@ -134,11 +155,16 @@ namespace obamadb {
      * @param row Row to append
      */
     void addRow(const svector<num_t> &row) {
-      if(blocks_.size() == 0 || !blocks_.back()->appendRow(row)) {
+      if(blocks_.size() == 0 || !blocks_.back()->initializing_ || !blocks_.back()->appendRow(row)) {
+        if (blocks_.size() > 0) {
+          blocks_.back()->finalize();
+        }
         blocks_.push_back(new SparseDataBlock<num_t>());
+        block_statistics_.push_back(BlockStatistics());
         bool appended = blocks_.back()->appendRow(row);
         DCHECK(appended);
       }
+      block_statistics_.back().addRow(row);
 
       if (row.size() > numColumns_) {
         numColumns_ = row.size();
@@ -148,6 +174,7 @@ namespace obamadb {
       }
 
       numRows_++;
+      column_statistics_.reset();
     }
 
     struct PMultiState {
@@ -177,15 +204,17 @@ namespace obamadb {
      * @param matrixSizeBytes The approximate size of the resulting matrix.
      * @param numColumns The number of columns for the matrix to have.
      * @param sparsity The sparsity of the matrix.
+     * @param seed
      * @return A caller-owned sparse matrix.
      */
-    static Matrix* GetRandomMatrix(int matrixSizeBytes, int numColumns, double sparsity) {
+    static Matrix* GetRandomMatrix(int matrixSizeBytes, int numColumns, double sparsity, std::uint64_t seed) {
       Matrix* matrix = new Matrix();
       int totalDataSizeBytes = 0;
       while(totalDataSizeBytes < matrixSizeBytes) {
-        int sizeNextBlockBytes = std::min(matrixSizeBytes - totalDataSizeBytes, (int)kStorageBlockSize);
+        int sizeNextBlockBytes = std::min(matrixSizeBytes - totalDataSizeBytes, (int)storageBlockSize());
         matrix->addBlock(
-          GetRandomSparseDataBlock(sizeNextBlockBytes, numColumns, sparsity));
+          GetRandomSparseDataBlock(sizeNextBlockBytes, numColumns, sparsity,
+                                   rng::deriveSeed(seed, matrix->blocks_.size())));
         totalDataSizeBytes += sizeNextBlockBytes;
       }
       return matrix;
@@ -195,26 +224,42 @@ namespace obamadb {
      * @return Fraction of elements which are zero.
      */
     double getSparsity() const {
-      std::uint64_t nnz = 0;
+      std::uint64_t nnz = getNNZ();
       std::uint64_t numElements = static_cast<std::uint64_t >(numColumns_) * static_cast<std::uint64_t >(numRows_);
-      for (auto block : blocks_) {
-        nnz += block->numNonZeroElements();
-      }
       return (double ) (numElements - nnz) / (double) numElements;
     }
 
     /**
-     * Number of non-zero elements
+     * Number of non-zero elements. Read from the block statistics rather than the rows.
      * @return
      */
-    int getNNZ() const {
-      int nnz = 0;
-      for (auto block : blocks_) {
-        nnz += block->numNonZeroElements();
+    std::uint64_t getNNZ() const {
+      std::uint64_t nnz = 0;
+      for (BlockStatistics const & statistics : block_statistics_) {
+        nnz += statistics.nnz;
       }
       return nnz;
     }
 
+    /**
+     * @return One more than the largest column index of any non-zero element. Read from the
+     *    block statistics rather than the blocks.
+     */
+    int maxColumns() const {
+      int max_column = -1;
+      for (BlockStatistics const & statistics : block_statistics_) {
+        max_column = std::max(max_column, statistics.max_column);
+      }
+      return max_column + 1;
+    }
+
+    /**
+     * @return The statistics of each block, in the order of blocks_.
+     */
+    std::vector<BlockStatistics> const & blockStatistics() const {
+      return block_statistics_;
+    }
+
     /**
      * @return The total size of the owned data.
      */
@@ -226,12 +271,27 @@ namespace obamadb {
       return size;
     }
 
+    /**
+     * The statistics are computed on first use with a parallel histogram over the blocks and
+     * then kept with the matrix, so later callers, like every trial of an experiment, get them
+     * for free. Adding rows or blocks discards them.
+     * @param num_threads Threads to compute the statistics with if they are not cached.
+     */
+    ColumnStatistics const & columnStatistics(int num_threads) const;
+
     friend std::ostream& operator<<(std::ostream& os, const Matrix& matrix);
 
     int numColumns_;
     int numRows_;
     std::vector<SparseDataBlock<num_t>*> blocks_;
 
+  private:
+    ColumnStatistics* computeColumnStatistics(int num_threads) const;
+
+    std::vector<BlockStatistics> block_statistics_;
+    mutable std::unique_ptr<ColumnStatistics> column_statistics_;
+    mutable std::mutex column_statistics_lock_;
+
     DISABLE_COPY_AND_ASSIGN(Matrix);
   };
 
@@ -0,0 +1,144 @@
+#include "storage/MemoryAccounting.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <sys/resource.h>
+
+#include "glog/logging.h"
+
+DEFINE_bool(memory_report, false, "Print the memory held by the training data, test data, model and scratch"
+  " space after loading and after each trial, with the peak of each along the way.");
+
+namespace obamadb {
+
+  namespace memory {
+
+    namespace {
+      char const * const kSubsystemNames[kNumSubsystems] = {"training_data", "test_data", "model", "scratch"};
+
+      // Precedes each allocation. Sized to keep the memory after it aligned like operator new.
+      struct alignas(alignof(std::max_align_t)) Header {
+        std::size_t bytes;
+        Subsystem subsystem;
+      };
+
+      thread_local Subsystem current_subsystem = kScratch;
+      std::atomic<std::int64_t> current_bytes[kNumSubsystems];
+      std::atomic<std::int64_t> peak_bytes[kNumSubsystems];
+      std::atomic<std::int64_t> total_current_bytes(0);
+      std::atomic<std::int64_t> total_peak_bytes(0);
+      std::string phase_name = "start";
+
+      void raisePeak(std::atomic<std::int64_t> * peak, std::int64_t value) {
+        std::int64_t seen = peak->load(std::memory_order_relaxed);
+        while (value > seen && !peak->compare_exchange_weak(seen, value, std::memory_order_relaxed)) { }
+      }
+
+      std::string formatBytes(std::int64_t bytes) {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.1fMB", bytes / 1e6);
+        return buffer;
+      }
+    }
+
+    char const * subsystemName(Subsystem subsystem) {
+      return kSubsystemNames[subsystem];
+    }
+
+    Subsystem current() {
+      return current_subsystem;
+    }
+
+    SubsystemScope::SubsystemScope(Subsystem subsystem)
+      : previous_(current_subsystem) {
+      current_subsystem = subsystem;
+    }
+
+    SubsystemScope::~SubsystemScope() {
+      current_subsystem = previous_;
+    }
+
+    void add(Subsystem subsystem, std::int64_t bytes) {
+      std::int64_t const now = current_bytes[subsystem].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+      std::int64_t const total = total_current_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+      if (bytes > 0) {
+        raisePeak(&peak_bytes[subsystem], now);
+        raisePeak(&total_peak_bytes, total);
+      }
+    }
+
+    void* allocate(std::size_t bytes) {
+      Header* header = static_cast<Header*>(malloc(sizeof(Header) + bytes));
+      if (header == nullptr) {
+        throw std::bad_alloc();
+      }
+      header->bytes = bytes;
+      header->subsystem = current();
+      add(header->subsystem, bytes);
+      return header + 1;
+    }
+
+    void release(void * ptr) {
+      if (ptr == nullptr) {
+        return;
+      }
+      Header* header = static_cast<Header*>(ptr) - 1;
+      add(header->subsystem, -static_cast<std::int64_t>(header->bytes));
+      free(header);
+    }
+
+    Usage usage() {
+      Usage usage;
+      for (int s = 0; s < kNumSubsystems; s++) {
+        usage.current[s] = current_bytes[s].load();
+        usage.peak[s] = peak_bytes[s].load();
+      }
+      usage.total_current = total_current_bytes.load();
+      usage.total_peak = total_peak_bytes.load();
+      return usage;
+    }
+
+    void beginPhase(char const * name) {
+      phase_name = name;
+      for (int s = 0; s < kNumSubsystems; s++) {
+        peak_bytes[s].store(current_bytes[s].load());
+      }
+      total_peak_bytes.store(total_current_bytes.load());
+    }
+
+    void printPhase() {
+      Usage const now = usage();
+      std::string line;
+      for (int s = 0; s < kNumSubsystems; s++) {
+        line += ", " + std::string(kSubsystemNames[s]) + " " + formatBytes(now.current[s])
+                + " (peak " + formatBytes(now.peak[s]) + ")";
+      }
+      std::int64_t const rss = peakResidentBytes();
+      printf("[MEMORY] %s%s, total %s (peak %s), process peak rss %s\n",
+             phase_name.c_str(),
+             line.c_str(),
+             formatBytes(now.total_current).c_str(),
+             formatBytes(now.total_peak).c_str(),
+             rss < 0 ? "n/a" : formatBytes(rss).c_str());
+    }
+
+    std::int64_t peakResidentBytes() {
+      rusage resource_usage;
+      if (getrusage(RUSAGE_SELF, &resource_usage) != 0) {
+        return -1;
+      }
+      // Kilobytes on Linux, bytes on macOS.
+#ifdef __APPLE__
+      return resource_usage.ru_maxrss;
+#else
+      return static_cast<std::int64_t>(resource_usage.ru_maxrss) * 1024;
+#endif
+    }
+
+  } // namespace memory
+
+} // namespace obamadb
@@ -0,0 +1,112 @@
+#ifndef OBAMADB_MEMORYACCOUNTING_H
+#define OBAMADB_MEMORYACCOUNTING_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <gflags/gflags.h>
+
+DECLARE_bool(memory_report);
+
+namespace obamadb {
+
+  /**
+   * Counts the bytes held by data blocks, matrices, vectors and models, split by what they are
+   * used for, so that the memory a run needs can be planned for.
+   */
+  namespace memory {
+
+    enum Subsystem {
+      kTrainingData = 0,
+      kTestData,
+      kModel,
+      // Everything else, e.g. the rows a worker copies out while training.
+      kScratch,
+      kNumSubsystems
+    };
+
+    /**
+     * @return A lower case name for the subsystem, e.g. "training_data".
+     */
+    char const * subsystemName(Subsystem subsystem);
+
+    /**
+     * @return The subsystem the calling thread's allocations are attributed to right now.
+     */
+    Subsystem current();
+
+    /**
+     * Attributes every allocation the calling thread makes while it lives to a subsystem. Other
+     * threads, like background writers, keep their own, so threads which work on behalf of a
+     * scope, like the workers of threading::runThreads, open one of their own. Scopes nest.
+     */
+    class SubsystemScope {
+    public:
+      explicit SubsystemScope(Subsystem subsystem);
+
+      ~SubsystemScope();
+
+    private:
+      Subsystem const previous_;
+
+      // Utils.h includes this file, so DISABLE_COPY_AND_ASSIGN is not available here.
+      SubsystemScope & operator=(const SubsystemScope&) = delete;
+      SubsystemScope(const SubsystemScope&) = delete;
+    };
+
+    /**
+     * Counts bytes taken, or given back if negative, by a subsystem. For memory which is not
+     * allocated through allocate, like mapped regions.
+     */
+    void add(Subsystem subsystem, std::int64_t bytes);
+
+    /**
+     * Allocates memory which is counted against the current subsystem until it is released.
+     * Aligned like operator new.
+     */
+    void* allocate(std::size_t bytes);
+
+    /**
+     * Frees memory from allocate. Null is ignored.
+     */
+    void release(void * ptr);
+
+    template<class T>
+    T* allocateArray(std::size_t count) {
+      return static_cast<T*>(allocate(sizeof(T) * count));
+    }
+
+    struct Usage {
+      std::int64_t current[kNumSubsystems];
+      // Highest since the phase began.
+      std::int64_t peak[kNumSubsystems];
+      std::int64_t total_current;
+      std::int64_t total_peak;
+    };
+
+    /**
+     * @return The bytes held now, and the most held at once since the phase began.
+     */
+    Usage usage();
+
+    /**
+     * Starts a new phase, e.g. loading or training. Peaks restart from the current usage.
+     */
+    void beginPhase(char const * name);
+
+    /**
+     * Prints the current and peak bytes of every subsystem during the phase, along with the
+     * peak resident size of the process, which also covers memory not counted here.
+     */
+    void printPhase();
+
+    /**
+     * @return The peak resident set size of the process in bytes, or -1 if it is not known.
+     */
+    std::int64_t peakResidentBytes();
+
+  } // namespace memory
+
+} // namespace obamadb
+
+#endif //OBAMADB_MEMORYACCOUNTING_H
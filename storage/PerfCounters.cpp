@@ -0,0 +1,197 @@
+#include "storage/PerfCounters.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "glog/logging.h"
+
+DEFINE_bool(perf_counters, false, "Count cycles, instructions, LLC misses, dTLB misses and HITM loads of"
+  " every worker with perf_event_open and print them per epoch. Needs perf_event_paranoid <= 2.");
+DEFINE_string(perf_hitm_event, "0x04d2", "The raw perf event counting loads which hit a line modified by"
+  " another core. The default is MEM_LOAD_L3_HIT_RETIRED.XSNP_HITM on recent Intel cores. Empty to skip.");
+
+namespace obamadb {
+
+  namespace perf {
+
+    namespace {
+      char const * const kEventNames[kNumEvents] = {"cycles", "instructions", "llc_misses", "dtlb_misses", "hitm"};
+
+      std::once_flag unavailable_warning;
+
+#ifdef __linux__
+      int openEvent(Event event) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        switch (event) {
+          case kCycles:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+          case kInstructions:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+          case kLLCMisses:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+          case kDTLBMisses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_DTLB
+                          | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                          | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+          case kHITM:
+            if (FLAGS_perf_hitm_event.empty()) {
+              return -1;
+            }
+            attr.type = PERF_TYPE_RAW;
+            attr.config = std::strtoull(FLAGS_perf_hitm_event.c_str(), nullptr, 0);
+            break;
+          default:
+            return -1;
+        }
+
+        // This thread, any cpu, no group.
+        return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+      }
+#endif
+    }
+
+    ThreadCounters::ThreadCounters() {
+      int opened = 0;
+      int error = ENOSYS;
+      for (int e = 0; e < kNumEvents; e++) {
+#ifdef __linux__
+        fds_[e] = openEvent(static_cast<Event>(e));
+        if (fds_[e] >= 0) {
+          opened++;
+        } else if (e != kHITM) {
+          error = errno;
+        }
+#else
+        fds_[e] = -1;
+#endif
+      }
+      if (opened == 0) {
+        std::call_once(unavailable_warning, [error]() {
+          if (error == EACCES || error == EPERM) {
+            LOG(WARNING) << "Not permitted to open hardware counters, see"
+                         << " /proc/sys/kernel/perf_event_paranoid. Counting is disabled.";
+          } else {
+            LOG(WARNING) << "Hardware counters are not available: " << strerror(error)
+                         << ". Counting is disabled.";
+          }
+        });
+      }
+    }
+
+    ThreadCounters::~ThreadCounters() {
+#ifdef __linux__
+      for (int e = 0; e < kNumEvents; e++) {
+        if (fds_[e] >= 0) {
+          close(fds_[e]);
+        }
+      }
+#endif
+    }
+
+    void ThreadCounters::start() {
+#ifdef __linux__
+      for (int e = 0; e < kNumEvents; e++) {
+        if (fds_[e] >= 0) {
+          ioctl(fds_[e], PERF_EVENT_IOC_RESET, 0);
+          ioctl(fds_[e], PERF_EVENT_IOC_ENABLE, 0);
+        }
+      }
+#endif
+    }
+
+    Sample ThreadCounters::stop() {
+      Sample sample;
+#ifdef __linux__
+      for (int e = 0; e < kNumEvents; e++) {
+        if (fds_[e] >= 0) {
+          ioctl(fds_[e], PERF_EVENT_IOC_DISABLE, 0);
+        }
+      }
+      for (int e = 0; e < kNumEvents; e++) {
+        // value, time enabled, time running
+        std::uint64_t counts[3];
+        if (fds_[e] < 0 || read(fds_[e], counts, sizeof(counts)) != sizeof(counts) || counts[2] == 0) {
+          continue;
+        }
+        sample.values[e] = counts[2] == counts[1]
+                           ? counts[0]
+                           : static_cast<std::uint64_t>(static_cast<double>(counts[0]) * counts[1] / counts[2]);
+        sample.valid[e] = true;
+      }
+#endif
+      return sample;
+    }
+
+    char const * eventName(Event event) {
+      return kEventNames[event];
+    }
+
+    Sample sum(std::vector<Sample> const & samples) {
+      Sample total;
+      for (int e = 0; e < kNumEvents; e++) {
+        total.valid[e] = !samples.empty();
+      }
+      for (Sample const & sample : samples) {
+        for (int e = 0; e < kNumEvents; e++) {
+          total.values[e] += sample.values[e];
+          total.valid[e] = total.valid[e] && sample.valid[e];
+        }
+      }
+      return total;
+    }
+
+    void printEpoch(int epoch, std::vector<Sample> const & samples) {
+      auto print = [epoch](char const * thread, Sample const & sample) {
+        std::string line;
+        char buffer[64];
+        for (int e = 0; e < kNumEvents; e++) {
+          if (sample.valid[e]) {
+            snprintf(buffer, sizeof(buffer), ", %s %llu", kEventNames[e],
+                     static_cast<unsigned long long>(sample.values[e]));
+          } else {
+            snprintf(buffer, sizeof(buffer), ", %s n/a", kEventNames[e]);
+          }
+          line += buffer;
+        }
+        if (sample.valid[kCycles] && sample.valid[kInstructions] && sample.values[kCycles] > 0) {
+          snprintf(buffer, sizeof(buffer), ", ipc %.2f",
+                   static_cast<double>(sample.values[kInstructions]) / sample.values[kCycles]);
+          line += buffer;
+        }
+        printf("[PERF] epoch %d, thread %s%s\n", epoch, thread, line.c_str());
+      };
+
+      for (int t = 0; t < samples.size(); t++) {
+        print(std::to_string(t).c_str(), samples[t]);
+      }
+      print("all", sum(samples));
+    }
+
+  } // namespace perf
+
+} // namespace obamadb
@@ -0,0 +1,97 @@
+#ifndef OBAMADB_PERFCOUNTERS_H
+#define OBAMADB_PERFCOUNTERS_H
+
+#include "storage/Utils.h"
+
+#include <cstdint>
+#include <vector>
+
+#include <gflags/gflags.h>
+
+DECLARE_bool(perf_counters);
+DECLARE_string(perf_hitm_event);
+
+namespace obamadb {
+
+  /**
+   * Hardware performance counters read with perf_event_open.
+   */
+  namespace perf {
+
+    enum Event {
+      kCycles = 0,
+      kInstructions,
+      // Last level cache misses.
+      kLLCMisses,
+      // Loads which missed every level of the data TLB.
+      kDTLBMisses,
+      // Loads which hit a line modified in another core's cache. There is no generic perf event
+      // for it, so it is a raw, model specific event given by -perf_hitm_event.
+      kHITM,
+      kNumEvents
+    };
+
+    /**
+     * Counts of one thread over one interval. Events the machine or the permissions do not
+     * allow are marked invalid.
+     */
+    struct Sample {
+      Sample() {
+        for (int e = 0; e < kNumEvents; e++) {
+          values[e] = 0;
+          valid[e] = false;
+        }
+      }
+
+      std::uint64_t values[kNumEvents];
+      bool valid[kNumEvents];
+    };
+
+    /**
+     * The counters of the thread which constructs it. If counters cannot be opened, for example
+     * because perf_event_paranoid forbids it, a warning is logged once and every sample comes
+     * back invalid, so callers need not care whether counting works.
+     */
+    class ThreadCounters {
+    public:
+      ThreadCounters();
+
+      ~ThreadCounters();
+
+      /**
+       * Zeroes and starts the counters.
+       */
+      void start();
+
+      /**
+       * Stops the counters.
+       * @return The counts since start. Scaled up if the kernel had to multiplex the counters.
+       */
+      Sample stop();
+
+    private:
+      int fds_[kNumEvents];
+
+      DISABLE_COPY_AND_ASSIGN(ThreadCounters);
+    };
+
+    /**
+     * @return The event's name as printed, e.g. "llc_misses".
+     */
+    char const * eventName(Event event);
+
+    /**
+     * @return The counts of all the samples added up. An event is only valid if it is in every sample.
+     */
+    Sample sum(std::vector<Sample> const & samples);
+
+    /**
+     * Prints the counts of each thread for an epoch, and their total.
+     */
+    void printEpoch(int epoch, std::vector<Sample> const & samples);
+
+  } // namespace perf
+
+} // namespace obamadb
+
+#endif //OBAMADB_PERFCOUNTERS_H
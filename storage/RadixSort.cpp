@@ -0,0 +1,234 @@
+#include "storage/RadixSort.h"
+
+#include "storage/ThreadPool.h"
+#include "storage/Utils.h"
+
+#include <algorithm>
+
+#include "glog/logging.h"
+
+namespace obamadb {
+
+  namespace sorting {
+
+    namespace {
+      int const kRadixBits = 8;
+      int const kRadixBuckets = 1 << kRadixBits;
+
+      // Entries buffered per bucket before they are written out. 16 entries are three cache
+      // lines and 16 keys are two, so with 256 buckets a thread's buffers take 80KB.
+      int const kBufferedEntries = 16;
+
+      /**
+       * A thread's software write-combining buffers for a scatter, one per output bucket.
+       */
+      class WriteCombiner {
+      public:
+        WriteCombiner(int num_buckets, bool with_keys)
+          : entries_(num_buckets * kBufferedEntries),
+            keys_(with_keys ? num_buckets * kBufferedEntries : 0),
+            counts_(num_buckets, 0),
+            offsets_(num_buckets, 0),
+            keys_out_(nullptr),
+            entries_out_(nullptr) { }
+
+        /**
+         * Starts a scatter.
+         * @param offsets Where this thread's first entry of each bucket goes.
+         * @param keys_out Output keys. May be null if there are no keys.
+         * @param entries_out Output entries.
+         */
+        void begin(std::vector<std::size_t> const & offsets,
+                   std::uint64_t* keys_out,
+                   MatrixEntry* entries_out) {
+          offsets_ = offsets;
+          keys_out_ = keys_out;
+          entries_out_ = entries_out;
+        }
+
+        inline void write(int bucket, MatrixEntry const & entry) {
+          int const slot = bucket * kBufferedEntries + counts_[bucket];
+          entries_[slot] = entry;
+          if (++counts_[bucket] == kBufferedEntries) {
+            flush(bucket);
+          }
+        }
+
+        inline void write(int bucket, std::uint64_t key, MatrixEntry const & entry) {
+          keys_[bucket * kBufferedEntries + counts_[bucket]] = key;
+          write(bucket, entry);
+        }
+
+        /**
+         * Writes out whatever is left in the buffers. Ends a scatter.
+         */
+        void flushAll() {
+          for (int bucket = 0; bucket < counts_.size(); bucket++) {
+            flush(bucket);
+          }
+        }
+
+      private:
+        void flush(int bucket) {
+          int const count = counts_[bucket];
+          MatrixEntry const * buffered = &entries_[bucket * kBufferedEntries];
+          std::copy(buffered, buffered + count, entries_out_ + offsets_[bucket]);
+          if (keys_out_ != nullptr) {
+            std::uint64_t const * buffered_keys = &keys_[bucket * kBufferedEntries];
+            std::copy(buffered_keys, buffered_keys + count, keys_out_ + offsets_[bucket]);
+          }
+          offsets_[bucket] += count;
+          counts_[bucket] = 0;
+        }
+
+        std::vector<MatrixEntry> entries_;
+        std::vector<std::uint64_t> keys_;
+        std::vector<int> counts_;
+        std::vector<std::size_t> offsets_;
+        std::uint64_t* keys_out_;
+        MatrixEntry* entries_out_;
+
+        DISABLE_COPY_AND_ASSIGN(WriteCombiner);
+      };
+
+      /**
+       * Computes where a thread's first entry of each bucket goes. Buckets are laid out in
+       * order and, within a bucket, threads are laid out in order, which keeps the scatter stable.
+       * @return The size of the largest bucket.
+       */
+      std::size_t threadOffsets(std::vector<std::vector<std::size_t>> const & histograms,
+                                int thread_id,
+                                std::vector<std::size_t>* offsets) {
+        std::size_t const num_buckets = offsets->size();
+        std::size_t offset = 0;
+        std::size_t largest_bucket = 0;
+        for (std::size_t b = 0; b < num_buckets; b++) {
+          std::size_t bucket_size = 0;
+          for (int t = 0; t < histograms.size(); t++) {
+            if (t == thread_id) {
+              (*offsets)[b] = offset + bucket_size;
+            }
+            bucket_size += histograms[t][b];
+          }
+          largest_bucket = std::max(largest_bucket, bucket_size);
+          offset += bucket_size;
+        }
+        return largest_bucket;
+      }
+
+      std::vector<std::size_t> sliceBounds(std::size_t num_entries, int num_threads) {
+        std::vector<std::size_t> bounds(num_threads + 1);
+        for (int t = 0; t <= num_threads; t++) {
+          bounds[t] = (num_entries * t) / num_threads;
+        }
+        return bounds;
+      }
+    }
+
+    bool radixSort(std::uint64_t* keys,
+                   MatrixEntry* entries,
+                   std::uint64_t* keys_scratch,
+                   MatrixEntry* entries_scratch,
+                   std::size_t num_entries,
+                   int key_bits,
+                   int num_threads) {
+      CHECK_GT(num_threads, 0);
+      CHECK_LE(key_bits, 64);
+      if (num_entries < 2) {
+        return false;
+      }
+      num_threads = std::min<std::size_t>(num_threads, num_entries);
+
+      std::vector<std::size_t> const bounds = sliceBounds(num_entries, num_threads);
+      std::vector<std::vector<std::size_t>> histograms(num_threads, std::vector<std::size_t>(kRadixBuckets));
+      threading::barrier_t barrier(num_threads);
+      std::vector<int> passes(num_threads, 0);
+
+      threading::runThreads(num_threads, [&](int thread_id) {
+        std::uint64_t* keys_in = keys;
+        std::uint64_t* keys_out = keys_scratch;
+        MatrixEntry* entries_in = entries;
+        MatrixEntry* entries_out = entries_scratch;
+        std::size_t const begin = bounds[thread_id];
+        std::size_t const end = bounds[thread_id + 1];
+        std::vector<std::size_t> & histogram = histograms[thread_id];
+        std::vector<std::size_t> offsets(kRadixBuckets);
+        WriteCombiner combiner(kRadixBuckets, true);
+
+        for (int shift = 0; shift < key_bits; shift += kRadixBits) {
+          std::fill(histogram.begin(), histogram.end(), 0);
+          for (std::size_t i = begin; i < end; i++) {
+            histogram[(keys_in[i] >> shift) & (kRadixBuckets - 1)]++;
+          }
+          barrier.wait();
+
+          // Every thread reaches the same conclusion, so they all skip the pass together.
+          if (threadOffsets(histograms, thread_id, &offsets) != num_entries) {
+            combiner.begin(offsets, keys_out, entries_out);
+            for (std::size_t i = begin; i < end; i++) {
+              combiner.write((keys_in[i] >> shift) & (kRadixBuckets - 1), keys_in[i], entries_in[i]);
+            }
+            combiner.flushAll();
+            std::swap(keys_in, keys_out);
+            std::swap(entries_in, entries_out);
+            passes[thread_id]++;
+          }
+          // Histograms are reused and the output becomes the next input.
+          barrier.wait();
+        }
+      });
+      return passes[0] % 2 == 1;
+    }
+
+    std::vector<std::size_t> partition(MatrixEntry const * in,
+                                       MatrixEntry* out,
+                                       std::size_t num_entries,
+                                       EntryField field,
+                                       int dimension,
+                                       int num_partitions,
+                                       int num_threads) {
+      CHECK_GT(num_threads, 0);
+      CHECK_GT(num_partitions, 0);
+      num_threads = std::max<std::size_t>(1, std::min<std::size_t>(num_threads, num_entries));
+
+      std::vector<std::size_t> const bounds = sliceBounds(num_entries, num_threads);
+      std::vector<std::vector<std::size_t>> histograms(num_threads, std::vector<std::size_t>(num_partitions));
+      threading::barrier_t barrier(num_threads);
+      auto partition_of = [field, dimension, num_partitions](MatrixEntry const & entry) {
+        std::int64_t const value = field == EntryField::kRow ? entry.row : entry.column;
+        DCHECK_LT(value, dimension);
+        return static_cast<int>((value * num_partitions) / dimension);
+      };
+
+      threading::runThreads(num_threads, [&](int thread_id) {
+        std::size_t const begin = bounds[thread_id];
+        std::size_t const end = bounds[thread_id + 1];
+        std::vector<std::size_t> & histogram = histograms[thread_id];
+        for (std::size_t i = begin; i < end; i++) {
+          histogram[partition_of(in[i])]++;
+        }
+        barrier.wait();
+
+        std::vector<std::size_t> offsets(num_partitions);
+        threadOffsets(histograms, thread_id, &offsets);
+        WriteCombiner combiner(num_partitions, false);
+        combiner.begin(offsets, nullptr, out);
+        for (std::size_t i = begin; i < end; i++) {
+          combiner.write(partition_of(in[i]), in[i]);
+        }
+        combiner.flushAll();
+      });
+
+      std::vector<std::size_t> partition_offsets(num_partitions + 1, 0);
+      for (int p = 0; p < num_partitions; p++) {
+        partition_offsets[p + 1] = partition_offsets[p];
+        for (int t = 0; t < num_threads; t++) {
+          partition_offsets[p + 1] += histograms[t][p];
+        }
+      }
+      return partition_offsets;
+    }
+
+  } // namespace sorting
+
+} // namespace obamadb
@@ -0,0 +1,71 @@
+#ifndef OBAMADB_RADIXSORT_H
+#define OBAMADB_RADIXSORT_H
+
+#include "storage/UnorderedMatrix.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace obamadb {
+
+  /**
+   * Parallel sorting and partitioning of MatrixEntry arrays.
+   *
+   * Both are built from the same scatter: each thread histograms its slice of the input, the
+   * histograms give every thread a private output range per bucket, and the threads then
+   * write their slices out. Writes go through per-thread software write-combining buffers of
+   * a few cache lines per bucket, so the scatter writes whole lines and the number of output
+   * streams a thread has open at once stays within what the cache can hold.
+   *
+   * Both are stable: entries in the same bucket keep their input order.
+   */
+  namespace sorting {
+
+    /**
+     * Sorts entries by their keys with an LSD radix sort of 8 bit digits. Digits which are
+     * the same for every key are skipped.
+     * @param keys Key of each entry. Only the low key_bits bits are looked at.
+     * @param entries Entries to sort along with the keys.
+     * @param keys_scratch Scratch space for num_entries keys.
+     * @param entries_scratch Scratch space for num_entries entries.
+     * @param num_entries
+     * @param key_bits Number of significant bits in the keys.
+     * @param num_threads
+     * @return True if the sorted keys and entries ended up in the scratch arrays, false if
+     *    they are in the input arrays.
+     */
+    bool radixSort(std::uint64_t* keys,
+                   MatrixEntry* entries,
+                   std::uint64_t* keys_scratch,
+                   MatrixEntry* entries_scratch,
+                   std::size_t num_entries,
+                   int key_bits,
+                   int num_threads);
+
+    /**
+     * Range partitions entries on a field. Partition p receives the entries whose field v has
+     * v * num_partitions / dimension == p, so partitions cover contiguous ranges of values
+     * whose sizes differ by at most one.
+     * @param in Entries to partition.
+     * @param out Receives the partitioned entries. Must not overlap with in.
+     * @param num_entries
+     * @param field Field to partition on.
+     * @param dimension One more than the largest value of the field.
+     * @param num_partitions
+     * @param num_threads
+     * @return num_partitions + 1 offsets. Partition p is out[offsets[p], offsets[p+1]).
+     */
+    std::vector<std::size_t> partition(MatrixEntry const * in,
+                                       MatrixEntry* out,
+                                       std::size_t num_entries,
+                                       EntryField field,
+                                       int dimension,
+                                       int num_partitions,
+                                       int num_threads);
+
+  } // namespace sorting
+
+} // namespace obamadb
+
+#endif //OBAMADB_RADIXSORT_H
@@ -0,0 +1,146 @@
+#include "storage/Random.h"
+
+#include <atomic>
+
+namespace obamadb {
+
+  namespace rng {
+
+    namespace {
+      std::atomic<std::uint64_t> global_seed(1337);
+      // Bumped by setSeed. A thread local generator which is behind reseeds itself.
+      std::atomic<std::uint64_t> seed_epoch(1);
+      // Streams of threads which never called seedThread. Kept clear of explicit streams.
+      std::atomic<std::uint64_t> next_anonymous_stream(static_cast<std::uint64_t>(1) << 32);
+
+      struct ThreadState {
+        ThreadState()
+          : generator(0),
+            stream(0),
+            epoch(0),
+            has_stream(false) { }
+
+        Xoshiro256 generator;
+        std::uint64_t stream;
+        std::uint64_t epoch;
+        bool has_stream;
+      };
+
+      thread_local ThreadState thread_state;
+
+      void reseed(ThreadState* state) {
+        state->epoch = seed_epoch.load();
+        state->generator.seed(deriveSeed(global_seed.load(), state->stream));
+      }
+
+      // Generators run side by side in a bulk fill.
+      int const kLanes = 8;
+
+      /**
+       * kLanes xoshiro256** generators stored lane-major so one step of all of them is a
+       * handful of vector instructions. The multiplications by 5 and 9 are written as shifts
+       * and adds since there is no 64 bit vector multiply before AVX-512.
+       */
+      struct XoshiroLanes {
+        explicit XoshiroLanes(Xoshiro256* seeder) {
+          for (int lane = 0; lane < kLanes; lane++) {
+            Xoshiro256 generator(seeder->next());
+            s0[lane] = generator.next();
+            s1[lane] = generator.next();
+            s2[lane] = generator.next();
+            s3[lane] = generator.next();
+          }
+        }
+
+        inline void next(std::uint64_t* out) {
+          for (int lane = 0; lane < kLanes; lane++) {
+            std::uint64_t const times5 = s1[lane] + (s1[lane] << 2);
+            std::uint64_t const rotated = Xoshiro256::rotl(times5, 7);
+            out[lane] = rotated + (rotated << 3);
+            std::uint64_t const t = s1[lane] << 17;
+            s2[lane] ^= s0[lane];
+            s3[lane] ^= s1[lane];
+            s1[lane] ^= s2[lane];
+            s0[lane] ^= s3[lane];
+            s2[lane] ^= t;
+            s3[lane] = Xoshiro256::rotl(s3[lane], 45);
+          }
+        }
+
+        std::uint64_t s0[kLanes];
+        std::uint64_t s1[kLanes];
+        std::uint64_t s2[kLanes];
+        std::uint64_t s3[kLanes];
+      };
+    }
+
+    void setSeed(std::uint64_t seed) {
+      global_seed.store(seed);
+      seed_epoch++;
+    }
+
+    std::uint64_t getSeed() {
+      return global_seed.load();
+    }
+
+    void seedThread(std::uint64_t stream) {
+      thread_state.stream = stream;
+      thread_state.has_stream = true;
+      reseed(&thread_state);
+    }
+
+    Xoshiro256& threadLocal() {
+      ThreadState & state = thread_state;
+      if (state.epoch != seed_epoch.load(std::memory_order_relaxed)) {
+        if (!state.has_stream) {
+          state.stream = next_anonymous_stream++;
+          state.has_stream = true;
+        }
+        reseed(&state);
+      }
+      return state.generator;
+    }
+
+    void fillUniform(float* out, std::size_t count, float low, float high) {
+      XoshiroLanes lanes(&threadLocal());
+      float const scale = (high - low) * (1.0f / (1 << 24));
+      std::uint64_t bits[kLanes];
+      // Each 64 bit output gives two floats, one from each half.
+      std::size_t const per_step = 2 * kLanes;
+      std::size_t i = 0;
+      for (; i + per_step <= count; i += per_step) {
+        lanes.next(bits);
+        for (int lane = 0; lane < kLanes; lane++) {
+          out[i + lane] = low + (bits[lane] >> 40) * scale;
+          out[i + kLanes + lane] = low + ((bits[lane] >> 8) & 0xffffff) * scale;
+        }
+      }
+      lanes.next(bits);
+      for (int lane = 0; i < count; lane++) {
+        out[i++] = low + (bits[lane] >> 40) * scale;
+        if (i < count) {
+          out[i++] = low + ((bits[lane] >> 8) & 0xffffff) * scale;
+        }
+      }
+    }
+
+    void fillUniform(double* out, std::size_t count, double low, double high) {
+      XoshiroLanes lanes(&threadLocal());
+      double const scale = (high - low) * (1.0 / (static_cast<std::uint64_t>(1) << 53));
+      std::uint64_t bits[kLanes];
+      std::size_t i = 0;
+      for (; i + kLanes <= count; i += kLanes) {
+        lanes.next(bits);
+        for (int lane = 0; lane < kLanes; lane++) {
+          out[i + lane] = low + (bits[lane] >> 11) * scale;
+        }
+      }
+      lanes.next(bits);
+      for (int lane = 0; i < count; lane++) {
+        out[i++] = low + (bits[lane] >> 11) * scale;
+      }
+    }
+
+  } // namespace rng
+
+} // namespace obamadb
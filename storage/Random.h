@@ -0,0 +1,147 @@
+#ifndef OBAMADB_RANDOM_H
+#define OBAMADB_RANDOM_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace obamadb {
+
+  namespace rng {
+
+    /**
+     * The SplitMix64 finalizer. A bijective hash with good avalanche behavior.
+     */
+    inline std::uint64_t splitmix64(std::uint64_t x) {
+      x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+      return x ^ (x >> 31);
+    }
+
+    /**
+     * Derives an independent seed for one use of a user's seed, for example one per matrix
+     * being generated.
+     */
+    inline std::uint64_t deriveSeed(std::uint64_t seed, std::uint64_t tag) {
+      return splitmix64(seed ^ splitmix64(tag + 0x9e3779b97f4a7c15ULL));
+    }
+
+    /**
+     * A counter-based generator. The n-th value of stream s under a seed is a hash of
+     * (seed, s, n), so any piece of a random dataset can be generated on its own, in any
+     * order and on any thread, and always comes out the same.
+     */
+    class CounterRng {
+    public:
+      CounterRng(std::uint64_t seed, std::uint64_t stream)
+        : key_(deriveSeed(seed, stream)),
+          counter_(0) { }
+
+      inline std::uint64_t next() {
+        // Identical to stepping a SplitMix64 generator whose state starts at key_.
+        return splitmix64(key_ + 0x9e3779b97f4a7c15ULL * ++counter_);
+      }
+
+      /**
+       * @return A value in [0, bound). Uses a multiply-shift rather than a modulo.
+       */
+      inline std::uint32_t nextInt(std::uint32_t bound) {
+        return static_cast<std::uint32_t>(((next() >> 32) * bound) >> 32);
+      }
+
+      /**
+       * @return A value in [0, 1).
+       */
+      inline float nextFloat() {
+        return (next() >> 40) * (1.0f / (1 << 24));
+      }
+
+    private:
+      std::uint64_t const key_;
+      std::uint64_t counter_;
+    };
+
+    /**
+     * xoshiro256**, a small and fast generator with 256 bits of state.
+     */
+    class Xoshiro256 {
+    public:
+      explicit Xoshiro256(std::uint64_t seed) {
+        this->seed(seed);
+      }
+
+      void seed(std::uint64_t seed) {
+        // Expand the seed with SplitMix64, which never yields an all zero state.
+        for (int i = 0; i < 4; i++) {
+          seed += 0x9e3779b97f4a7c15ULL;
+          s_[i] = splitmix64(seed);
+        }
+      }
+
+      inline std::uint64_t next() {
+        std::uint64_t const result = rotl(s_[1] * 5, 7) * 9;
+        std::uint64_t const t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl(s_[3], 45);
+        return result;
+      }
+
+      /**
+       * @return A value in [0, bound). Uses a multiply-shift rather than a modulo.
+       */
+      inline std::uint32_t nextInt(std::uint32_t bound) {
+        return static_cast<std::uint32_t>(((next() >> 32) * bound) >> 32);
+      }
+
+      /**
+       * @return A value in [0, 1).
+       */
+      inline float nextFloat() {
+        return (next() >> 40) * (1.0f / (1 << 24));
+      }
+
+      static inline std::uint64_t rotl(std::uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+      }
+
+    private:
+      std::uint64_t s_[4];
+    };
+
+    /**
+     * Sets the seed which all thread local generators derive from and reseeds them. Thread
+     * local generators pick up the new seed the next time they are used.
+     */
+    void setSeed(std::uint64_t seed);
+
+    std::uint64_t getSeed();
+
+    /**
+     * Gives the calling thread its own stream of the global seed. Threads with a fixed
+     * role, like ThreadPool workers, call this so their random numbers are reproducible.
+     * Threads which do not are assigned streams in the order they first draw a number.
+     */
+    void seedThread(std::uint64_t stream);
+
+    /**
+     * @return The calling thread's generator. Never shared between threads, so no locking.
+     *    Hold on to the reference when drawing many numbers.
+     */
+    Xoshiro256& threadLocal();
+
+    /**
+     * Fills a buffer with values uniform in [low, high) drawn from the calling thread's stream.
+     * Runs several xoshiro generators side by side so the loop vectorizes.
+     */
+    void fillUniform(float* out, std::size_t count, float low, float high);
+
+    void fillUniform(double* out, std::size_t count, double low, double high);
+
+  } // namespace rng
+
+} // namespace obamadb
+
+#endif //OBAMADB_RANDOM_H
@@ -0,0 +1,131 @@
+#include "storage/Results.h"
+
+#include <cmath>
+#include <utility>
+
+#include "glog/logging.h"
+
+namespace obamadb {
+
+  namespace {
+    void appendString(std::string * out, std::string const & value) {
+      out->push_back('"');
+      for (char c : value) {
+        if (c == '"' || c == '\\') {
+          out->push_back('\\');
+          out->push_back(c);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+          char escaped[8];
+          snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+          out->append(escaped);
+        } else {
+          out->push_back(c);
+        }
+      }
+      out->push_back('"');
+    }
+  }
+
+  ResultRecord::ResultRecord(std::string const & type)
+    : fields_("{") {
+    add("type", type);
+  }
+
+  void ResultRecord::addKey(std::string const & key) {
+    if (fields_.size() > 1) {
+      fields_.push_back(',');
+    }
+    appendString(&fields_, key);
+    fields_.push_back(':');
+  }
+
+  ResultRecord & ResultRecord::add(std::string const & key, double value) {
+    addKey(key);
+    if (std::isfinite(value)) {
+      char buffer[32];
+      snprintf(buffer, sizeof(buffer), "%.9g", value);
+      fields_.append(buffer);
+    } else {
+      // JSON has no NaN or infinity.
+      fields_.append("null");
+    }
+    return *this;
+  }
+
+  ResultRecord & ResultRecord::add(std::string const & key, std::int64_t value) {
+    addKey(key);
+    fields_.append(std::to_string(value));
+    return *this;
+  }
+
+  ResultRecord & ResultRecord::add(std::string const & key, bool value) {
+    addKey(key);
+    fields_.append(value ? "true" : "false");
+    return *this;
+  }
+
+  ResultRecord & ResultRecord::add(std::string const & key, std::string const & value) {
+    addKey(key);
+    appendString(&fields_, value);
+    return *this;
+  }
+
+  ResultsWriter::ResultsWriter(std::string const & file_name)
+    : file_(fopen(file_name.c_str(), "w")),
+      pending_(),
+      num_written_(0),
+      stop_(false),
+      mutex_(),
+      cond_(),
+      writer_() {
+    CHECK(file_ != nullptr) << "Could not open results file " << file_name;
+    writer_ = std::thread(&ResultsWriter::writerLoop, this);
+  }
+
+  ResultsWriter::~ResultsWriter() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cond_.notify_all();
+    writer_.join();
+    fclose(file_);
+  }
+
+  void ResultsWriter::submit(ResultRecord const & record) {
+    std::string line = record.json();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_.push_back(std::move(line));
+    }
+    cond_.notify_all();
+  }
+
+  int ResultsWriter::numWritten() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return num_written_;
+  }
+
+  void ResultsWriter::writerLoop() {
+    while (true) {
+      std::deque<std::string> lines;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+        if (pending_.empty()) {
+          return;
+        }
+        lines.swap(pending_);
+      }
+      for (std::string const & line : lines) {
+        fputs(line.c_str(), file_);
+        fputc('\n', file_);
+      }
+      // A sweep which is killed part way through still leaves complete lines.
+      fflush(file_);
+      std::lock_guard<std::mutex> lock(mutex_);
+      num_written_ += lines.size();
+    }
+  }
+
+} // namespace obamadb
@@ -0,0 +1,96 @@
+#ifndef OBAMADB_RESULTS_H
+#define OBAMADB_RESULTS_H
+
+#include "storage/Utils.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace obamadb {
+
+  /**
+   * One line of a results file, a flat JSON object. Every record has a "type" field saying what
+   * it describes, e.g. "config", "epoch" or "trial".
+   */
+  class ResultRecord {
+  public:
+    explicit ResultRecord(std::string const & type);
+
+    ResultRecord & add(std::string const & key, double value);
+
+    ResultRecord & add(std::string const & key, std::int64_t value);
+
+    ResultRecord & add(std::string const & key, int value) {
+      return add(key, static_cast<std::int64_t>(value));
+    }
+
+    ResultRecord & add(std::string const & key, bool value);
+
+    ResultRecord & add(std::string const & key, std::string const & value);
+
+    ResultRecord & add(std::string const & key, char const * value) {
+      return add(key, std::string(value));
+    }
+
+    /**
+     * @return The record as a line of JSON, without the newline.
+     */
+    std::string json() const {
+      return fields_ + "}";
+    }
+
+  private:
+    void addKey(std::string const & key);
+
+    std::string fields_;
+  };
+
+  /**
+   * Appends records to a JSON lines file from a background thread, so that the thread
+   * producing results never waits on the disk. Unlike CheckpointWriter, no record is ever
+   * dropped.
+   */
+  class ResultsWriter {
+  public:
+    /**
+     * @param file_name The results file. Truncated on open.
+     */
+    explicit ResultsWriter(std::string const & file_name);
+
+    /**
+     * Blocks until every submitted record is written.
+     */
+    ~ResultsWriter();
+
+    /**
+     * Queues the record to be written.
+     */
+    void submit(ResultRecord const & record);
+
+    /**
+     * @return Number of records written so far.
+     */
+    int numWritten();
+
+  private:
+    void writerLoop();
+
+    FILE* file_;
+    std::deque<std::string> pending_;
+    int num_written_;
+    bool stop_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::thread writer_;
+
+    DISABLE_COPY_AND_ASSIGN(ResultsWriter);
+  };
+
+} // namespace obamadb
+
+#endif //OBAMADB_RESULTS_H
@@ -0,0 +1,237 @@
+#include "storage/RowPartitioning.h"
+
+#include "storage/Random.h"
+#include "storage/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+#include "glog/logging.h"
+
+namespace obamadb {
+
+  namespace partitioning {
+
+    namespace {
+      // Model coordinates per cache line.
+      int const kLineColumns = kCacheLineBytes / sizeof(num_t);
+
+      struct SignedRow {
+        std::uint64_t signature;
+        std::uint32_t block;
+        std::uint32_t row;
+        std::uint32_t nnz;
+
+        bool operator<(SignedRow const & other) const {
+          if (signature != other.signature) {
+            return signature < other.signature;
+          }
+          return block != other.block ? block < other.block : row < other.row;
+        }
+      };
+
+      /**
+       * Two min-hashes of the set of cache lines a row writes. The first is the high half of the
+       * signature, so sorting groups rows which agree on it, which two rows do with probability
+       * equal to the Jaccard similarity of their lines. The second orders rows within a group.
+       */
+      std::uint64_t signature(svector<num_t> const & row) {
+        std::uint64_t const kSeed1 = 0x6a09e667f3bcc908ULL;
+        std::uint64_t const kSeed2 = 0xbb67ae8584caa73bULL;
+        std::uint64_t min1 = std::numeric_limits<std::uint64_t>::max();
+        std::uint64_t min2 = std::numeric_limits<std::uint64_t>::max();
+        int last_line = -1;
+        for (int i = 0; i < row.numElements(); i++) {
+          // Indices are sorted, so the elements of a line are next to each other.
+          int const line = row.index_[i] / kLineColumns;
+          if (line == last_line) {
+            continue;
+          }
+          last_line = line;
+          min1 = std::min(min1, rng::splitmix64(line ^ kSeed1));
+          min2 = std::min(min2, rng::splitmix64(line ^ kSeed2));
+        }
+        return (min1 & 0xffffffff00000000ULL) | (min2 >> 32);
+      }
+
+      /**
+       * Reads a row in its sparse form. Rows of sparse blocks are read in place. Rows of dense
+       * blocks have the zeros filled in for their unset columns, so their set elements are
+       * copied to stripped, which packed blocks then get, and are only densified again if they
+       * are dense enough on their own.
+       * @return row or stripped.
+       */
+      svector<num_t> const & sparseRow(SparseDataBlock<num_t> const & block,
+                                       int i,
+                                       svector<num_t> * row,
+                                       svector<num_t> * stripped) {
+        block.getRowVectorFast(i, row);
+        if (!block.isDense()) {
+          return *row;
+        }
+        stripped->clear();
+        for (int j = 0; j < row->numElements(); j++) {
+          if (row->values_[j] != 0) {
+            stripped->push_back(row->index_[j], row->values_[j]);
+          }
+        }
+        stripped->setClassification(*row->class_);
+        return *stripped;
+      }
+
+      template<class F>
+      void forEachColumn(std::vector<SparseDataBlock<num_t> const *> const & blocks, F const & fn) {
+        svector<num_t> row(0, nullptr);
+        svector<num_t> stripped;
+        for (SparseDataBlock<num_t> const * block : blocks) {
+          for (int i = 0; i < block->getNumRows(); i++) {
+            svector<num_t> const & sparse = sparseRow(*block, i, &row, &stripped);
+            for (int j = 0; j < sparse.numElements(); j++) {
+              fn(sparse.index_[j]);
+            }
+          }
+        }
+      }
+    }
+
+    Placement roundRobin(std::vector<SparseDataBlock<num_t> *> const & blocks, int num_workers) {
+      Placement placement(num_workers);
+      for (int i = 0; i < blocks.size(); i++) {
+        placement[i % num_workers].push_back(blocks[i]);
+      }
+      return placement;
+    }
+
+    Matrix* minHash(Matrix const & matrix, int num_workers, int num_threads, Placement * placement) {
+      CHECK_GT(num_workers, 0);
+      CHECK_GT(num_threads, 0);
+      std::vector<SparseDataBlock<num_t>*> const & blocks = matrix.blocks_;
+      std::vector<std::size_t> first_row(blocks.size() + 1, 0);
+      for (int b = 0; b < blocks.size(); b++) {
+        first_row[b + 1] = first_row[b] + blocks[b]->getNumRows();
+      }
+
+      std::vector<SignedRow> rows(first_row.back());
+      std::atomic<int> next_block(0);
+      threading::runThreads(num_threads, [&](int thread_id) {
+        svector<num_t> row(0, nullptr);
+        svector<num_t> stripped;
+        for (int b = next_block++; b < blocks.size(); b = next_block++) {
+          for (int i = 0; i < blocks[b]->getNumRows(); i++) {
+            svector<num_t> const & sparse = sparseRow(*blocks[b], i, &row, &stripped);
+            SignedRow & signed_row = rows[first_row[b] + i];
+            signed_row.signature = signature(sparse);
+            signed_row.block = b;
+            signed_row.row = i;
+            signed_row.nnz = sparse.numElements();
+          }
+        }
+      });
+      std::sort(rows.begin(), rows.end());
+
+      // Cut the sorted rows into runs of about equal work. A row costs its elements plus one.
+      std::uint64_t total_work = 0;
+      for (SignedRow const & row : rows) {
+        total_work += row.nnz + 1;
+      }
+      std::vector<std::size_t> run_bounds(num_workers + 1, rows.size());
+      run_bounds[0] = 0;
+      std::uint64_t work = 0;
+      int worker = 1;
+      for (std::size_t r = 0; r < rows.size() && worker < num_workers; r++) {
+        while (worker < num_workers && work >= (total_work * worker) / num_workers) {
+          run_bounds[worker++] = r;
+        }
+        work += rows[r].nnz + 1;
+      }
+
+      std::vector<std::vector<SparseDataBlock<num_t>*>> packed(num_workers);
+      std::atomic<int> next_worker(0);
+      threading::runThreads(std::min(num_threads, num_workers), [&](int thread_id) {
+        svector<num_t> row(0, nullptr);
+        svector<num_t> stripped;
+        for (int w = next_worker++; w < num_workers; w = next_worker++) {
+          SparseDataBlock<num_t>* block = nullptr;
+          for (std::size_t r = run_bounds[w]; r < run_bounds[w + 1]; r++) {
+            svector<num_t> const & sparse = sparseRow(*blocks[rows[r].block], rows[r].row, &row, &stripped);
+            if (block == nullptr || !block->appendRow(sparse)) {
+              block = new SparseDataBlock<num_t>();
+              packed[w].push_back(block);
+              CHECK(block->appendRow(sparse));
+            }
+          }
+        }
+      });
+
+      Matrix* result = new Matrix();
+      placement->clear();
+      placement->resize(num_workers);
+      for (int w = 0; w < num_workers; w++) {
+        for (SparseDataBlock<num_t>* block : packed[w]) {
+          // Keep the dimension of the original even if no row reaches the last column.
+          block->num_columns_ = matrix.numColumns_;
+          block->finalize();
+          result->addBlock(block);
+          (*placement)[w].push_back(block);
+        }
+      }
+      return result;
+    }
+
+    ConflictStats measureConflicts(Placement const & placement, int num_columns) {
+      int const num_workers = placement.size();
+      std::int64_t const num_lines = (num_columns + kLineColumns - 1) / kLineColumns;
+      std::vector<std::vector<std::uint8_t>> touched(num_workers, std::vector<std::uint8_t>(num_lines, 0));
+      std::vector<int> writers(num_lines, 0);
+      std::vector<std::uint64_t> shared_writes(num_workers, 0);
+      std::vector<std::uint64_t> total_writes(num_workers, 0);
+      threading::barrier_t barrier(num_workers);
+
+      threading::runThreads(num_workers, [&](int w) {
+        std::vector<std::uint8_t> & lines = touched[w];
+        forEachColumn(placement[w], [&lines](int column) {
+          lines[column / kLineColumns] = 1;
+        });
+        barrier.wait();
+
+        std::int64_t const first = (num_lines * w) / num_workers;
+        std::int64_t const last = (num_lines * (w + 1)) / num_workers;
+        for (std::vector<std::uint8_t> const & other : touched) {
+          for (std::int64_t line = first; line < last; line++) {
+            writers[line] += other[line];
+          }
+        }
+        barrier.wait();
+
+        std::uint64_t shared = 0;
+        std::uint64_t total = 0;
+        forEachColumn(placement[w], [&](int column) {
+          shared += writers[column / kLineColumns] > 1;
+          total++;
+        });
+        shared_writes[w] = shared;
+        total_writes[w] = total;
+      });
+
+      ConflictStats stats;
+      std::uint64_t shared = 0;
+      std::uint64_t total = 0;
+      for (int w = 0; w < num_workers; w++) {
+        shared += shared_writes[w];
+        total += total_writes[w];
+      }
+      std::uint64_t writer_sum = 0;
+      std::uint64_t written_lines = 0;
+      for (int writer_count : writers) {
+        writer_sum += writer_count;
+        written_lines += writer_count > 0;
+      }
+      stats.shared_write_fraction = total == 0 ? 0 : static_cast<double>(shared) / total;
+      stats.workers_per_line = written_lines == 0 ? 0 : static_cast<double>(writer_sum) / written_lines;
+      return stats;
+    }
+
+  } // namespace partitioning
+
+} // namespace obamadb
@@ -0,0 +1,73 @@
+#ifndef OBAMADB_ROWPARTITIONING_H
+#define OBAMADB_ROWPARTITIONING_H
+
+#include "storage/Matrix.h"
+#include "storage/SparseDataBlock.h"
+#include "storage/StorageConstants.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace obamadb {
+
+  /**
+   * Placement of training rows on Hogwild workers.
+   *
+   * Two workers conflict when they write the same cache line of the model. The default placement
+   * deals whole blocks out round robin and ignores which features the rows touch. The min-hash
+   * placement instead groups rows which touch the same cache lines of the model and gives each
+   * group to one worker, so concurrent writes collide less often.
+   */
+  namespace partitioning {
+
+    /**
+     * The blocks each worker trains over, indexed by worker.
+     */
+    typedef std::vector<std::vector<SparseDataBlock<num_t> const *>> Placement;
+
+    /**
+     * Write conflicts between the workers of a placement, counted at the granularity of model
+     * cache lines.
+     */
+    struct ConflictStats {
+      ConflictStats()
+        : shared_write_fraction(0),
+          workers_per_line(0) { }
+
+      // Fraction of the model writes of an epoch which go to a line another worker also writes.
+      double shared_write_fraction;
+      // The average number of workers writing a line, over the lines written at all.
+      double workers_per_line;
+    };
+
+    /**
+     * @return Block b on worker b % num_workers, which is how blocks are dealt out by default.
+     */
+    Placement roundRobin(std::vector<SparseDataBlock<num_t> *> const & blocks, int num_workers);
+
+    /**
+     * Repacks the rows of a matrix into blocks per worker. Each row gets a min-hash signature of
+     * the model cache lines it touches, rows are sorted by signature so rows with overlapping
+     * lines end up next to each other, and the sorted rows are cut into num_workers runs with
+     * about the same number of non-zero elements.
+     * @param matrix Training data.
+     * @param num_workers
+     * @param num_threads Threads to compute the signatures and repack with.
+     * @param placement Receives the blocks of each worker. They belong to the returned matrix.
+     * @return A caller-owned matrix of the same rows, in placement order.
+     */
+    Matrix* minHash(Matrix const & matrix, int num_workers, int num_threads, Placement * placement);
+
+    /**
+     * Counts which model cache lines each worker of a placement writes in an epoch.
+     * @param placement
+     * @param num_columns Dimension of the model.
+     * @return
+     */
+    ConflictStats measureConflicts(Placement const & placement, int num_columns);
+
+  } // namespace partitioning
+
+} // namespace obamadb
+
+#endif //OBAMADB_ROWPARTITIONING_H
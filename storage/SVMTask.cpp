@@ -1,57 +1,201 @@
 #include "storage/DataBlock.h"
 #include "storage/DataView.h"
 #include "storage/exvector.h"
+#include "storage/Instrumentation.h"
+#include "storage/Matrix.h"
 #include "storage/MLTask.h"
 #include "storage/SparseDataBlock.h"
 #include "storage/Utils.h"
 
 #include "storage/SVMTask.h"
 
+#include <algorithm>
+
 // comment this out depending on the test you are doing:
 // #define USE_HINGE 0
 // #define USE_SCALING 0
 
 namespace obamadb {
 
+  SVMParams *DefaultSVMParams(Matrix const & matrix, int num_threads) {
+    SVMParams *params = new SVMParams(1, 0.1, 0.99);
+    params->degrees = matrix.columnStatistics(num_threads).degrees;
+    return params;
+  }
+
+  namespace {
+    /**
+     * @return The step applied to a row with margin wxy, shared by the row and column
+     *    partitioned SVMs.
+     */
+    inline num_t svmStep(num_t wxy, num_t y, num_t step_size) {
+#ifdef USE_HINGE
+      return wxy < 1 ? step_size * y : 0;
+#else
+      // always apply the hinge loss, for memory-access
+      return wxy < 1 ? step_size * y : step_size * y * -1 * 1e-3;
+#endif
+    }
+  }
+
+  ColumnPartitionedSVMTask::ColumnPartitionedSVMTask(Matrix const * matrix,
+                                                     fvector *shared_theta,
+                                                     SVMParams *shared_params,
+                                                     int num_threads,
+                                                     int batch_size)
+    : blocks_(matrix->blocks_.begin(), matrix->blocks_.end()),
+      shared_theta_(shared_theta),
+      shared_params_(shared_params),
+      num_threads_(num_threads),
+      batch_size_(batch_size),
+      column_bounds_(num_threads + 1, 0),
+      partial_dots_(),
+      batch_barrier_(num_threads) {
+    CHECK_GT(num_threads, 0);
+    CHECK_GT(batch_size, 0);
+    partial_dots_[0].resize(num_threads * batch_size);
+    partial_dots_[1].resize(num_threads * batch_size);
+
+    // Split the columns so every range holds about the same number of non-zero elements.
+    // Bounds are rounded to whole cache lines of theta, so threads do not share lines either.
+    std::vector<int> const & degrees = matrix->columnStatistics(num_threads).degrees;
+    int const num_columns = degrees.size();
+    int const line_columns = kCacheLineBytes / sizeof(num_t);
+    std::uint64_t const total_nnz = matrix->getNNZ();
+    std::uint64_t prefix_nnz = 0;
+    int column = 0;
+    for (int t = 1; t < num_threads; t++) {
+      std::uint64_t const target = (total_nnz * t) / num_threads;
+      while (column < num_columns && prefix_nnz < target) {
+        prefix_nnz += degrees[column++];
+      }
+      int const rounded = ((column + line_columns - 1) / line_columns) * line_columns;
+      column_bounds_[t] = std::max(column_bounds_[t - 1], std::min(rounded, num_columns));
+    }
+    column_bounds_[num_threads] = num_columns;
+  }
+
+  void ColumnPartitionedSVMTask::execute(int thread_id, void *ml_state) {
+    (void) ml_state;
+
+    num_t *theta = shared_theta_->values_;
+    num_t const step_size = shared_params_->step_size;
+    int const first_column = column_bounds_[thread_id];
+    int const last_column = column_bounds_[thread_id + 1];
+    std::vector<RowSlice> slices(batch_size_);
+    svector<num_t> row(0, nullptr);
+    INSTRUMENT(instrument::WriteTracker* tracker = instrument::tracker();)
+
+    // Every thread walks the rows in the same order, so all agree on the batches.
+    int block = 0;
+    int block_row = 0;
+    for (int batch = 0; ; batch++) {
+      num_t *partials = partial_dots_[batch % 2].data();
+      num_t *thread_partials = partials + thread_id * batch_size_;
+      int batch_rows = 0;
+      // The tracker holds the reads of one update per worker, so at most one row per batch is sampled.
+      INSTRUMENT(int sampled_row = -1;)
+      for (; batch_rows < batch_size_ && block < blocks_.size(); batch_rows++) {
+        blocks_[block]->getRowVectorFast(block_row, &row);
+        if (++block_row == blocks_[block]->num_rows_) {
+          block++;
+          block_row = 0;
+        }
+
+        RowSlice & slice = slices[batch_rows];
+        slice.index = row.index_;
+        slice.values = row.values_;
+        slice.label = *row.getClassification();
+        slice.begin = std::lower_bound(row.index_, row.index_ + row.num_elements_, first_column) - row.index_;
+        slice.end = std::lower_bound(row.index_ + slice.begin, row.index_ + row.num_elements_, last_column) - row.index_;
+        INSTRUMENT(
+          // The row reads its slice of the model here, so the updates of the earlier rows of the
+          // batch land between its read and its write.
+          if (tracker != nullptr && tracker->beginUpdate(thread_id) && sampled_row < 0) {
+            sampled_row = batch_rows;
+            tracker->read(thread_id, theta, slice.index + slice.begin, slice.end - slice.begin);
+          })
+        num_t partial = 0;
+        for (int i = slice.begin; i < slice.end; i++) {
+          partial += slice.values[i] * theta[slice.index[i]];
+        }
+        thread_partials[batch_rows] = partial;
+      }
+      if (batch_rows == 0) {
+        break;
+      }
+      batch_barrier_.wait();
+
+      for (int r = 0; r < batch_rows; r++) {
+        num_t wx = 0;
+        for (int t = 0; t < num_threads_; t++) {
+          wx += partials[t * batch_size_ + r];
+        }
+        RowSlice const & slice = slices[r];
+        num_t const e = svmStep(wx * slice.label, slice.label, step_size);
+        INSTRUMENT(
+          if (tracker != nullptr) {
+            if (r == sampled_row) {
+              tracker->checkReads(thread_id);
+            }
+            tracker->write(thread_id, theta, slice.index + slice.begin, slice.end - slice.begin);
+          })
+        for (int i = slice.begin; i < slice.end; i++) {
+          theta[slice.index[i]] += slice.values[i] * e;
+        }
+      }
+    }
+
+    if (thread_id == 0) {
+      shared_params_->step_size = step_size * shared_params_->step_decay;
+    }
+  }
+
   void SVMTask::execute(int threadId, void *svm_state) {
     (void) svm_state; // silence compiler warning.
 
     data_view_->reset();
     svector<num_t> row(0, nullptr);
+    bool dense = false;
     num_t *theta = shared_theta_->values_;
     const num_t mu = shared_params_->mu;
     const num_t step_size = shared_params_->step_size;
+    INSTRUMENT(instrument::WriteTracker* tracker = instrument::tracker();)
 
     // perform update with all the data in its view,
-    while (data_view_->getNext(&row)) {
+    while (data_view_->getNext(&row, &dense)) {
+      INSTRUMENT(
+        bool const sampled = tracker != nullptr && tracker->beginUpdate(threadId);
+        if (sampled) {
+          tracker->read(threadId, theta, row.index_, row.numElements());
+        })
       num_t const y = *row.getClassification();
-      num_t wxy = ml::dot(row, theta);
+      // Dense rows start at column 0, so they skip the index and vectorize.
+      num_t wxy = dense ? ml::dot(row.values_, theta, row.num_elements_) : ml::dot(row, theta);
       wxy = wxy * y; // {-1, 1}
 
-#ifdef USE_HINGE
-      // apply the hinge function like in a normal SVM
-      if (wxy < 1) {
-        num_t const e = step_size * y;
-        // scale weights
-        ml::scaleAndAdd(theta, row, e);
-      }
-#else
-      // always apply the hinge loss, for memory-access
-      if (wxy < 1) {
-        num_t const e = step_size * y;
-        // scale weights
-        ml::scale_and_add(theta, row, e);
+      INSTRUMENT(
+        if (sampled) {
+          tracker->checkReads(threadId);
+        }
+        if (tracker != nullptr) {
+          tracker->write(threadId, theta, row.index_, row.numElements());
+        })
+      num_t const step = svmStep(wxy, y, step_size);
+      if (dense) {
+        ml::scale_and_add(theta, row.values_, row.num_elements_, step);
       } else {
-        num_t const e = step_size * y * -1 * 1e-3;
-        // scale weights
-        ml::scale_and_add(theta, row, e);
+        ml::scale_and_add(theta, row, step);
       }
-#endif
 
 #ifdef USE_SCALING
       num_t const scalar = step_size * mu;
-      // scale only the values which were updated.
+      // scale only the values which were updated. The zeros dense rows fill in do not count
+      // towards the degrees, so they are skipped.
       for (int i = row.numElements(); i-- > 0;) {
+        if (dense && row.values_[i] == 0) {
+          continue;
+        }
         const int idx_j = row.index_[i];
         num_t const deg = shared_params_->degrees[idx_j];
         theta[idx_j] *= 1 - scalar / deg;
@@ -79,14 +223,7 @@ namespace obamadb {
   }
 
   double SVMTask::fractionMisclassified(const fvector &theta, std::vector<SparseDataBlock<num_t> *> const &blocks) {
-    long total_misclassified = 0;
-    long total_examples = 0;
-    for (int i = 0; i < blocks.size(); i++) {
-      SparseDataBlock<num_t> const *block = blocks[i];
-      total_misclassified += SVMTask::numMisclassified(theta, *block);
-      total_examples += block->getNumRows();
-    }
-    return (double) total_misclassified / (double) total_examples;
+    return ml::fractionMisclassified(theta.values_, blocks);
   }
 
   double SVMTask::rmsError(const fvector &theta, std::vector<SparseDataBlock<num_t> *> const &blocks) {
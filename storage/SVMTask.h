@@ -4,10 +4,14 @@
 #include "storage/DataBlock.h"
 #include "storage/DataView.h"
 #include "storage/exvector.h"
+#include "storage/Matrix.h"
 #include "storage/MLTask.h"
 #include "storage/SparseDataBlock.h"
+#include "storage/ThreadPool.h"
 #include "storage/Utils.h"
 
+#include <vector>
+
 namespace obamadb {
 
   /**
@@ -30,6 +34,8 @@ namespace obamadb {
 
   class SVMTask : MLTask {
   public:
+    typedef SVMParams Params;
+
     SVMTask(DataView *dataView,
             fvector *sharedTheta,
             SVMParams *sharedParams)
@@ -62,6 +68,20 @@ namespace obamadb {
      */
     static double fractionMisclassified(const fvector &theta, std::vector<SparseDataBlock<num_t> *> const &block);
 
+    /**
+     * @return The name of the error error() reports, to label its output with.
+     */
+    static char const * errorName() {
+      return "fraction_misclassified";
+    }
+
+    /**
+     * The error reported while training, the fraction of misclassified examples.
+     */
+    static double error(const fvector &theta, std::vector<SparseDataBlock<num_t> *> const &blocks) {
+      return fractionMisclassified(theta, blocks);
+    }
+
     /**
      * Root mean squared error.
      * @param theta The trained weights.
@@ -76,42 +96,93 @@ namespace obamadb {
     */
     static double rmsErrorLoss(const fvector &theta, std::vector<SparseDataBlock<num_t> *> const &blocks);
 
+    /**
+     * The loss reported while training. For the SVM this is the RMS of the hinge loss.
+     */
+    static double loss(const fvector &theta, std::vector<SparseDataBlock<num_t> *> const &blocks) {
+      return rmsErrorLoss(theta, blocks);
+    }
+
     fvector *shared_theta_;
     SVMParams *shared_params_;
 
     DISABLE_COPY_AND_ASSIGN(SVMTask);
   };
 
-/**
- * Constructs the SVM to the parameters used in the HW! paper.
- * @return Caller-owned SVM params.
- */
-  template<class T>
-  SVMParams *DefaultSVMParams(std::vector<SparseDataBlock<T> *> &all_blocks) {
-    SVMParams *params = new SVMParams(1, 0.1, 0.99);
-
-    int dim = 0;
-    // count the number of members of each column
-    std::vector<int> &degrees = params->degrees;
-
-    for (int k = 0; k < all_blocks.size(); ++k) {
-      const SparseDataBlock<T> &block = *all_blocks[k];
-      if (dim < block.getNumColumns()) {
-        dim = block.getNumColumns();
-        degrees.resize(dim);
-      }
-
-      svector<float_t> row;
-      for (int i = 0; i < block.getNumRows(); i++) {
-        block.getRowVector(i, &row);
-        for (int j = 0; j < row.numElements(); j++) {
-          degrees[row.index_[j]] += 1;
-        }
-      }
+  /**
+   * Trains the SVM with the features split into contiguous column ranges, one per thread, as an
+   * alternative to Hogwild for data where rows share many features. Each thread walks every row
+   * but only reads and writes theta inside its own range, so writes to the model never conflict.
+   *
+   * Rows go in batches. Each thread writes its range's partial dot product for every row of the
+   * batch, the threads meet at a barrier, and then each thread sums the partials of a row to get
+   * its margin and applies the update to its range. Margins within a batch are therefore computed
+   * against theta as of the start of the batch. The partials are double buffered, so there is one
+   * barrier per batch.
+   *
+   * One instance is shared by all the workers of a ThreadPool.
+   */
+  class ColumnPartitionedSVMTask {
+  public:
+    typedef SVMParams Params;
+
+    /**
+     * @param matrix The training data. Its column statistics are used to give every thread
+     *    about the same number of non-zero elements.
+     * @param shared_theta The model.
+     * @param shared_params
+     * @param num_threads Number of workers which will call execute.
+     * @param batch_size Rows per batch.
+     */
+    ColumnPartitionedSVMTask(Matrix const * matrix,
+                             fvector *shared_theta,
+                             SVMParams *shared_params,
+                             int num_threads,
+                             int batch_size);
+
+    /**
+     * Runs one epoch over all of the training data. Every worker must call this.
+     */
+    void execute(int thread_id, void *ml_state);
+
+    /**
+     * @return num_threads + 1 column bounds. Thread t owns columns [bounds[t], bounds[t+1]).
+     */
+    std::vector<int> const & columnBounds() const {
+      return column_bounds_;
     }
 
-    return params;
+  private:
+    // The part of a row of the current batch which falls in a thread's column range.
+    struct RowSlice {
+      int const *index;
+      num_t const *values;
+      num_t label;
+      int begin;
+      int end;
+    };
+
+    std::vector<SparseDataBlock<num_t> const *> blocks_;
+    fvector *shared_theta_;
+    SVMParams *shared_params_;
+    int const num_threads_;
+    int const batch_size_;
+    std::vector<int> column_bounds_;
+    // Partial dot products of a batch, laid out by thread then row. Double buffered.
+    std::vector<num_t> partial_dots_[2];
+    threading::barrier_t batch_barrier_;
+
+    DISABLE_COPY_AND_ASSIGN(ColumnPartitionedSVMTask);
   };
+
+  /**
+   * Constructs the SVM to the parameters used in the HW! paper.
+   * @param matrix The training data. Its column statistics give the degrees.
+   * @param num_threads Threads used to compute the column statistics if the matrix has not yet.
+   * @return Caller-owned SVM params.
+   */
+  SVMParams *DefaultSVMParams(Matrix const & matrix, int num_threads);
+
 } // namespace obamadb
 
 #endif //OBAMADB_SVMTASK_H
@@ -0,0 +1,215 @@
+#include "storage/Scorer.h"
+
+#include "storage/DenseDataBlock.h"
+#include "storage/exvector.h"
+#include "storage/IO.h"
+#include "storage/MLTask.h"
+#include "storage/SparseDataBlock.h"
+#include "storage/ThreadPool.h"
+#include "storage/UnorderedMatrix.h"
+#include "storage/Utils.h"
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace obamadb {
+
+  namespace {
+    int const kBlocksPerThread = 4;
+    int const kPairsPerThread = 1 << 16;
+    std::size_t const kOutputBufferSize = 1 << 20;
+
+    /**
+     * Scores batches with a thread pool while the calling thread reads the next batch.
+     *
+     * @param read Returns a caller-owned batch, or nullptr when the input is exhausted.
+     * @param score Called by every worker with its thread id and the current batch.
+     * @param write Called by the calling thread with each scored batch, in input order.
+     */
+    template<class BatchT>
+    void runScoringPipeline(int num_threads,
+                            std::function<BatchT*()> read,
+                            std::function<void(int, BatchT*)> score,
+                            std::function<void(BatchT*)> write) {
+      struct PipelineState {
+        BatchT* batch;
+        std::function<void(int, BatchT*)> score;
+      } state = { nullptr, score };
+
+      auto worker_fn = [](int tid, void* ptr) {
+        PipelineState* pipeline = reinterpret_cast<PipelineState*>(ptr);
+        pipeline->score(tid, pipeline->batch);
+      };
+      ThreadPool tp(worker_fn, &state, num_threads);
+      tp.begin();
+
+      std::unique_ptr<BatchT> current(read());
+      std::unique_ptr<BatchT> next;
+      while (current) {
+        state.batch = current.get();
+        tp.startCycle();
+        next.reset(read());
+        tp.finishCycle();
+        write(current.get());
+        current.swap(next);
+      }
+      tp.stop();
+    }
+
+    FILE* openOutput(std::string const & output_file) {
+      FILE* out = fopen(output_file.c_str(), "w");
+      CHECK(out != nullptr) << "Unable to open " << output_file << " for output.";
+      setvbuf(out, nullptr, _IOFBF, kOutputBufferSize);
+      return out;
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point const & start) {
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      return elapsed.count();
+    }
+  }
+
+  struct LinearScoreBatch {
+    std::vector<std::unique_ptr<SparseDataBlock<num_t>>> blocks;
+    std::vector<std::string> predictions; // one buffer per block
+  };
+
+  ScoreStats LinearScorer::score(std::string const & input_file, std::string const & output_file) const {
+    auto time_start = std::chrono::steady_clock::now();
+    IO::LibLinearReader reader(input_file,
+                               algorithm_ == MLAlgorithm::kLS ? IO::LabelType::kTarget : IO::LabelType::kClass);
+    FILE* out = openOutput(output_file);
+    int const batch_blocks = num_threads_ * kBlocksPerThread;
+    ScoreStats stats;
+
+    std::function<LinearScoreBatch*()> read = [&reader, batch_blocks]() -> LinearScoreBatch* {
+      std::unique_ptr<LinearScoreBatch> batch(new LinearScoreBatch());
+      SparseDataBlock<num_t>* block = nullptr;
+      while (batch->blocks.size() < batch_blocks && (block = reader.next()) != nullptr) {
+        batch->blocks.push_back(std::unique_ptr<SparseDataBlock<num_t>>(block));
+      }
+      batch->predictions.resize(batch->blocks.size());
+      return batch->blocks.empty() ? nullptr : batch.release();
+    };
+
+    std::function<void(int, LinearScoreBatch*)> score = [this](int tid, LinearScoreBatch* batch) {
+      num_t const * theta = theta_->values_;
+      int const dim = theta_->dimension_;
+      svector<num_t> row(0, nullptr);
+      char line[64];
+      for (int b = tid; b < batch->blocks.size(); b += num_threads_) {
+        SparseDataBlock<num_t> const & block = *batch->blocks[b];
+        std::string & predictions = batch->predictions[b];
+        predictions.clear();
+        // Rows may contain features which never appeared in training.
+        bool const in_bounds = static_cast<int>(block.getNumColumns()) <= dim;
+        for (int i = 0; i < block.getNumRows(); i++) {
+          block.getRowVectorFast(i, &row);
+          num_t score = 0;
+          if (in_bounds) {
+            score = ml::dot(row, theta);
+          } else {
+            for (int j = 0; j < row.numElements(); j++) {
+              if (row.index_[j] < dim) {
+                score += row.values_[j] * theta[row.index_[j]];
+              }
+            }
+          }
+          int len = 0;
+          if (algorithm_ == MLAlgorithm::kLS) {
+            len = snprintf(line, sizeof(line), "%.6f\n", score);
+          } else {
+            int label = score >= 0 ? 1 : -1;
+            if (algorithm_ == MLAlgorithm::kLR) {
+              score = ml::fast_sigmoid(score);
+            }
+            len = snprintf(line, sizeof(line), "%d,%.6f\n", label, score);
+          }
+          predictions.append(line, len);
+        }
+      }
+    };
+
+    std::function<void(LinearScoreBatch*)> write = [out, &stats](LinearScoreBatch* batch) {
+      for (int b = 0; b < batch->blocks.size(); b++) {
+        fwrite(batch->predictions[b].data(), 1, batch->predictions[b].size(), out);
+        stats.rows += batch->blocks[b]->getNumRows();
+      }
+    };
+
+    runScoringPipeline(num_threads_, read, score, write);
+    fclose(out);
+    stats.seconds = secondsSince(time_start);
+    return stats;
+  }
+
+  struct MCScoreBatch {
+    std::vector<MatrixEntry> pairs;
+    std::vector<std::string> predictions; // one buffer per thread
+  };
+
+  ScoreStats MCScorer::score(std::string const & input_file, std::string const & output_file) const {
+    auto time_start = std::chrono::steady_clock::now();
+    Scanner scanner(input_file);
+    FILE* out = openOutput(output_file);
+    int const batch_pairs = num_threads_ * kPairsPerThread;
+    int const num_threads = num_threads_;
+    ScoreStats stats;
+
+    std::function<MCScoreBatch*()> read = [&scanner, batch_pairs, num_threads]() -> MCScoreBatch* {
+      std::unique_ptr<MCScoreBatch> batch(new MCScoreBatch());
+      batch->pairs.reserve(batch_pairs);
+      while (batch->pairs.size() < batch_pairs) {
+        std::vector<double> line = scanner.scanLine();
+        if (line.size() == 0) {
+          break;
+        }
+        CHECK_GE(line.size(), 2) << "Expected (row, column) pairs.";
+        batch->pairs.push_back(MatrixEntry(static_cast<int>(line[0]), static_cast<int>(line[1]), 0));
+      }
+      batch->predictions.resize(num_threads);
+      return batch->pairs.empty() ? nullptr : batch.release();
+    };
+
+    std::function<void(int, MCScoreBatch*)> score = [this](int tid, MCScoreBatch* batch) {
+      int const alloc_size = (batch->pairs.size() + num_threads_ - 1) / num_threads_;
+      int const start = std::min<int>(alloc_size * tid, batch->pairs.size());
+      int const end = std::min<int>(start + alloc_size, batch->pairs.size());
+      std::string & predictions = batch->predictions[tid];
+      predictions.clear();
+      dvector<num_t> lrow(0, nullptr);
+      dvector<num_t> rrow(0, nullptr);
+      char line[64];
+      for (int i = start; i < end; i++) {
+        MatrixEntry const & pair = batch->pairs[i];
+        double prediction = mean_;
+        if (pair.row >= 0 && pair.row < mat_l_->getNumRows()
+            && pair.column >= 0 && pair.column < mat_r_->getNumRows()) {
+          mat_l_->getRowVectorFast(pair.row, &lrow);
+          mat_r_->getRowVectorFast(pair.column, &rrow);
+          prediction += ml::dot(lrow, rrow.values_);
+        }
+        int const len = snprintf(line, sizeof(line), "%d\t%d\t%.6f\n", pair.row, pair.column, prediction);
+        predictions.append(line, len);
+      }
+    };
+
+    std::function<void(MCScoreBatch*)> write = [out, &stats](MCScoreBatch* batch) {
+      for (std::string const & predictions : batch->predictions) {
+        fwrite(predictions.data(), 1, predictions.size(), out);
+      }
+      stats.rows += batch->pairs.size();
+    };
+
+    runScoringPipeline(num_threads_, read, score, write);
+    fclose(out);
+    stats.seconds = secondsSince(time_start);
+    return stats;
+  }
+
+} // namespace obamadb
@@ -0,0 +1,97 @@
+#ifndef OBAMADB_SCORER_H
+#define OBAMADB_SCORER_H
+
+#include "storage/DenseDataBlock.h"
+#include "storage/MLTask.h"
+#include "storage/StorageConstants.h"
+#include "storage/Utils.h"
+
+#include <cstdint>
+#include <string>
+
+namespace obamadb {
+
+  /**
+   * Throughput of a scoring run.
+   */
+  struct ScoreStats {
+    ScoreStats()
+      : rows(0),
+        seconds(0) {}
+
+    double rowsPerSecond() const {
+      return seconds > 0 ? rows / seconds : 0;
+    }
+
+    std::uint64_t rows;
+    double seconds;
+  };
+
+  /**
+   * Applies a trained linear model (SVM, LR, LS) to a liblinear format file.
+   *
+   * The file is read in batches of blocks. While the thread pool scores one batch, the
+   * calling thread reads the next one. Predictions are written in input order, one line per
+   * row. The classifiers write "label,score", where for LR the score is the probability of
+   * the positive class and for the SVM it is the margin w.x. LS writes the predicted target
+   * w.x alone.
+   */
+  class LinearScorer {
+  public:
+    /**
+     * @param theta The model. Not owned.
+     * @param algorithm The algorithm which trained theta.
+     * @param num_threads Number of scoring threads.
+     */
+    LinearScorer(fvector const * theta, MLAlgorithm algorithm, int num_threads)
+      : theta_(theta),
+        algorithm_(algorithm),
+        num_threads_(num_threads) {}
+
+    ScoreStats score(std::string const & input_file, std::string const & output_file) const;
+
+  private:
+    fvector const * theta_;
+    MLAlgorithm const algorithm_;
+    int const num_threads_;
+
+    DISABLE_COPY_AND_ASSIGN(LinearScorer);
+  };
+
+  /**
+   * Applies a matrix completion model to a file of (row, column) pairs in the same TSV
+   * format as the training data. A third column, if present, is ignored. Writes
+   * "row\tcolumn\tprediction" lines in input order. Pairs outside of the model's
+   * dimensions are predicted as the global mean.
+   */
+  class MCScorer {
+  public:
+    /**
+     * @param mat_l Left factor matrix. Not owned.
+     * @param mat_r Right factor matrix. Not owned.
+     * @param mean Global mean which was factored out of the training data.
+     * @param num_threads Number of scoring threads.
+     */
+    MCScorer(DenseDataBlock<num_t> const * mat_l,
+             DenseDataBlock<num_t> const * mat_r,
+             double mean,
+             int num_threads)
+      : mat_l_(mat_l),
+        mat_r_(mat_r),
+        mean_(mean),
+        num_threads_(num_threads) {}
+
+    ScoreStats score(std::string const & input_file, std::string const & output_file) const;
+
+  private:
+    DenseDataBlock<num_t> const * mat_l_;
+    DenseDataBlock<num_t> const * mat_r_;
+    double const mean_;
+    int const num_threads_;
+
+    DISABLE_COPY_AND_ASSIGN(MCScorer);
+  };
+
+} // namespace obamadb
+
+#endif //OBAMADB_SCORER_H
@@ -3,6 +3,7 @@
 
 #include "storage/DataBlock.h"
 #include "storage/exvector.h"
+#include "storage/Random.h"
 #include "storage/StorageConstants.h"
 #include "storage/Utils.h"
 
@@ -11,6 +12,7 @@
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <functional>
@@ -46,7 +48,8 @@ namespace obamadb {
       : DataBlock<T>(numRows, numColumns),
         entries_(reinterpret_cast<SDBEntry *>(this->store_)),
         heap_offset_(0),
-        end_of_block_(reinterpret_cast<char *>(this->store_) + this->block_size_bytes_) {}
+        end_of_block_(reinterpret_cast<char *>(this->store_) + this->block_size_bytes_),
+        dense_columns_(0) {}
 
     /**
      * Creates a datablock with the specified size.
@@ -57,20 +60,24 @@ namespace obamadb {
       : DataBlock<T>(size_bytes),
         entries_(reinterpret_cast<SDBEntry *>(this->store_)),
         heap_offset_(0),
-        end_of_block_(reinterpret_cast<char *>(this->store_) + size_bytes) {}
+        end_of_block_(reinterpret_cast<char *>(this->store_) + size_bytes),
+        dense_columns_(0) {}
 
     /**
      * Creates a sparse data block with linearly seperable rows
      * @param size_bytes
      * @param numColumns
      * @param sparsity
+     * @param seed The block's contents are a function of the seed alone.
      */
-    SparseDataBlock(int size_bytes, int numColumns, double sparsity)
+    SparseDataBlock(int size_bytes, int numColumns, double sparsity, std::uint64_t seed)
       : DataBlock<T>(size_bytes),
         entries_(reinterpret_cast<SDBEntry *>(this->store_)),
         heap_offset_(0),
-        end_of_block_(reinterpret_cast<char *>(this->store_) + size_bytes) {
+        end_of_block_(reinterpret_cast<char *>(this->store_) + size_bytes),
+        dense_columns_(0) {
       svector<num_t> row_vector;
+      rng::CounterRng rng(seed, 0);
       double avgElementsPerRow = (1.0 - sparsity) * numColumns;
       int elementWindowSize = std::ceil((double) numColumns / avgElementsPerRow);
       int elementWindows = std::ceil(avgElementsPerRow);
@@ -78,13 +85,13 @@ namespace obamadb {
       num_t negative = -1.0;
       do {
         row_vector.clear();
-        bool isPositive = rand() > INT_MAX/2;
+        bool isPositive = rng.nextInt(2) == 1;
         row_vector.setClassification(isPositive ? &positive : &negative);
         for (int i = 0; i < elementWindows; i++) {
-          int randi = rand() % elementWindowSize;
+          int randi = rng.nextInt(elementWindowSize);
           int index = (i * elementWindowSize) + randi;
           if (index < numColumns) {
-            num_t randf = ((num_t)rand()/(num_t)INT_MAX);
+            num_t randf = rng.nextFloat();
             // The data should end up being perfectly seperable.
             if ((isPositive && index % 2 == 1)
                 || (!isPositive && index % 2 == 0)) {
@@ -97,7 +104,7 @@ namespace obamadb {
       this->finalize();
     }
 
-    SparseDataBlock() : SparseDataBlock(kStorageBlockSize) {}
+    SparseDataBlock() : SparseDataBlock(storageBlockSize()) {}
 
     /**
      * Use this function while initializing to pack the block.
@@ -107,10 +114,32 @@ namespace obamadb {
     bool appendRow(const svector<T> &row);
 
     /**
-     * Blocks which have been finalized no longer can have rows appended to them.
+     * Blocks which have been finalized no longer can have rows appended to them. A block at
+     * least dense_block_density dense is stored densely, see isDense. Otherwise a block which
+     * is less than half full, like the last block of a matrix, is compacted to a smaller size class
+     * of the arena.
      */
     void finalize() {
+      if (!this->initializing_) {
+        return;
+      }
       this->initializing_ = false;
+      if (!densify()) {
+        compact();
+      }
+    }
+
+    /**
+     * @return True if the rows are stored densely. Every row then has the elements of columns 0
+     *    to denseColumns() - 1 in order, zeros included, so its values can go through the
+     *    contiguous kernels of ml, and the rows share a single index array.
+     */
+    inline bool isDense() const {
+      return dense_columns_ > 0;
+    }
+
+    inline std::uint32_t denseColumns() const {
+      return dense_columns_;
     }
 
     DataBlockType getDataBlockType() const override {
@@ -119,12 +148,25 @@ namespace obamadb {
 
     void getRowVector(int row, exvector<T> *vec) const override;
 
+    /**
+     * Drops the last rows. A finalized block is compacted again.
+     * @param numRows Number of rows to drop.
+     */
     void trimRows(int numRows);
 
     inline void getRowVectorFast(const int row, svector<T> *vec) const {
       DCHECK_LT(row, this->num_rows_) << "Row index out of range.";
       DCHECK_EQ(false, vec->owns_memory());
 
+      if (dense_columns_ > 0) {
+        T* values = denseRow(row);
+        vec->num_elements_ = dense_columns_;
+        vec->index_ = reinterpret_cast<int*>(this->store_);
+        vec->values_ = values;
+        vec->class_ = values + dense_columns_;
+        return;
+      }
+
       SDBEntry const &entry = entries_[row];
 
       vec->num_elements_ = entry.size_;
@@ -148,10 +190,35 @@ namespace obamadb {
      */
     inline unsigned remainingSpaceBytes() const;
 
+    /**
+     * Moves the entries and the heap into arena storage of a smaller size class, see
+     * arena::compactBytes, if the block is at most half full. Row offsets are relative to the
+     * end of the heap, which stays right after the entries, so they stay valid.
+     */
+    void compact();
+
+    /**
+     * Rewrites the block densely if at least dense_block_density of its elements are set: the
+     * column indices 0 to num_columns_ - 1 once, then each row as num_columns_ values, with zeros
+     * for the unset columns, and its class. This takes no more memory than the sparse rows.
+     * @return True if the block is now dense.
+     */
+    bool densify();
+
+    /**
+     * @return The values of a row of a dense block.
+     */
+    inline T* denseRow(int row) const {
+      return reinterpret_cast<T*>(reinterpret_cast<int*>(this->store_) + dense_columns_)
+             + static_cast<std::size_t>(row) * (dense_columns_ + 1);
+    }
+
     SDBEntry *entries_;
     unsigned heap_offset_; // the heap grows backwards from the end of the block.
     // The end of last entry offset_ bytes from the end of the structure.
     char *end_of_block_;
+    // Columns of every row if the block is dense, otherwise 0.
+    std::uint32_t dense_columns_;
 
     template<class A>
     friend std::ostream &operator<<(std::ostream &os, const SparseDataBlock<A> &block);
@@ -188,11 +255,71 @@ namespace obamadb {
     return true;
   }
 
+  template<class T>
+  bool SparseDataBlock<T>::densify() {
+    std::uint64_t const columns = this->num_columns_;
+    std::uint64_t const rows = this->num_rows_;
+    if (rows == 0 || columns == 0
+        || numNonZeroElements() < FLAGS_dense_block_density * static_cast<double>(rows * columns)) {
+      return false;
+    }
+    std::uint64_t const bytes = columns * sizeof(int) + rows * (columns + 1) * sizeof(T);
+    if (bytes > UINT32_MAX) {
+      return false;
+    }
+    char* store = memory::allocateArray<char>(bytes);
+    int* index = reinterpret_cast<int*>(store);
+    for (int c = 0; c < columns; c++) {
+      index[c] = c;
+    }
+    T* dense_rows = reinterpret_cast<T*>(index + columns);
+    memset(dense_rows, 0, rows * (columns + 1) * sizeof(T));
+    svector<T> row(0, nullptr);
+    for (int r = 0; r < rows; r++) {
+      getRowVectorFast(r, &row);
+      T* dense_row = dense_rows + r * (columns + 1);
+      for (int j = 0; j < row.num_elements_; j++) {
+        dense_row[row.index_[j]] = row.values_[j];
+      }
+      dense_row[columns] = *row.class_;
+    }
+    this->replaceStore(reinterpret_cast<T*>(store), bytes, DataBlock<T>::StoreSource::kHeap);
+    dense_columns_ = columns;
+    entries_ = nullptr;
+    heap_offset_ = 0;
+    end_of_block_ = nullptr;
+    return true;
+  }
+
+  template<class T>
+  void SparseDataBlock<T>::compact() {
+    std::uint32_t const entries_bytes = this->num_rows_ * sizeof(SDBEntry);
+    std::uint32_t const used_bytes = entries_bytes + heap_offset_;
+    std::uint32_t const store_bytes = arena::compactBytes(this->block_size_bytes_, used_bytes);
+    if (store_bytes >= this->block_size_bytes_) {
+      return;
+    }
+    char* store = static_cast<char*>(arena::allocate(store_bytes));
+    memcpy(store, entries_, entries_bytes);
+    memcpy(store + entries_bytes, end_of_block_ - heap_offset_, heap_offset_);
+    this->replaceStore(reinterpret_cast<T*>(store), store_bytes, DataBlock<T>::StoreSource::kArena);
+    entries_ = reinterpret_cast<SDBEntry *>(this->store_);
+    end_of_block_ = store + used_bytes;
+  }
+
   template<class T>
   void SparseDataBlock<T>::getRowVector(const int row, exvector<T> *vec) const {
     DCHECK_LT(row, this->num_rows_) << "Row index out of range.";
   //  DCHECK(dynamic_cast<se_vector<float_t> *>(vec) != nullptr);
 
+    if (dense_columns_ > 0) {
+      DCHECK(vec->getType() == exvectorType::kSparse) << "Rows of dense blocks are read into svectors.";
+      T* values = denseRow(row);
+      static_cast<svector<T>*>(vec)->setView(dense_columns_, reinterpret_cast<int*>(this->store_),
+                                             values, values + dense_columns_);
+      return;
+    }
+
     SDBEntry const &entry = entries_[row];
     vec->setMemory(entry.size_, end_of_block_ - entry.offset_);
   }
@@ -202,6 +329,12 @@ namespace obamadb {
     DCHECK_LT(row, this->num_rows_) << "Row index out of range.";
     DCHECK_LT(col, this->num_columns_) << "Column index out of range.";
 
+    if (dense_columns_ > 0) {
+      // Zeros were only filled in, so they are not elements.
+      T* value = denseRow(row) + col;
+      return col < dense_columns_ && *value != 0 ? value : nullptr;
+    }
+
     SDBEntry const &entry = entries_[row];
     svector<T> vec(entry.size_, end_of_block_ - entry.offset_);
     T* value = vec.get(col);
@@ -215,11 +348,15 @@ namespace obamadb {
   template<class T>
   void SparseDataBlock<T>::trimRows(int rows) {
     DCHECK_LT(rows, this->num_rows_);
-    for (int row = this->num_rows_ - rows; row < this->num_rows_; row++) {
-      SDBEntry *entry = entries_ + this->num_rows_;
-      heap_offset_ -= entry->size_;
-    }
     this->num_rows_ -= rows;
+    if (dense_columns_ > 0) {
+      return;
+    }
+    // Rows are stacked in order, so the heap ends at the last remaining row.
+    heap_offset_ = this->num_rows_ > 0 ? entries_[this->num_rows_ - 1].offset_ : 0;
+    if (!this->initializing_) {
+      compact();
+    }
   }
 
   template<class T>
@@ -233,6 +370,13 @@ namespace obamadb {
   template<class T>
   int SparseDataBlock<T>::numNonZeroElements() const {
     int nnz = 0;
+    if (dense_columns_ > 0) {
+      for (int i = 0; i < this->num_rows_; i++) {
+        T const * values = denseRow(i);
+        nnz += dense_columns_ - std::count(values, values + dense_columns_, static_cast<T>(0));
+      }
+      return nnz;
+    }
     for (int i = 0; i < this->num_rows_; i++) {
       const SDBEntry & sdbe = entries_[i];
       nnz += sdbe.size_;
@@ -263,8 +407,9 @@ namespace obamadb {
    *
    * @return a caller-owned sparse datablock.
    */
-  static SparseDataBlock<num_t>* GetRandomSparseDataBlock(int blockSizeBytes, int numColumns, double sparsity) {
-    return new SparseDataBlock<num_t>(blockSizeBytes, numColumns, sparsity);
+  static SparseDataBlock<num_t>* GetRandomSparseDataBlock(int blockSizeBytes, int numColumns, double sparsity,
+                                                          std::uint64_t seed) {
+    return new SparseDataBlock<num_t>(blockSizeBytes, numColumns, sparsity, seed);
   }
 }
 
@@ -1,3 +1,63 @@
 #include "storage/StorageConstants.h"
 
-namespace obamadb { }
+#include <algorithm>
+#include <atomic>
+#include <unistd.h>
+
+#include "glog/logging.h"
+
+DEFINE_int64(block_size, 0, "Bytes of each sparse block of training data, or in predict mode of the data"
+  " scored. 0 picks a size from the L2 and last level cache sizes and the number of threads.");
+DEFINE_double(dense_block_density, 0.5, "Blocks of training data with at least this fraction of their"
+  " elements set are stored as dense rows, which the SVM, LR and LS read with vectorized kernels."
+  " Above 1, every block stays sparse.");
+
+namespace obamadb {
+
+  namespace {
+    // Each thread should get at least this many blocks, so uneven blocks even out.
+    int const kMinBlocksPerThread = 8;
+    std::uint64_t const kMinBlockSize = 256 * 1024;
+    // Also the limit of the 32 bit offsets in a block.
+    std::uint64_t const kMaxBlockSize = 1 << 30;
+    // For when the system does not say.
+    std::uint64_t const kDefaultL2Bytes = 1024 * 1024;
+    std::uint64_t const kDefaultLLCBytes = 8 * 1024 * 1024;
+
+    std::atomic<std::uint64_t> block_size(kStorageBlockSize);
+
+    std::uint64_t cacheBytes(int name, std::uint64_t fallback) {
+      long const bytes = sysconf(name);
+      return bytes > 0 ? bytes : fallback;
+    }
+  }
+
+  std::uint64_t storageBlockSize() {
+    return block_size.load(std::memory_order_relaxed);
+  }
+
+  std::uint64_t tuneBlockSize(std::uint64_t data_bytes, int num_threads) {
+    CHECK_GT(num_threads, 0);
+    std::uint64_t size = FLAGS_block_size;
+    if (size == 0) {
+#if defined(_SC_LEVEL2_CACHE_SIZE) && defined(_SC_LEVEL3_CACHE_SIZE)
+      std::uint64_t const l2 = cacheBytes(_SC_LEVEL2_CACHE_SIZE, kDefaultL2Bytes);
+      std::uint64_t const llc = cacheBytes(_SC_LEVEL3_CACHE_SIZE, kDefaultLLCBytes);
+#else
+      std::uint64_t const l2 = kDefaultL2Bytes;
+      std::uint64_t const llc = kDefaultLLCBytes;
+#endif
+      std::uint64_t const cache_limit = std::max(l2, llc / num_threads);
+      std::uint64_t const balanced = data_bytes / (static_cast<std::uint64_t>(num_threads) * kMinBlocksPerThread);
+      size = std::max(kMinBlockSize, std::min(balanced, cache_limit));
+      // Whole pages, which is what the block arena hands out anyway.
+      std::uint64_t const page = sysconf(_SC_PAGESIZE);
+      size = ((size + page - 1) / page) * page;
+    }
+    CHECK_GE(size, 4096) << "block_size is too small for a row.";
+    CHECK_LE(size, kMaxBlockSize) << "block_size is too large.";
+    block_size.store(size);
+    return size;
+  }
+
+}  // namespace obamadb
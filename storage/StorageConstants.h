@@ -3,14 +3,38 @@
 
 #include <cinttypes>
 
+#include <gflags/gflags.h>
+
+DECLARE_int64(block_size);
+DECLARE_double(dense_block_density);
+
 namespace obamadb {
 
   // The basic machine learning number type. Since it can be either floating point or
   // integer type, we call it num(ber) type.
   typedef float num_t;
 
+  // The size of a sparse data block until tuneBlockSize is called.
   const std::uint64_t kStorageBlockSize = 2e6;  // 2 megabytes.
 
+  /**
+   * @return Bytes of a sparse data block made without an explicit size.
+   */
+  std::uint64_t storageBlockSize();
+
+  /**
+   * Sets the size of the sparse data blocks made from now on to block_size, or, if it is 0,
+   * picks one from the cache sizes and thread count. Blocks are at most the larger of L2 and a
+   * thread's share of the LLC, so a block streamed by a worker is not evicted while it reads
+   * it, and small enough that each thread gets several blocks to balance.
+   * @param data_bytes Estimated size of the data about to be loaded.
+   * @param num_threads Threads the data will be split between.
+   * @return The block size chosen.
+   */
+  std::uint64_t tuneBlockSize(std::uint64_t data_bytes, int num_threads);
+
+  const int kCacheLineBytes = 64;
+
 }  // namespace obamadb
 
 #endif //OBAMADB_STORAGECONSTANTS_H_
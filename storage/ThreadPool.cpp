@@ -1,40 +1,71 @@
+#include "storage/PerfCounters.h"
+#include "storage/Random.h"
+#include "storage/Trace.h"
 #include "storage/Utils.h"
 
+#include <memory>
+#include <string>
+
 #include "glog/logging.h"
 #include <gflags/gflags.h>
 
 #include "ThreadPool.h"
 
-DECLARE_string(core_affinities);
+DEFINE_string(core_affinities, "-1", "A comma separated list of cores to have threads bind to."
+  " The program will greedily use core, so over specify if you like. Ex: "
+  " -core_affinities 0,1,2,3 -threads 2 is valid");
 
 namespace obamadb {
 
   namespace threading {
     int getCoreAffinity() {
+      int assigned = peekCoreAffinity(0);
+      NumThreadsAffinitized++;
+      return assigned;
+    }
+
+    int peekCoreAffinity(int offset) {
       if (FLAGS_core_affinities.compare("-1") == 0) {
-        return NumThreadsAffinitized++;
+        return NumThreadsAffinitized + offset;
       } else if (CoreAffinities.size() == 0) {
         std::vector<int> parsedAffinities = GetIntList(FLAGS_core_affinities);
         CoreAffinities.insert(CoreAffinities.begin(), parsedAffinities.begin(), parsedAffinities.end());
       }
       CHECK(CoreAffinities.size() > 0) << "invalid core_affinity flag";
-      int assigned = CoreAffinities[NumThreadsAffinitized % CoreAffinities.size()];
-      NumThreadsAffinitized++;
-      return assigned;
+      return CoreAffinities[(NumThreadsAffinitized + offset) % CoreAffinities.size()];
+    }
+
+    void resetCoreAffinities() {
+      NumThreadsAffinitized = 0;
+      CoreAffinities.clear();
     }
   }
 
   void *WorkerLoop(void *worker_params) {
     ThreadMeta *meta = reinterpret_cast<ThreadMeta*>(worker_params);
-    int assigned_core = threading::getCoreAffinity();
-    threading::setCoreAffinity(assigned_core);
+    rng::seedThread(meta->thread_id);
+    threading::setCoreAffinity(meta->core_id);
+    trace::setThreadName("worker " + std::to_string(meta->thread_id));
+    // Counters follow the thread which opens them, so they are opened here.
+    std::unique_ptr<perf::ThreadCounters> counters;
+    if (FLAGS_perf_counters) {
+      counters.reset(new perf::ThreadCounters());
+    }
     int epoch = 0;
     while (true) {
       meta->barrier1->wait();
       if (meta->stop) {
         break;
-      } else {
-        meta->fn_execute_(meta->thread_id, meta->state_);
+      }
+      {
+        trace::Scope scope("task", "pool");
+        if (counters) {
+          counters->start();
+          meta->fn_execute_(meta->thread_id, meta->state_);
+          meta->counters = counters->stop();
+        } else {
+          meta->fn_execute_(meta->thread_id, meta->state_);
+        }
       }
       meta->barrier2->wait();
       epoch++;
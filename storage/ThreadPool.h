@@ -16,6 +16,10 @@
 #include <unistd.h>
 #include <vector>
 
+#include "storage/MemoryAccounting.h"
+#include "storage/PerfCounters.h"
+#include "storage/Trace.h"
+
 #include "glog/logging.h"
 #include <gflags/gflags.h>
 
@@ -36,6 +40,7 @@ namespace obamadb {
           threshold_(totalWaiters) {}
 
       void wait() {
+        trace::Scope scope("barrier", "sync");
         int epoch_stackvar = epoch_;
         std::unique_lock<std::mutex> lock{mutex_};
         if (!--count_) {
@@ -83,6 +88,25 @@ namespace obamadb {
 #endif
    }
 
+    /**
+     * Runs fn(thread_id) on num_threads new threads and waits for them to finish. For
+     * one-off parallel loops which do not warrant a ThreadPool. The threads allocate for the
+     * calling thread's memory::Subsystem.
+     */
+    inline void runThreads(int num_threads, std::function<void(int)> const & fn) {
+      memory::Subsystem const subsystem = memory::current();
+      std::vector<std::thread> threads;
+      for (int t = 0; t < num_threads; t++) {
+        threads.push_back(std::thread([&fn, subsystem](int thread_id) {
+          memory::SubsystemScope scope(subsystem);
+          fn(thread_id);
+        }, t));
+      }
+      for (std::thread & thread : threads) {
+        thread.join();
+      }
+    }
+
     static int NumThreadsAffinitized;
     static std::vector<int> CoreAffinities;
 
@@ -94,6 +118,19 @@ namespace obamadb {
      */
     int getCoreAffinity();
 
+    /**
+     * @param offset
+     * @return The core which getCoreAffinity will hand out offset calls from now. Lets threads
+     *    which prepare data for a ThreadPool run on the cores its workers will be bound to.
+     */
+    int peekCoreAffinity(int offset);
+
+    /**
+     * Starts handing out cores from the beginning of the core_affinities list again, which is
+     * re-read. For running several configurations in one process.
+     */
+    void resetCoreAffinities();
+
     int numCores();
 
   } // end namespace threading
@@ -112,6 +149,8 @@ struct ThreadMeta {
     barrier2(barrier2),
     fn_execute_(task_fn),
     state_(state),
+    core_id(-1),
+    counters(),
     stop(false) {}
 
   int thread_id;
@@ -122,6 +161,12 @@ struct ThreadMeta {
   std::function<void(int, void*)> fn_execute_;
   void* state_;
 
+  // Core the worker binds to. Assigned in thread id order before the workers start.
+  int core_id;
+
+  // Hardware counts of the worker's last task execution, if -perf_counters is set.
+  perf::Sample counters;
+
   bool stop;
 };
 
@@ -183,12 +228,16 @@ public:
    * Only call this method once.
    */
   void begin() {
+    for (unsigned i = 0; i < num_workers_; i++) {
+      meta_info_[i].core_id = threading::getCoreAffinity();
+    }
     for (unsigned i = 0; i < num_workers_; i++) {
       threads_.push_back(new std::thread(WorkerLoop, static_cast<void*>(&meta_info_[i])));
     }
   }
 
   void cycle() {
+    trace::Scope scope("cycle", "pool");
     b1_->wait();
     // workers do the routine
     b2_->wait();
@@ -196,6 +245,22 @@ public:
     // Here is an opportunity to re-allocate work, and do an update to the model.
   }
 
+  /**
+   * The first half of cycle. Releases the workers and returns while they run, so the calling
+   * thread can do other work, like reading the next input, before it calls finishCycle.
+   */
+  void startCycle() {
+    b1_->wait();
+  }
+
+  /**
+   * The second half of cycle. Waits for the workers to finish.
+   */
+  void finishCycle() {
+    trace::Scope scope("finish cycle", "pool");
+    b2_->wait();
+  }
+
   int getWaiterCount() const {
     return b2_->count();
   }
@@ -204,6 +269,18 @@ public:
     return num_workers_;
   }
 
+  /**
+   * Call between cycles.
+   * @return The hardware counts of each worker over the last cycle. See -perf_counters.
+   */
+  std::vector<perf::Sample> getCounters() const {
+    std::vector<perf::Sample> samples;
+    for (ThreadMeta const & meta : meta_info_) {
+      samples.push_back(meta.counters);
+    }
+    return samples;
+  }
+
   void stop() {
     for (unsigned i = 0; i < num_workers_; i++) {
       meta_info_[i].stop = true;
@@ -0,0 +1,217 @@
+#include "storage/TopK.h"
+
+#include "storage/DenseDataBlock.h"
+#include "storage/exvector.h"
+#include "storage/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+#include "glog/logging.h"
+
+namespace obamadb {
+
+  namespace {
+    inline bool scoreGreater(Recommendation const & a, Recommendation const & b) {
+      return a.score > b.score;
+    }
+
+    /**
+     * Keeps the k largest offered items. The heap's front is the smallest of them.
+     */
+    inline void offer(std::vector<Recommendation> & heap, int k, int item, num_t score) {
+      if (heap.size() < k) {
+        heap.push_back(Recommendation(item, score));
+        std::push_heap(heap.begin(), heap.end(), scoreGreater);
+      } else if (score > heap.front().score) {
+        std::pop_heap(heap.begin(), heap.end(), scoreGreater);
+        heap.back() = Recommendation(item, score);
+        std::push_heap(heap.begin(), heap.end(), scoreGreater);
+      }
+    }
+
+    num_t norm(dvector<num_t> const & vec) {
+      double sum = 0;
+      for (int i = 0; i < vec.size(); i++) {
+        sum += vec.values_[i] * vec.values_[i];
+      }
+      return std::sqrt(sum);
+    }
+  }
+
+  int const TopKRecommender::kUserTile;
+  int const TopKRecommender::kItemPanel;
+
+  TopKRecommender::TopKRecommender(DenseDataBlock<num_t> const * mat_l,
+                                   DenseDataBlock<num_t> const * mat_r,
+                                   double mean,
+                                   int k,
+                                   bool prune)
+    : mat_l_(mat_l),
+      mat_r_(mat_r),
+      mean_(mean),
+      k_(std::min<int>(k, mat_r->getNumRows())),
+      prune_(prune),
+      rank_(mat_l->getNumColumns()),
+      packed_(),
+      panel_items_(),
+      panel_max_norm_() {
+    CHECK_EQ(mat_l->getNumColumns(), mat_r->getNumColumns()) << "Factor matrices have different ranks.";
+    CHECK_GT(k, 0);
+
+    int const num_items = mat_r->getNumRows();
+    std::vector<num_t> norms(num_items);
+    std::vector<int> order(num_items);
+    dvector<num_t> row(0, nullptr);
+    for (int i = 0; i < num_items; i++) {
+      mat_r->getRowVectorFast(i, &row);
+      norms[i] = norm(row);
+      order[i] = i;
+    }
+    if (prune_) {
+      std::sort(order.begin(), order.end(), [&norms](int a, int b) { return norms[a] > norms[b]; });
+    }
+
+    int const num_panels = (num_items + kItemPanel - 1) / kItemPanel;
+    packed_.assign(static_cast<std::size_t>(num_panels) * rank_ * kItemPanel, 0);
+    panel_items_.assign(num_panels * kItemPanel, -1);
+    panel_max_norm_.assign(num_panels, 0);
+    for (int i = 0; i < num_items; i++) {
+      int const panel = i / kItemPanel;
+      int const lane = i % kItemPanel;
+      int const item = order[i];
+      mat_r->getRowVectorFast(item, &row);
+      for (int d = 0; d < rank_; d++) {
+        packed_[(static_cast<std::size_t>(panel) * rank_ + d) * kItemPanel + lane] = row.values_[d];
+      }
+      panel_items_[i] = item;
+      panel_max_norm_[panel] = std::max(panel_max_norm_[panel], norms[item]);
+    }
+  }
+
+  std::uint64_t TopKRecommender::recommend(int first_user, int last_user, Recommendation * out) const {
+    int const num_panels = panel_max_norm_.size();
+    std::vector<std::vector<Recommendation>> heaps(kUserTile);
+    for (auto & heap : heaps) {
+      heap.reserve(k_);
+    }
+    num_t scores[kUserTile][kItemPanel];
+    num_t user_norms[kUserTile];
+    num_t const * users[kUserTile];
+    dvector<num_t> row(0, nullptr);
+    std::uint64_t panels_scored = 0;
+
+    for (int tile_start = first_user; tile_start < last_user; tile_start += kUserTile) {
+      int const tile_users = std::min(kUserTile, last_user - tile_start);
+      for (int u = 0; u < tile_users; u++) {
+        mat_l_->getRowVectorFast(tile_start + u, &row);
+        users[u] = row.values_;
+        user_norms[u] = norm(row);
+        heaps[u].clear();
+      }
+
+      for (int p = 0; p < num_panels; p++) {
+        if (prune_) {
+          bool any_active = false;
+          for (int u = 0; u < tile_users && !any_active; u++) {
+            any_active = heaps[u].size() < k_
+                         || user_norms[u] * panel_max_norm_[p] + mean_ > heaps[u].front().score;
+          }
+          if (!any_active) {
+            break;
+          }
+        }
+        panels_scored++;
+
+        num_t const * panel = packed_.data() + static_cast<std::size_t>(p) * rank_ * kItemPanel;
+        for (int u = 0; u < tile_users; u++) {
+          num_t * __restrict__ const s = scores[u];
+          num_t const * __restrict__ const lu = users[u];
+          for (int i = 0; i < kItemPanel; i++) {
+            s[i] = mean_;
+          }
+          for (int d = 0; d < rank_; d++) {
+            num_t const lud = lu[d];
+            num_t const * __restrict__ const col = panel + d * kItemPanel;
+            for (int i = 0; i < kItemPanel; i++) {
+              s[i] += lud * col[i];
+            }
+          }
+        }
+
+        int const * items = panel_items_.data() + p * kItemPanel;
+        for (int u = 0; u < tile_users; u++) {
+          for (int i = 0; i < kItemPanel; i++) {
+            if (items[i] >= 0) {
+              offer(heaps[u], k_, items[i], scores[u][i]);
+            }
+          }
+        }
+      }
+
+      for (int u = 0; u < tile_users; u++) {
+        std::sort(heaps[u].begin(), heaps[u].end(), scoreGreater);
+        std::copy(heaps[u].begin(), heaps[u].end(), out + static_cast<std::size_t>(tile_start - first_user + u) * k_);
+      }
+    }
+    return panels_scored;
+  }
+
+  namespace {
+    struct RecommendState {
+      TopKRecommender const * recommender;
+      Recommendation * out;
+      std::atomic<int> next_tile;
+      std::atomic<std::uint64_t> panels_scored;
+    };
+  }
+
+  std::vector<Recommendation> TopKRecommender::recommendAll(int num_threads) const {
+    std::vector<Recommendation> recommendations(static_cast<std::size_t>(numUsers()) * k_);
+    RecommendState state;
+    state.recommender = this;
+    state.out = recommendations.data();
+    state.next_tile = 0;
+    state.panels_scored = 0;
+
+    // Tiles are handed out dynamically since pruning makes their cost uneven.
+    auto worker_fn = [](int tid, void* ptr) {
+      (void) tid;
+      RecommendState* state = reinterpret_cast<RecommendState*>(ptr);
+      TopKRecommender const * recommender = state->recommender;
+      int const tile_size = kUserTile * 16;
+      int const num_users = recommender->numUsers();
+      std::uint64_t panels = 0;
+      int first;
+      while ((first = state->next_tile.fetch_add(tile_size)) < num_users) {
+        int const last = std::min(first + tile_size, num_users);
+        panels += recommender->recommend(first, last, state->out + static_cast<std::size_t>(first) * recommender->k());
+      }
+      state->panels_scored += panels;
+    };
+    ThreadPool tp(worker_fn, &state, num_threads);
+    tp.begin();
+    tp.cycle();
+    tp.stop();
+
+    std::uint64_t const total_panels =
+      static_cast<std::uint64_t>((numUsers() + kUserTile - 1) / kUserTile) * panel_max_norm_.size();
+    DLOG(INFO) << "Top-K scored " << state.panels_scored << " of " << total_panels << " user tile/item panel pairs";
+    return recommendations;
+  }
+
+  void TopKRecommender::write(std::string const & file_name, std::vector<Recommendation> const & recommendations) const {
+    FILE* out = fopen(file_name.c_str(), "w");
+    CHECK(out != nullptr) << "Unable to open " << file_name << " for output.";
+    setvbuf(out, nullptr, _IOFBF, 1 << 20);
+    for (std::size_t i = 0; i < recommendations.size(); i++) {
+      Recommendation const & rec = recommendations[i];
+      fprintf(out, "%d\t%d\t%.6f\n", static_cast<int>(i / k_), rec.item, rec.score);
+    }
+    fclose(out);
+  }
+
+} // namespace obamadb
@@ -0,0 +1,108 @@
+#ifndef OBAMADB_TOPK_H
+#define OBAMADB_TOPK_H
+
+#include "storage/DenseDataBlock.h"
+#include "storage/StorageConstants.h"
+#include "storage/Utils.h"
+
+#include <string>
+#include <vector>
+
+namespace obamadb {
+
+  struct Recommendation {
+    Recommendation()
+      : item(-1),
+        score(0) {}
+
+    Recommendation(int item, num_t score)
+      : item(item),
+        score(score) {}
+
+    int item;
+    num_t score;
+  };
+
+  /**
+   * Finds the K highest scoring items (rows of R) for each user (rows of L) of a matrix
+   * completion model, where score(u, i) = L[u] . R[i] + mean.
+   *
+   * R is packed once into panels of kItemPanel items stored rank-major, so scoring a tile
+   * of users against a panel is a small GEMM whose inner loop runs over contiguous items and
+   * vectorizes. Each worker keeps a bounded min-heap per user in its tile.
+   *
+   * With pruning, items are packed in order of decreasing norm. By Cauchy-Schwarz no item in
+   * a panel can beat a user's current K-th score once |L[u]| * |R[i]| falls below it, so the
+   * remaining panels are skipped. The results are the same as without pruning.
+   */
+  class TopKRecommender {
+  public:
+    /**
+     * @param mat_l User factors. Not owned.
+     * @param mat_r Item factors. Not owned.
+     * @param mean The global mean which was factored out of the training data.
+     * @param k Number of items to recommend for each user.
+     * @param prune Skip items whose norm bound cannot make it into the top K.
+     */
+    TopKRecommender(DenseDataBlock<num_t> const * mat_l,
+                    DenseDataBlock<num_t> const * mat_r,
+                    double mean,
+                    int k,
+                    bool prune);
+
+    /**
+     * Computes recommendations for every user.
+     * @return numUsers() * k() recommendations. Each user's are sorted by decreasing score.
+     */
+    std::vector<Recommendation> recommendAll(int num_threads) const;
+
+    /**
+     * Computes recommendations for users [first_user, last_user).
+     * @param out Receives (last_user - first_user) * k() recommendations.
+     * @return The number of item panels which were scored.
+     */
+    std::uint64_t recommend(int first_user, int last_user, Recommendation * out) const;
+
+    /**
+     * Writes "user\titem\tscore" lines.
+     */
+    void write(std::string const & file_name, std::vector<Recommendation> const & recommendations) const;
+
+    int numUsers() const {
+      return mat_l_->getNumRows();
+    }
+
+    int numItems() const {
+      return mat_r_->getNumRows();
+    }
+
+    /**
+     * @return The number of recommendations per user. Less than requested if there are fewer items.
+     */
+    int k() const {
+      return k_;
+    }
+
+    static int const kUserTile = 8;
+    static int const kItemPanel = 64;
+
+  private:
+    DenseDataBlock<num_t> const * mat_l_;
+    DenseDataBlock<num_t> const * mat_r_;
+    num_t const mean_;
+    int const k_;
+    bool const prune_;
+    int const rank_;
+
+    // Panel p holds items panel_items_[p * kItemPanel, (p+1) * kItemPanel) with the values
+    // of dimension d stored contiguously at packed_[(p * rank + d) * kItemPanel].
+    std::vector<num_t> packed_;
+    std::vector<int> panel_items_; // -1 for padding
+    std::vector<num_t> panel_max_norm_;
+
+    DISABLE_COPY_AND_ASSIGN(TopKRecommender);
+  };
+
+} // namespace obamadb
+
+#endif //OBAMADB_TOPK_H
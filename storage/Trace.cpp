@@ -0,0 +1,163 @@
+#include "storage/Trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "glog/logging.h"
+
+DEFINE_string(trace_file, "", "If set, a timeline of the barriers, tasks, loading and evaluation of every"
+  " thread is written to this file as Chrome trace JSON when the program ends. Open it in Perfetto.");
+
+namespace obamadb {
+
+  namespace trace {
+
+    namespace {
+      /**
+       * The events of one thread. Only that thread writes, so the only synchronization needed
+       * is for the dump to see the events before the count, which the release store gives.
+       */
+      struct ThreadBuffer {
+        explicit ThreadBuffer(int tid)
+          : tid(tid),
+            name(),
+            events(kEventsPerThread),
+            recorded(0),
+            in_use(true) { }
+
+        int const tid;
+        std::string name;
+        std::vector<Event> events;
+        std::atomic<std::uint64_t> recorded;
+        bool in_use; // guarded by registry_mutex.
+      };
+
+      std::mutex registry_mutex;
+      std::vector<std::unique_ptr<ThreadBuffer>> registry;
+
+      /**
+       * Hands the buffer of a thread back to the registry when the thread exits.
+       */
+      struct BufferLease {
+        BufferLease() : buffer(nullptr) { }
+
+        ~BufferLease() {
+          if (buffer != nullptr) {
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            buffer->in_use = false;
+          }
+        }
+
+        ThreadBuffer* buffer;
+      };
+
+      thread_local BufferLease thread_lease;
+
+      /**
+       * Gives the calling thread a buffer which an exited thread of the same name left behind,
+       * or a new one. Threads are recreated for every trial, so without reuse the buffers
+       * would grow with trials times threads.
+       */
+      ThreadBuffer* acquireBuffer(std::string const & name) {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        for (std::unique_ptr<ThreadBuffer> const & buffer : registry) {
+          if (!buffer->in_use && buffer->name == name) {
+            buffer->in_use = true;
+            thread_lease.buffer = buffer.get();
+            return thread_lease.buffer;
+          }
+        }
+        registry.push_back(std::unique_ptr<ThreadBuffer>(new ThreadBuffer(registry.size())));
+        registry.back()->name = name;
+        thread_lease.buffer = registry.back().get();
+        return thread_lease.buffer;
+      }
+
+      ThreadBuffer* threadBuffer() {
+        if (thread_lease.buffer == nullptr) {
+          return acquireBuffer(std::string());
+        }
+        return thread_lease.buffer;
+      }
+
+      void writeString(FILE* file, std::string const & value) {
+        fputc('"', file);
+        for (char c : value) {
+          if (c == '"' || c == '\\') {
+            fputc('\\', file);
+          }
+          fputc(c, file);
+        }
+        fputc('"', file);
+      }
+    }
+
+    namespace internal {
+      std::atomic<bool> recording(false);
+
+      void record(Event const & event) {
+        ThreadBuffer* buffer = threadBuffer();
+        std::uint64_t const recorded = buffer->recorded.load(std::memory_order_relaxed);
+        buffer->events[recorded % kEventsPerThread] = event;
+        buffer->recorded.store(recorded + 1, std::memory_order_release);
+      }
+    }
+
+    void start() {
+      internal::recording.store(true);
+    }
+
+    void setThreadName(std::string const & name) {
+      if (!enabled()) {
+        return;
+      }
+      if (thread_lease.buffer == nullptr) {
+        acquireBuffer(name);
+      } else {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        thread_lease.buffer->name = name;
+      }
+    }
+
+    void dump(std::string const & file_name) {
+      FILE* file = fopen(file_name.c_str(), "w");
+      CHECK(file != nullptr) << "Could not open trace file " << file_name;
+
+      std::lock_guard<std::mutex> lock(registry_mutex);
+      fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+      bool first = true;
+      for (std::unique_ptr<ThreadBuffer> const & buffer : registry) {
+        if (!buffer->name.empty()) {
+          fprintf(file, "%s\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":",
+                  first ? "" : ",", buffer->tid);
+          writeString(file, buffer->name);
+          fprintf(file, "}}");
+          first = false;
+        }
+
+        std::uint64_t const recorded = buffer->recorded.load(std::memory_order_acquire);
+        std::uint64_t const kept = std::min<std::uint64_t>(recorded, kEventsPerThread);
+        for (std::uint64_t i = recorded - kept; i < recorded; i++) {
+          Event const & event = buffer->events[i % kEventsPerThread];
+          // Chrome trace timestamps are in microseconds.
+          fprintf(file, "%s\n{\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"name\":",
+                  first ? "" : ",", buffer->tid, event.begin_ns / 1e3, event.duration_ns / 1e3);
+          writeString(file, event.name);
+          fprintf(file, ",\"cat\":");
+          writeString(file, event.category);
+          fprintf(file, "}");
+          first = false;
+        }
+        LOG_IF(WARNING, recorded > kept) << "Trace of thread " << buffer->tid << " dropped its oldest "
+                                         << recorded - kept << " events.";
+      }
+      fprintf(file, "\n]}\n");
+      fclose(file);
+    }
+
+  } // namespace trace
+
+} // namespace obamadb
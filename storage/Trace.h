@@ -0,0 +1,104 @@
+#ifndef OBAMADB_TRACE_H
+#define OBAMADB_TRACE_H
+
+#include "storage/Utils.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include <gflags/gflags.h>
+
+DECLARE_string(trace_file);
+
+namespace obamadb {
+
+  /**
+   * A timeline of what every thread was doing, written as Chrome trace JSON which Perfetto and
+   * chrome://tracing open.
+   *
+   * Each thread records into its own ring buffer, so recording takes no locks and touches no
+   * shared cache lines. A buffer keeps the most recent kEventsPerThread events of its thread.
+   * Buffers outlive their threads and are written out together by dump(). When a thread exits,
+   * its buffer goes to the next thread of the same name, which continues its timeline.
+   */
+  namespace trace {
+
+    /**
+     * A timed span on one thread. Names and categories must be string literals, or otherwise
+     * outlive the dump.
+     */
+    struct Event {
+      char const * name;
+      char const * category;
+      std::int64_t begin_ns;
+      std::int64_t duration_ns;
+    };
+
+    int const kEventsPerThread = 1 << 16;
+
+    namespace internal {
+      extern std::atomic<bool> recording;
+
+      void record(Event const & event);
+    }
+
+    /**
+     * @return True if events are being recorded. Only call the rest while this holds.
+     */
+    inline bool enabled() {
+      return internal::recording.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Starts recording events.
+     */
+    void start();
+
+    /**
+     * Names the calling thread in the timeline.
+     */
+    void setThreadName(std::string const & name);
+
+    /**
+     * Writes the events of all threads, oldest first within a thread, as Chrome trace JSON.
+     * Threads should not be recording meanwhile.
+     */
+    void dump(std::string const & file_name);
+
+    inline std::int64_t nowNs() {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * Records its lifetime as an event, if recording.
+     */
+    class Scope {
+    public:
+      Scope(char const * name, char const * category)
+        : name_(name),
+          category_(category),
+          begin_ns_(enabled() ? nowNs() : -1) { }
+
+      ~Scope() {
+        if (begin_ns_ >= 0) {
+          Event const event = {name_, category_, begin_ns_, nowNs() - begin_ns_};
+          internal::record(event);
+        }
+      }
+
+    private:
+      char const * const name_;
+      char const * const category_;
+      std::int64_t const begin_ns_;
+
+      DISABLE_COPY_AND_ASSIGN(Scope);
+    };
+
+  } // namespace trace
+
+} // namespace obamadb
+
+#endif //OBAMADB_TRACE_H
@@ -1,11 +1,260 @@
 #include "UnorderedMatrix.h"
 
+#include "storage/RadixSort.h"
+#include "storage/ThreadPool.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
 namespace obamadb {
+
+  namespace {
+    // Entries are indexed by int, so there is no use in reserving more than this.
+    std::size_t const kMaxReservedEntries = static_cast<std::size_t>(INT_MAX) + 1;
+
+    std::size_t pageRoundUp(std::size_t bytes) {
+      std::size_t const page = sysconf(_SC_PAGESIZE);
+      return ((bytes + page - 1) / page) * page;
+    }
+
+    std::size_t reservationBytes(std::size_t entries) {
+      return pageRoundUp(entries * sizeof(MatrixEntry));
+    }
+
+    /**
+     * Reserves address space without committing memory. Halves the request until the
+     * system accepts it, for example when the address space is limited by ulimit -v.
+     * @param entries In: requested entries. Out: entries actually reserved.
+     */
+    MatrixEntry* reserveAddressSpace(std::size_t * entries) {
+      std::size_t const min_entries = UnorderedMatrix::kSegmentEntries;
+      while (true) {
+        void* region = mmap(nullptr, reservationBytes(*entries), PROT_NONE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (region != MAP_FAILED) {
+          return reinterpret_cast<MatrixEntry*>(region);
+        }
+        CHECK_GT(*entries, min_entries) << "Unable to reserve memory for matrix entries.";
+        *entries = std::max(min_entries, *entries / 2);
+      }
+    }
+
+    /**
+     * @return Readable and writable memory for exactly the given number of entries.
+     */
+    MatrixEntry* allocateEntries(std::size_t entries) {
+      void* region = mmap(nullptr, reservationBytes(entries), PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      CHECK(region != MAP_FAILED) << "Unable to allocate memory for matrix entries.";
+      return reinterpret_cast<MatrixEntry*>(region);
+    }
+
+    /**
+     * @return The number of bits needed to represent values in [0, value).
+     */
+    int bitsFor(int value) {
+      int bits = 0;
+      while (bits < 31 && (1 << bits) < value) {
+        bits++;
+      }
+      return bits;
+    }
+
+    /**
+     * The distance along a Hilbert curve filling a (2^side_bits)^2 grid of point (x, y).
+     */
+    std::uint64_t hilbertIndex(int side_bits, std::uint32_t x, std::uint32_t y) {
+      std::uint32_t const n = static_cast<std::uint32_t>(1) << side_bits;
+      std::uint64_t d = 0;
+      for (std::uint32_t s = n >> 1; s > 0; s >>= 1) {
+        std::uint32_t const rx = (x & s) > 0;
+        std::uint32_t const ry = (y & s) > 0;
+        d += static_cast<std::uint64_t>(s) * s * ((3 * rx) ^ ry);
+        // Rotate the quadrant so the curve inside it has the canonical orientation.
+        if (ry == 0) {
+          if (rx == 1) {
+            x = n - 1 - x;
+            y = n - 1 - y;
+          }
+          std::swap(x, y);
+        }
+      }
+      return d;
+    }
+  }
+
+  // 12 byte entries * 2^18 = 3MB, a multiple of any page size we expect to see.
+  std::size_t const UnorderedMatrix::kSegmentEntries = 1 << 18;
+
+  // 24MB of address space, which a process can hold for many matrices at once.
+  std::size_t const UnorderedMatrix::kInitialReservedEntries = 8 * UnorderedMatrix::kSegmentEntries;
+
+  int const UnorderedMatrix::kHilbertTileBits = 9;
+
+  UnorderedMatrix::UnorderedMatrix()
+    : rows_(0),
+      columns_(0),
+      size_(0),
+      committed_(0),
+      reserved_(kInitialReservedEntries),
+      entries_(nullptr),
+      subsystem_(memory::current()) {
+    entries_ = reserveAddressSpace(&reserved_);
+  }
+
+  UnorderedMatrix::~UnorderedMatrix() {
+    setCommitted(0);
+    if (entries_ != nullptr) {
+      munmap(entries_, reservationBytes(reserved_));
+    }
+  }
+
+  void UnorderedMatrix::grow() {
+    commit(committed_ + kSegmentEntries);
+  }
+
+  void UnorderedMatrix::commit(std::size_t entries) {
+    entries = ((entries + kSegmentEntries - 1) / kSegmentEntries) * kSegmentEntries;
+    if (entries <= committed_) {
+      return;
+    }
+    if (entries > reserved_) {
+      relocate(std::min(kMaxReservedEntries, std::max(reserved_ * 2, entries)), entries);
+    }
+    // The page holding the last committed entry is already writable.
+    char* segment = reinterpret_cast<char*>(entries_) + reservationBytes(committed_);
+    std::size_t const segment_bytes = reservationBytes(entries) - reservationBytes(committed_);
+    CHECK_EQ(0, mprotect(segment, segment_bytes, PROT_READ | PROT_WRITE))
+      << "Unable to commit memory for matrix entries.";
+    setCommitted(entries);
+  }
+
+  MatrixEntry* UnorderedMatrix::extend(std::size_t count) {
+    CHECK_LE(size_ + count, kMaxReservedEntries) << "Too many matrix entries.";
+    commit(size_ + count);
+    MatrixEntry* first = entries_ + size_;
+    size_ += count;
+    return first;
+  }
+
+  void UnorderedMatrix::relocate(std::size_t reserve_entries, std::size_t required_entries) {
+    MatrixEntry* region = reserveAddressSpace(&reserve_entries);
+    CHECK_GE(reserve_entries, required_entries) << "Unable to reserve memory for matrix entries.";
+    if (committed_ > 0) {
+      CHECK_EQ(0, mprotect(region, reservationBytes(committed_), PROT_READ | PROT_WRITE))
+        << "Unable to commit memory for matrix entries.";
+      memcpy(region, entries_, sizeof(MatrixEntry) * size_);
+    }
+    if (entries_ != nullptr) {
+      munmap(entries_, reservationBytes(reserved_));
+    }
+    entries_ = region;
+    reserved_ = reserve_entries;
+  }
+
+  void UnorderedMatrix::shrinkToFit() {
+    std::size_t const used_bytes = reservationBytes(size_);
+    std::size_t const reserved_bytes = reservationBytes(reserved_);
+    if (used_bytes < reserved_bytes) {
+      munmap(reinterpret_cast<char*>(entries_) + used_bytes, reserved_bytes - used_bytes);
+    }
+    if (used_bytes == 0) {
+      entries_ = nullptr;
+    }
+    setCommitted(used_bytes / sizeof(MatrixEntry));
+    reserved_ = committed_;
+  }
+
+  void UnorderedMatrix::reorder(EntryOrder order, int num_threads) {
+    if (order == EntryOrder::kFile || size_ < 2) {
+      return;
+    }
+    CHECK_GT(num_threads, 0);
+    num_threads = std::min<std::size_t>(num_threads, size_);
+
+    int const row_bits = bitsFor(rows_);
+    int const column_bits = bitsFor(columns_);
+    int key_bits = row_bits + column_bits;
+    int tile_bits = 0;
+    int hilbert_side_bits = 0;
+    if (order == EntryOrder::kHilbert) {
+      tile_bits = std::min(kHilbertTileBits, std::max(row_bits, column_bits));
+      hilbert_side_bits = std::max(row_bits, column_bits) - tile_bits;
+      key_bits = 2 * (hilbert_side_bits + tile_bits);
+    }
+
+    std::vector<std::uint64_t> keys(size_);
+    std::vector<std::size_t> slice_bounds(num_threads + 1);
+    for (int t = 0; t <= num_threads; t++) {
+      slice_bounds[t] = (size_ * t) / num_threads;
+    }
+    threading::runThreads(num_threads, [&](int t) {
+      std::uint32_t const tile_mask = (static_cast<std::uint32_t>(1) << tile_bits) - 1;
+      for (std::size_t i = slice_bounds[t]; i < slice_bounds[t + 1]; i++) {
+        std::uint64_t const row = entries_[i].row;
+        std::uint64_t const column = entries_[i].column;
+        if (order == EntryOrder::kRowMajor) {
+          keys[i] = (row << column_bits) | column;
+        } else {
+          std::uint64_t const tile = hilbertIndex(hilbert_side_bits, row >> tile_bits, column >> tile_bits);
+          keys[i] = (tile << (2 * tile_bits)) | ((row & tile_mask) << tile_bits) | (column & tile_mask);
+        }
+      }
+    });
+
+    std::vector<std::uint64_t> keys_scratch(size_);
+    MatrixEntry* scratch = allocateEntries(size_);
+    std::int64_t const scratch_bytes = reservationBytes(size_);
+    memory::add(subsystem_, scratch_bytes);
+    if (sorting::radixSort(keys.data(), entries_, keys_scratch.data(), scratch, size_, key_bits, num_threads)) {
+      adopt(scratch);
+    } else {
+      munmap(scratch, reservationBytes(size_));
+      shrinkToFit();
+    }
+    memory::add(subsystem_, -scratch_bytes);
+  }
+
+  std::vector<std::size_t> UnorderedMatrix::partition(EntryField field, int num_partitions, int num_threads) {
+    if (size_ == 0) {
+      return std::vector<std::size_t>(num_partitions + 1, 0);
+    }
+    int const dimension = field == EntryField::kRow ? rows_ : columns_;
+    MatrixEntry* partitioned = allocateEntries(size_);
+    std::int64_t const partitioned_bytes = reservationBytes(size_);
+    memory::add(subsystem_, partitioned_bytes);
+    std::vector<std::size_t> offsets = sorting::partition(
+      entries_, partitioned, size_, field, dimension, num_partitions, num_threads);
+    adopt(partitioned);
+    memory::add(subsystem_, -partitioned_bytes);
+    return offsets;
+  }
+
+  void UnorderedMatrix::adopt(MatrixEntry* entries) {
+    if (entries_ != nullptr) {
+      munmap(entries_, reservationBytes(reserved_));
+    }
+    entries_ = entries;
+    setCommitted(reservationBytes(size_) / sizeof(MatrixEntry));
+    reserved_ = committed_;
+  }
+
+  void UnorderedMatrix::setCommitted(std::size_t entries) {
+    memory::add(subsystem_, static_cast<std::int64_t>(entries * sizeof(MatrixEntry))
+                            - static_cast<std::int64_t>(committedBytes()));
+    committed_ = entries;
+  }
+
   std::ostream& operator<<(std::ostream& os, const UnorderedMatrix& matrix) {
-    int size_mb = (matrix.maxSize_ * sizeof(MatrixEntry)) / 1e6;
+    int size_mb = matrix.committedBytes() / 1e6;
     os << "(" << matrix.numRows() << ", " << matrix.numColumns() << ") "
        << matrix.size_ << " entries, approx " << size_mb << "mb";
     return os;
   }
 
-}
\ No newline at end of file
+}
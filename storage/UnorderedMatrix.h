@@ -1,10 +1,14 @@
 #ifndef OBAMADB_UNORDEREDMATRIX_H
 #define OBAMADB_UNORDEREDMATRIX_H
 
+#include "storage/MemoryAccounting.h"
 #include "storage/StorageConstants.h"
 #include "glog/logging.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <iostream>
+#include <vector>
 
 namespace obamadb {
 
@@ -19,50 +23,73 @@ namespace obamadb {
         column(col),
         value(val) { }
 
-    MatrixEntry(MatrixEntry const & other)
-      : row(other.row),
-        column(other.column),
-        value(other.value) { }
-
     int row;
     int column;
     num_t value;
   };
 
   /**
-   * A list of row/column/value triples. They are in no particular order.
-   * This version manages its own buffer.
+   * Orders which the entries of an UnorderedMatrix can be put in.
+   */
+  enum class EntryOrder {
+    kFile,     // As appended. Leaves the entries alone.
+    kRowMajor, // By row, then by column.
+    kHilbert   // By tile along a Hilbert curve, then row major within each tile.
+  };
+
+  /**
+   * The field of a MatrixEntry which entries are grouped by.
+   */
+  enum class EntryField {
+    kRow,
+    kColumn
+  };
+
+  /**
+   * A list of row/column/value triples. They are in no particular order unless reordered.
+   *
+   * The entries live in a single range of virtual memory which is reserved but not backed
+   * by memory. Segments of kSegmentEntries are committed as the matrix grows, so a small
+   * matrix only ever touches what it uses. The reservation starts at kInitialReservedEntries
+   * and doubles when it fills, moving the entries, so each entry is copied a constant number
+   * of times on average. After loading, shrinkToFit returns the unused tail of the reservation.
    */
   class UnorderedMatrix {
   public:
-    UnorderedMatrix()
-      : rows_(0),
-        columns_(0),
-        size_(0),
-        maxSize_(1<<28),
-        entries_(nullptr) {
-      entries_ = new MatrixEntry[maxSize_];
-    }
+    UnorderedMatrix();
 
-    ~UnorderedMatrix() {
-      delete[] entries_;
-    }
+    ~UnorderedMatrix();
 
     void append(int row, int col, num_t val) {
-      if (size_ == maxSize_) {
-        doubleSize();
+      if (size_ == committed_) {
+        grow();
       }
 
       entries_[size_] = MatrixEntry(row,col,val);
       size_++;
-      if (row > rows_) {
-        rows_ = row;
+      if (row >= rows_) {
+        rows_ = row + 1;
       }
-      if (col > columns_) {
-        columns_ = col;
+      if (col >= columns_) {
+        columns_ = col + 1;
       }
     }
 
+    /**
+     * Appends count entries for the caller to fill in, which may be done from several threads
+     * at once. The dimensions of the matrix are not updated, see growDimensions.
+     * @return The first of the new entries.
+     */
+    MatrixEntry* extend(std::size_t count);
+
+    /**
+     * Makes the matrix at least rows x columns. Used along with extend.
+     */
+    void growDimensions(int rows, int columns) {
+      rows_ = std::max(rows_, rows);
+      columns_ = std::max(columns_, columns);
+    }
+
     MatrixEntry const & get(int index) const {
       DCHECK_LT(index, size_);
       return entries_[index];
@@ -81,30 +108,101 @@ namespace obamadb {
       return size_;
     }
 
+    /**
+     * @return One more than the largest row index.
+     */
     int numRows() const {
       return rows_;
     }
 
+    /**
+     * @return One more than the largest column index.
+     */
     int numColumns() const {
       return columns_;
     }
 
+    /**
+     * Releases the memory and address space past the last entry. Appending after this is
+     * allowed but will copy the entries into a new reservation.
+     */
+    void shrinkToFit();
+
+    /**
+     * Sorts the entries with a parallel LSD radix sort, see sorting::radixSort. Matrix completion visits the
+     * entries in this order, so sorting them makes consecutive updates share factor rows.
+     * Like shrinkToFit, this leaves the matrix without spare capacity.
+     * @param order The new order of the entries.
+     * @param num_threads Threads to sort with.
+     */
+    void reorder(EntryOrder order, int num_threads);
+
+    /**
+     * Groups the entries into contiguous ranges of rows or columns, keeping their order
+     * within a group. Like shrinkToFit, this leaves the matrix without spare capacity.
+     * @param field Field to group on.
+     * @param num_partitions Number of groups of nearly equal ranges of rows or columns. See
+     *    sorting::partition.
+     * @param num_threads Threads to partition with.
+     * @return num_partitions + 1 offsets. Group p is entries [offsets[p], offsets[p+1]).
+     */
+    std::vector<std::size_t> partition(EntryField field, int num_partitions, int num_threads);
+
+    /**
+     * @return Bytes of memory which may be backing the entries.
+     */
+    std::size_t committedBytes() const {
+      return committed_ * sizeof(MatrixEntry);
+    }
+
+    // Number of entries committed at a time. Keeps each segment page aligned.
+    static std::size_t const kSegmentEntries;
+
+    // Number of entries a new matrix reserves address space for.
+    static std::size_t const kInitialReservedEntries;
+
+    // Log2 of the side of the square tiles which are laid along the Hilbert curve. A tile
+    // touches 512 rows of each factor matrix, which fits in L2 for ranks we typically use.
+    static int const kHilbertTileBits;
+
     friend std::ostream& operator<<(std::ostream& os, const UnorderedMatrix& matrix);
 
   private:
-    void doubleSize() {
-      MatrixEntry * newEntries = new MatrixEntry[maxSize_ * 2];
-      memcpy(newEntries, entries_, sizeof(MatrixEntry) * maxSize_);
-      delete [] entries_;
-      entries_ = newEntries;
-      maxSize_ *= 2;
-    }
+    /**
+     * Commits the next segment, moving to a larger reservation if this one is exhausted.
+     */
+    void grow();
+
+    /**
+     * Makes at least the given number of entries readable and writable.
+     */
+    void commit(std::size_t entries);
+
+    /**
+     * Moves the entries to a fresh reservation.
+     * @param reserve_entries Entries to reserve. Less may be reserved if address space is short.
+     * @param required_entries Entries which must fit in the new reservation.
+     */
+    void relocate(std::size_t reserve_entries, std::size_t required_entries);
+
+    /**
+     * Replaces the entries with a fully committed array of size_ entries.
+     */
+    void adopt(MatrixEntry* entries);
+
+    /**
+     * Updates the committed entries and the bytes counted against the subsystem.
+     */
+    void setCommitted(std::size_t entries);
 
     int rows_;
     int columns_;
     std::size_t size_;
-    std::size_t maxSize_;
+    std::size_t committed_; // entries which are backed by readable/writable memory.
+    std::size_t reserved_;  // entries which fit in the reserved address space.
     MatrixEntry* entries_;
+    // The subsystem which was current when the matrix was created, e.g. training data.
+    memory::Subsystem const subsystem_;
 
   };
 }
@@ -10,11 +10,7 @@ namespace obamadb {
   fvector fvector::GetRandomFVector(int const dim) {
     fvector shared_theta(dim);
     // initialize to values [-1,1]
-    float const half_max = ((float)INT_MAX)/2.0;
-    for (unsigned i = 0; i < dim; ++i) {
-      float const randf = (float)rand();
-      shared_theta[i] = static_cast<num_t>(randf/half_max - 1.0);
-    }
+    rng::fillUniform(shared_theta.values_, dim, -1, 1);
     return shared_theta;
   }
 
@@ -1,6 +1,8 @@
 #ifndef OBAMADB_UTILS_H
 #define OBAMADB_UTILS_H
 
+#include "storage/HugePages.h"
+#include "storage/Random.h"
 #include "storage/StorageConstants.h"
 
 #include <chrono>
@@ -38,12 +40,12 @@ namespace obamadb {
   struct fvector {
     fvector(unsigned dimension)
       : dimension_(dimension) {
-      values_ = new num_t[dimension_];
+      values_ = hugepages::allocateArray<num_t>(dimension_);
     }
 
     fvector(const fvector &other) {
       dimension_ = other.dimension_;
-      values_ = new num_t[dimension_];
+      values_ = hugepages::allocateArray<num_t>(dimension_);
       memcpy(values_, other.values_, sizeof(num_t) * dimension_);
     }
 
@@ -55,7 +57,7 @@ namespace obamadb {
     static fvector GetRandomFVector(int const dim);
 
     ~fvector() {
-      delete[] values_;
+      hugepages::release(values_);
     }
 
     num_t &operator[](int idx) const {
@@ -73,12 +75,18 @@ namespace obamadb {
 
   };
 
+  /**
+   * @return A value in [0, INT_MAX] from the calling thread's generator.
+   */
   inline int randomInt() {
-    return rand();
+    return static_cast<int>(rng::threadLocal().next() >> 33);
   }
 
+  /**
+   * @return A value in [0, 1) from the calling thread's generator.
+   */
   inline float randomFloat() {
-    return static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
+    return rng::threadLocal().nextFloat();
   }
 
   class Scanner {
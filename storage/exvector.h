@@ -3,6 +3,8 @@
 
 #include <cstring>
 
+#include "storage/MemoryAccounting.h"
+
 #include "glog/logging.h"
 
 namespace obamadb {
@@ -44,7 +46,7 @@ namespace obamadb {
      * @param size Maximum number of non-null elements this can contain.
      */
     dvector(int size) :
-      values_(new T[size + 1]),
+      values_(memory::allocateArray<T>(size + 1)),
       class_(values_ + size),
       num_elements_(0),
       alloc_size_(size),
@@ -126,8 +128,8 @@ namespace obamadb {
 
     void copy(dvector const & other) {
       if (other.num_elements_ > this->num_elements_) {
-        delete[] values_;
-        values_ = new T[other.num_elements_ + 1];
+        memory::release(values_);
+        values_ = memory::allocateArray<T>(other.num_elements_ + 1);
         this->alloc_size_ = other.num_elements_;
       }
       memcpy(values_, other.values_, other.num_elements_ * sizeof(T));
@@ -152,16 +154,16 @@ namespace obamadb {
 
   private:
     void doubleAllocation() {
-      T *tempValues = new T[(alloc_size_ * 2) + 1];
+      T *tempValues = memory::allocateArray<T>((alloc_size_ * 2) + 1);
       memcpy(tempValues, values_, (sizeof(T) * alloc_size_) + 1);
-      delete[] values_;
+      memory::release(values_);
       values_ = tempValues;
       alloc_size_ *= 2;
     }
 
     void release() {
       if (owns_memory_) {
-        delete[] values_;
+        memory::release(values_);
         owns_memory_ = false;
       }
     }
@@ -186,9 +188,9 @@ namespace obamadb {
      * @param size Maximum number of non-null elements this can contain.
      */
     svector(int size) :
-      index_(new int[size]),
-      values_(new T[size]),
-      class_(new T),
+      index_(memory::allocateArray<int>(size)),
+      values_(memory::allocateArray<T>(size)),
+      class_(memory::allocateArray<T>(1)),
       num_elements_(0),
       alloc_size_(size),
       owns_memory_(true) {}
@@ -234,9 +236,9 @@ namespace obamadb {
 
     void setMemory(int size, void *src) {
       if (owns_memory_) {
-        delete[] index_;
-        delete[] values_;
-        delete class_;
+        memory::release(index_);
+        memory::release(values_);
+        memory::release(class_);
         owns_memory_ = false;
       }
 
@@ -246,6 +248,18 @@ namespace obamadb {
       class_ = reinterpret_cast<T *>(values_ + size);
     }
 
+    /**
+     * Points at existing memory whose parts are not contiguous, like the rows of a dense block
+     * which share one index. Does not take ownership.
+     */
+    void setView(int size, int *index, T *values, T *classification) {
+      setMemory(0, nullptr);
+      num_elements_ = size;
+      index_ = index;
+      values_ = values;
+      class_ = classification;
+    }
+
     bool owns_memory() const {
       return owns_memory_;
     }
@@ -371,21 +385,21 @@ namespace obamadb {
 
     void release() {
       if (owns_memory_) {
-        delete[] index_;
-        delete[] values_;
-        delete class_;
+        memory::release(index_);
+        memory::release(values_);
+        memory::release(class_);
       }
     }
 
     void doubleAllocation() {
       DCHECK(owns_memory_);
 
-      int *tempIdx = new int[alloc_size_ * 2];
-      T *tempValues = new T[alloc_size_ * 2];
+      int *tempIdx = memory::allocateArray<int>(alloc_size_ * 2);
+      T *tempValues = memory::allocateArray<T>(alloc_size_ * 2);
       memcpy(tempIdx, index_, sizeof(int) * alloc_size_);
       memcpy(tempValues, values_, sizeof(T) * alloc_size_);
-      delete[] index_;
-      delete[] values_;
+      memory::release(index_);
+      memory::release(values_);
       index_ = tempIdx;
       values_ = tempValues;
       alloc_size_ *= 2;
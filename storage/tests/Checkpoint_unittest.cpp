@@ -0,0 +1,74 @@
+#include "gtest/gtest.h"
+
+#include "storage/Checkpoint.h"
+#include "storage/DenseDataBlock.h"
+#include "storage/Utils.h"
+
+#include <cstdio>
+#include <memory>
+
+namespace obamadb {
+
+  TEST(CheckpointTest, TestSaveLoad) {
+    fvector theta(100);
+    for (int i = 0; i < 100; i++) {
+      theta[i] = i * 0.5;
+    }
+    DenseDataBlock<num_t> factors(50, 7);
+    factors.randomize();
+
+    ModelSnapshot snapshot(3);
+    snapshot.add(theta);
+    snapshot.add(factors);
+    snapshot.add(std::vector<num_t>({0.25}));
+    checkpoint::save("checkpoint_test.bin", snapshot);
+
+    std::unique_ptr<ModelSnapshot> loaded(checkpoint::load("checkpoint_test.bin"));
+    ASSERT_EQ(3, loaded->epoch);
+    ASSERT_EQ(3, loaded->records.size());
+    EXPECT_EQ(1, loaded->records[0].rows);
+    EXPECT_EQ(100, loaded->records[0].columns);
+    EXPECT_EQ(50, loaded->records[1].rows);
+    EXPECT_EQ(7, loaded->records[1].columns);
+    EXPECT_EQ(0.25, loaded->records[2].values[0]);
+
+    fvector theta2(100);
+    theta2.clear();
+    checkpoint::restore(loaded->records[0], &theta2);
+    for (int i = 0; i < 100; i++) {
+      EXPECT_EQ(theta[i], theta2[i]);
+    }
+
+    DenseDataBlock<num_t> factors2(50, 7);
+    factors2.randomize();
+    checkpoint::restore(loaded->records[1], &factors2);
+    for (int i = 0; i < 50; i++) {
+      for (int j = 0; j < 7; j++) {
+        EXPECT_EQ(*factors.get(i, j), *factors2.get(i, j));
+      }
+    }
+    std::remove("checkpoint_test.bin");
+  }
+
+  TEST(CheckpointTest, TestBackgroundWriter) {
+    fvector theta(10);
+    {
+      CheckpointWriter writer("checkpoint_writer_test.bin", 2);
+      EXPECT_FALSE(writer.shouldCheckpoint(0));
+      EXPECT_TRUE(writer.shouldCheckpoint(1));
+      for (int epoch = 0; epoch < 4; epoch++) {
+        for (int i = 0; i < 10; i++) {
+          theta[i] = epoch;
+        }
+        ModelSnapshot *snapshot = new ModelSnapshot(epoch);
+        snapshot->add(theta);
+        writer.submit(snapshot);
+      }
+    }
+    // The last snapshot is always written.
+    std::unique_ptr<ModelSnapshot> loaded(checkpoint::load("checkpoint_writer_test.bin"));
+    EXPECT_EQ(3, loaded->epoch);
+    EXPECT_EQ(3, loaded->records[0].values[9]);
+    std::remove("checkpoint_writer_test.bin");
+  }
+}
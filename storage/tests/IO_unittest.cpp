@@ -3,11 +3,14 @@
 #include "storage/DataBlock.h"
 #include "storage/exvector.h"
 #include "storage/IO.h"
+#include "storage/Matrix.h"
 #include "storage/SparseDataBlock.h"
 
 #include "gflags/gflags.h"
 
+#include <fstream>
 #include <memory>
+#include <string>
 
 namespace obamadb {
 
@@ -15,6 +18,9 @@ namespace obamadb {
     std::vector<num_t> first_row = {0, 0.708333, 1, 1,-0.320755,-0.105023,-1,1,-0.419847,-1,-0.225806,0,1,-1};
     std::vector<num_t> last_row = {0,0.583333,1,1,0.245283,-0.269406,-1,1,-0.435115,1,-0.516129,0,1,-1};
 
+    // Keep the sparse layout, since rows of dense blocks have their unset columns filled in.
+    gflags::FlagSaver flag_saver;
+    FLAGS_dense_block_density = 2;
     std::vector<SparseDataBlock<num_t>*> blocks = IO::loadBlocks<num_t>("heart_scale.dat");
     ASSERT_EQ(1, blocks.size());
     ASSERT_EQ(270, blocks[0]->num_rows_);
@@ -46,6 +52,148 @@ namespace obamadb {
     }
   }
 
+  TEST(IOTest, TestSyntheticMcIndependentOfThreads) {
+    std::string const spec_file = "_synth_mc_test.spec";
+    {
+      std::ofstream spec(spec_file);
+      spec << "3000 2000 200000 10 7\n";
+    }
+    std::unique_ptr<UnorderedMatrix> serial(IO::loadUnorderedMatrix(spec_file, 1));
+    std::unique_ptr<UnorderedMatrix> parallel(IO::loadUnorderedMatrix(spec_file, 5));
+    ASSERT_EQ(200000, serial->numElements());
+    EXPECT_EQ(3000, serial->numRows());
+    EXPECT_EQ(2000, serial->numColumns());
+    ASSERT_EQ(serial->numElements(), parallel->numElements());
+    EXPECT_EQ(serial->numRows(), parallel->numRows());
+    EXPECT_EQ(serial->numColumns(), parallel->numColumns());
+    for (int i = 0; i < serial->numElements(); i++) {
+      ASSERT_EQ(serial->get(i).row, parallel->get(i).row);
+      ASSERT_EQ(serial->get(i).column, parallel->get(i).column);
+      ASSERT_EQ(serial->get(i).value, parallel->get(i).value);
+    }
+  }
+
+  TEST(IOTest, TestSyntheticSvmIndependentOfThreads) {
+    std::string const spec_file = "_synth_svm_test.spec";
+    {
+      std::ofstream spec(spec_file);
+      spec << "20000 1000 0.01 7\n";
+    }
+    std::unique_ptr<Matrix> serial(IO::load(spec_file, 1));
+    std::unique_ptr<Matrix> parallel(IO::load(spec_file, 3));
+    ASSERT_EQ(20000, serial->numRows_);
+    ASSERT_EQ(serial->numRows_, parallel->numRows_);
+    ASSERT_EQ(serial->blocks_.size(), parallel->blocks_.size());
+    svector<num_t> serial_row(0, nullptr);
+    svector<num_t> parallel_row(0, nullptr);
+    for (int b = 0; b < serial->blocks_.size(); b++) {
+      ASSERT_EQ(serial->blocks_[b]->num_rows_, parallel->blocks_[b]->num_rows_);
+      for (int r = 0; r < serial->blocks_[b]->num_rows_; r++) {
+        serial->blocks_[b]->getRowVectorFast(r, &serial_row);
+        parallel->blocks_[b]->getRowVectorFast(r, &parallel_row);
+        ASSERT_EQ(serial_row.num_elements_, parallel_row.num_elements_);
+        ASSERT_EQ(*serial_row.getClassification(), *parallel_row.getClassification());
+        for (int i = 0; i < serial_row.num_elements_; i++) {
+          ASSERT_EQ(serial_row.index_[i], parallel_row.index_[i]);
+          ASSERT_EQ(serial_row.values_[i], parallel_row.values_[i]);
+        }
+      }
+    }
+  }
+
+  namespace {
+    /**
+     * Makes the sparse blocks made from now on bytes in size.
+     */
+    void setBlockSize(std::int64_t bytes) {
+      FLAGS_block_size = bytes;
+      tuneBlockSize(0, 1);
+      FLAGS_block_size = 0;
+    }
+  }
+
+  TEST(IOTest, TestLibLinearReader) {
+    std::vector<SparseDataBlock<num_t>*> const whole = IO::loadBlocks<num_t>("heart_scale.dat");
+    ASSERT_EQ(1, whole.size());
+
+    // Small blocks, so the rows are split over several of them.
+    setBlockSize(4096);
+    IO::LibLinearReader reader("heart_scale.dat");
+    std::vector<std::unique_ptr<SparseDataBlock<num_t>>> blocks;
+    while (SparseDataBlock<num_t>* block = reader.next()) {
+      blocks.emplace_back(block);
+    }
+    setBlockSize(kStorageBlockSize);
+
+    ASSERT_LT(1, blocks.size());
+    EXPECT_EQ(270, reader.rowsRead());
+    EXPECT_EQ(nullptr, reader.next());
+    svector<num_t> expected(0, nullptr);
+    svector<num_t> actual(0, nullptr);
+    int row = 0;
+    for (std::unique_ptr<SparseDataBlock<num_t>> const & block : blocks) {
+      EXPECT_LT(0, block->num_rows_);
+      for (int r = 0; r < block->num_rows_; r++, row++) {
+        whole[0]->getRowVectorFast(row, &expected);
+        block->getRowVectorFast(r, &actual);
+        ASSERT_EQ(expected.numElements(), actual.numElements());
+        EXPECT_EQ(*expected.getClassification(), *actual.getClassification());
+        for (int i = 0; i < expected.numElements(); i++) {
+          EXPECT_EQ(expected.index_[i], actual.index_[i]);
+          EXPECT_EQ(expected.values_[i], actual.values_[i]);
+        }
+      }
+    }
+    EXPECT_EQ(270, row);
+    delete whole[0];
+  }
+
+  TEST(IOTest, TestLibLinearReaderRowTooLarge) {
+    std::string const file_name = "liblinear_wide_row.dat";
+    {
+      std::ofstream file(file_name);
+      file << "1";
+      for (int i = 1; i <= 1000; i++) {
+        file << " " << i << ":1";
+      }
+      file << "\n";
+    }
+    setBlockSize(4096);
+    EXPECT_DEATH({
+      IO::LibLinearReader reader(file_name);
+      delete reader.next();
+    }, "Raise -block_size");
+    setBlockSize(kStorageBlockSize);
+  }
+
+  TEST(IOTest, TestLabelTypes) {
+    std::string const file_name = "liblinear_labels.dat";
+    {
+      std::ofstream file(file_name);
+      file << "2 1:1\n1 2:1\n-0.75 1:2\n";
+    }
+    std::unique_ptr<SparseDataBlock<num_t>> targets(
+      IO::loadBlocks<num_t>(file_name, IO::LabelType::kTarget).front());
+    ASSERT_EQ(3, targets->num_rows_);
+    svector<num_t> row(0, nullptr);
+    num_t const expected_targets[] = {2, 1, -0.75};
+    for (int r = 0; r < 3; r++) {
+      targets->getRowVectorFast(r, &row);
+      EXPECT_EQ(expected_targets[r], *row.getClassification());
+    }
+
+    // Classes in the (1,2) encoding become (-1,1).
+    {
+      std::ofstream file(file_name);
+      file << "2 1:1\n1 2:1\n";
+    }
+    std::unique_ptr<SparseDataBlock<num_t>> classes(IO::loadBlocks<num_t>(file_name).front());
+    classes->getRowVectorFast(0, &row);
+    EXPECT_EQ(-1, *row.getClassification());
+    classes->getRowVectorFast(1, &row);
+    EXPECT_EQ(1, *row.getClassification());
+  }
+
   TEST(IOTest, TestScanDoubles) {
     Scanner scanner("doubles.dat");
     int rows = 0;
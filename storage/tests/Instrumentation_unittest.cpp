@@ -0,0 +1,63 @@
+#include "gtest/gtest.h"
+
+#include "storage/Instrumentation.h"
+#include "storage/StorageConstants.h"
+
+namespace obamadb {
+
+  namespace {
+    int const kLineColumns = kCacheLineBytes / sizeof(num_t);
+  }
+
+  TEST(InstrumentationTest, TestSampling) {
+    instrument::WriteTracker tracker(2, 3);
+    int sampled = 0;
+    for (int i = 0; i < 9; i++) {
+      sampled += tracker.beginUpdate(0);
+    }
+    tracker.beginUpdate(1);
+    EXPECT_EQ(3, sampled);
+    instrument::EpochConflicts const conflicts = tracker.endEpoch();
+    EXPECT_EQ(10, conflicts.updates);
+    // Nothing was checked, so nothing counts as sampled.
+    EXPECT_EQ(0, conflicts.sampled_updates);
+  }
+
+  TEST(InstrumentationTest, TestStaleReads) {
+    alignas(kCacheLineBytes) num_t model[4 * kLineColumns] = {0};
+    instrument::WriteTracker tracker(2, 1);
+    tracker.addRegion(model, sizeof(model));
+
+    // Worker 0 reads a value on each of the first two lines.
+    int const reads[] = {1, kLineColumns + 2};
+    ASSERT_TRUE(tracker.beginUpdate(0));
+    tracker.read(0, model, reads, 2);
+    // Worker 1 writes the first line twice and the third line once before worker 0 writes.
+    int const writes[] = {0, 3};
+    tracker.write(1, model, writes, 2);
+    tracker.write(1, model, writes, 1);
+    tracker.write(1, model + 2 * kLineColumns, 1);
+    tracker.checkReads(0);
+    tracker.write(0, model, reads, 2);
+
+    instrument::EpochConflicts const conflicts = tracker.endEpoch();
+    EXPECT_EQ(1, conflicts.updates);
+    EXPECT_EQ(1, conflicts.sampled_updates);
+    EXPECT_EQ(2, conflicts.sampled_lines);
+    EXPECT_EQ(1, conflicts.stale_lines);
+    EXPECT_EQ(2, conflicts.staleness);
+    EXPECT_EQ(2, conflicts.max_staleness);
+
+    // Counts restart with the epoch. Of a dense read, only the lines written after it are stale,
+    // here the third line, which was also written before.
+    ASSERT_TRUE(tracker.beginUpdate(1));
+    tracker.read(1, model + kLineColumns, 2 * kLineColumns);
+    tracker.write(0, model + 2 * kLineColumns, 1);
+    tracker.checkReads(1);
+    instrument::EpochConflicts const next = tracker.endEpoch();
+    EXPECT_EQ(1, next.updates);
+    EXPECT_EQ(2, next.sampled_lines);
+    EXPECT_EQ(1, next.stale_lines);
+    EXPECT_EQ(1, next.staleness);
+  }
+}
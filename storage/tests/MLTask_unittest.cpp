@@ -0,0 +1,218 @@
+#include "gtest/gtest.h"
+
+#include "storage/exvector.h"
+#include "storage/IO.h"
+#include "storage/LinearTask.h"
+#include "storage/MCTask.h"
+#include "storage/Matrix.h"
+#include "storage/MLTask.h"
+#include "storage/SVMTask.h"
+#include "storage/ThreadPool.h"
+#include "storage/Utils.h"
+
+#include "gflags/gflags.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace obamadb {
+
+  TEST(MLTaskTest, TestFastExp) {
+    for (float x = -80; x < 80; x += 0.01) {
+      double expected = std::exp(x);
+      EXPECT_NEAR(1.0, ml::fast_exp(x) / expected, 1e-4) << "x = " << x;
+    }
+    EXPECT_NEAR(0.0, ml::fast_sigmoid(-1000), 1e-30);
+    EXPECT_FLOAT_EQ(1.0, ml::fast_sigmoid(1000));
+    EXPECT_NEAR(0.5, ml::fast_sigmoid(0), 1e-5);
+  }
+
+  TEST(MLTaskTest, TestLogisticRegressionReducesLoss) {
+    std::vector<SparseDataBlock<num_t>*> blocks = IO::loadBlocks<num_t>("heart_scale.dat");
+    int const dim = maxColumns(blocks);
+
+    fvector theta(dim);
+    theta.clear();
+    std::unique_ptr<LinearParams> params(DefaultLRParams());
+    double const initial = LRTask::loss(theta, blocks);
+    LRTask task(new DataView(std::vector<SparseDataBlock<num_t> const *>(blocks.begin(), blocks.end())),
+                &theta, params.get());
+
+    for (int epoch = 0; epoch < 10; epoch++) {
+      task.execute(0, nullptr);
+    }
+    EXPECT_GT(initial, LRTask::loss(theta, blocks));
+    EXPECT_GT(0.3, LRTask::error(theta, blocks));
+
+    for (auto block : blocks) {
+      delete block;
+    }
+  }
+
+  TEST(MLTaskTest, TestLeastSquaresFitsTargets) {
+    // Targets which are not classes: y = 3 x1 - 2 x2 + 0.5 x3.
+    {
+      std::ofstream file("ls_targets.dat");
+      std::mt19937 gen(42);
+      std::uniform_real_distribution<float> dist(-1, 1);
+      for (int r = 0; r < 500; r++) {
+        float const x[] = {dist(gen), dist(gen), dist(gen)};
+        file << 3 * x[0] - 2 * x[1] + 0.5 * x[2] << " 1:" << x[0] << " 2:" << x[1] << " 3:" << x[2] << "\n";
+      }
+    }
+    std::vector<SparseDataBlock<num_t>*> blocks = IO::loadBlocks<num_t>("ls_targets.dat", IO::LabelType::kTarget);
+    int const dim = maxColumns(blocks);
+
+    fvector theta(dim);
+    theta.clear();
+    std::unique_ptr<LinearParams> params(DefaultLSParams());
+    double const initial = LSTask::error(theta, blocks);
+    EXPECT_LT(1.0, initial);
+    LSTask task(new DataView(std::vector<SparseDataBlock<num_t> const *>(blocks.begin(), blocks.end())),
+                &theta, params.get());
+
+    for (int epoch = 0; epoch < 10; epoch++) {
+      task.execute(0, nullptr);
+    }
+    EXPECT_GT(0.1, LSTask::error(theta, blocks));
+    EXPECT_NEAR(LSTask::error(theta, blocks), std::sqrt(2 * LSTask::loss(theta, blocks)), 1e-4);
+    EXPECT_NEAR(3, theta[1], 0.1);
+    EXPECT_NEAR(-2, theta[2], 0.1);
+    EXPECT_NEAR(0.5, theta[3], 0.1);
+
+    for (auto block : blocks) {
+      delete block;
+    }
+  }
+
+  namespace {
+    /**
+     * Trains a linear task for ten epochs over heart_scale stored with the given
+     * dense_block_density.
+     */
+    template<class TaskT>
+    fvector trainOnHeartScale(double dense_block_density, LinearParams *params, bool *dense) {
+      gflags::FlagSaver flag_saver;
+      FLAGS_dense_block_density = dense_block_density;
+      std::vector<SparseDataBlock<num_t>*> blocks = IO::loadBlocks<num_t>("heart_scale.dat");
+      *dense = blocks[0]->isDense();
+      fvector theta(maxColumns(blocks));
+      theta.clear();
+      TaskT task(new DataView(std::vector<SparseDataBlock<num_t> const *>(blocks.begin(), blocks.end())),
+                 &theta, params);
+      for (int epoch = 0; epoch < 10; epoch++) {
+        task.execute(0, nullptr);
+      }
+      for (auto block : blocks) {
+        delete block;
+      }
+      return theta;
+    }
+
+    template<class TaskT>
+    void expectDenseMatchesSparse(LinearParams *(*default_params)()) {
+      std::unique_ptr<LinearParams> sparse_params(default_params());
+      std::unique_ptr<LinearParams> dense_params(default_params());
+      bool sparse_is_dense = true;
+      bool dense_is_dense = false;
+      fvector const sparse = trainOnHeartScale<TaskT>(2, sparse_params.get(), &sparse_is_dense);
+      fvector const dense = trainOnHeartScale<TaskT>(0.5, dense_params.get(), &dense_is_dense);
+      EXPECT_FALSE(sparse_is_dense);
+      ASSERT_TRUE(dense_is_dense);
+      ASSERT_EQ(sparse.dimension_, dense.dimension_);
+      for (int c = 0; c < sparse.dimension_; c++) {
+        EXPECT_NEAR(sparse.values_[c], dense.values_[c], 1e-4) << "column " << c;
+      }
+    }
+  }
+
+  TEST(MLTaskTest, TestLinearTasksDenseBlocks) {
+    // Rows of dense blocks take the contiguous kernels, which must train the same model.
+    expectDenseMatchesSparse<LRTask>(&DefaultLRParams);
+    expectDenseMatchesSparse<LSTask>(&DefaultLSParams);
+  }
+
+  TEST(MLTaskTest, TestColumnPartitionedSVM) {
+    Matrix matrix(IO::loadBlocks<num_t>("heart_scale.dat"));
+    int const dim = matrix.numColumns_;
+
+    // With one thread and batches of one row the column partitioned SVM is the serial SVM.
+    fvector serial_theta(dim);
+    serial_theta.clear();
+    std::unique_ptr<SVMParams> serial_params(DefaultSVMParams(matrix, 1));
+    SVMTask serial_task(new DataView(std::vector<SparseDataBlock<num_t> const *>(matrix.blocks_.begin(),
+                                                                                 matrix.blocks_.end())),
+                        &serial_theta, serial_params.get());
+    fvector single_theta(dim);
+    single_theta.clear();
+    std::unique_ptr<SVMParams> single_params(DefaultSVMParams(matrix, 1));
+    ColumnPartitionedSVMTask single_task(&matrix, &single_theta, single_params.get(), 1, 1);
+    for (int epoch = 0; epoch < 3; epoch++) {
+      serial_task.execute(0, nullptr);
+      single_task.execute(0, nullptr);
+    }
+    for (int i = 0; i < dim; i++) {
+      EXPECT_EQ(serial_theta[i], single_theta[i]);
+    }
+
+    int const num_threads = 3;
+    fvector theta(dim);
+    theta.clear();
+    std::unique_ptr<SVMParams> params(DefaultSVMParams(matrix, num_threads));
+    double const initial_loss = SVMTask::loss(theta, matrix.blocks_);
+    ColumnPartitionedSVMTask task(&matrix, &theta, params.get(), num_threads, 16);
+    std::vector<int> const & bounds = task.columnBounds();
+    ASSERT_EQ(num_threads + 1, bounds.size());
+    EXPECT_EQ(0, bounds.front());
+    EXPECT_EQ(dim, bounds.back());
+    EXPECT_TRUE(std::is_sorted(bounds.begin(), bounds.end()));
+
+    for (int epoch = 0; epoch < 10; epoch++) {
+      threading::runThreads(num_threads, [&task](int thread_id) {
+        task.execute(thread_id, nullptr);
+      });
+    }
+    EXPECT_GT(initial_loss, SVMTask::loss(theta, matrix.blocks_));
+    EXPECT_GT(0.3, SVMTask::fractionMisclassified(theta, matrix.blocks_));
+  }
+
+  TEST(MLTaskTest, TestMCStatistics) {
+    UnorderedMatrix mat;
+    std::vector<int> degrees_l(301, 0);
+    std::vector<int> degrees_r(97, 0);
+    double sum = 0;
+    for (int i = 0; i < 10000; i++) {
+      int row = (i * 31) % 301;
+      int col = (i * 7) % 97;
+      mat.append(row, col, i % 5);
+      degrees_l[row]++;
+      degrees_r[col]++;
+      sum += i % 5;
+    }
+    int const threads[] = {1, 4};
+    for (int num_threads : threads) {
+      std::shared_ptr<MCStatistics const> statistics(new MCStatistics(&mat, num_threads));
+      EXPECT_EQ(degrees_l, statistics->degrees_l);
+      EXPECT_EQ(degrees_r, statistics->degrees_r);
+      EXPECT_NEAR(sum / mat.numElements(), statistics->mean, 1e-9);
+
+      // The initial model only depends on the seed.
+      rng::setSeed(5);
+      MCState state(&mat, statistics, 8, num_threads);
+      EXPECT_EQ(301, state.mat_l->getNumRows());
+      EXPECT_EQ(97, state.mat_r->getNumRows());
+      EXPECT_FLOAT_EQ(statistics->mean, state.mean);
+      rng::setSeed(5);
+      MCState other(&mat, statistics, 8, 3);
+      for (int row = 0; row < 301; row++) {
+        for (int col = 0; col < 8; col++) {
+          ASSERT_EQ(*state.mat_l->get(row, col), *other.mat_l->get(row, col));
+        }
+      }
+    }
+  }
+}
@@ -4,9 +4,12 @@
 #include "storage/exvector.h"
 #include "storage/IO.h"
 #include "storage/Matrix.h"
+#include "storage/RowPartitioning.h"
 #include "storage/SparseDataBlock.h"
 #include "storage/Utils.h"
 
+#include "gflags/gflags.h"
+
 #include <cstdlib>
 #include <memory>
 
@@ -70,7 +73,7 @@ namespace obamadb {
     int matrixSizeBytes = 16e6;
     double sparsity = 0.99;
     double const tolerance = 0.03;
-    std::unique_ptr<Matrix> mat(Matrix::GetRandomMatrix(matrixSizeBytes, ncolumns, sparsity));
+    std::unique_ptr<Matrix> mat(Matrix::GetRandomMatrix(matrixSizeBytes, ncolumns, sparsity, 42));
     double actual_sparsity = mat->getSparsity();
     ASSERT_TRUE(actual_sparsity > sparsity - tolerance && actual_sparsity < sparsity + tolerance);
     EXPECT_LE(matrixSizeBytes * tolerance, mat->sizeBytes());
@@ -91,4 +94,172 @@ namespace obamadb {
     }
     EXPECT_GE(((int)mat->numRows_/2) * tolerance, (int)(mat->numRows_/2) - numPositive);
   }
-}
\ No newline at end of file
+
+  TEST(TestMatrix, TestColumnStatistics) {
+    std::unique_ptr<Matrix> mat(getRandomSparseMatrix(20000, 200, 0.9));
+    ASSERT_LT(1, mat->blocks_.size());
+
+    std::vector<int> expected(mat->numColumns_, 0);
+    svector<num_t> row(0, nullptr);
+    for (auto block : mat->blocks_) {
+      for (int i = 0; i < block->getNumRows(); i++) {
+        block->getRowVectorFast(i, &row);
+        for (int j = 0; j < row.numElements(); j++) {
+          expected[row.index_[j]]++;
+        }
+      }
+    }
+    EXPECT_EQ(expected, mat->columnStatistics(3).degrees);
+    // Cached, so the thread count no longer matters.
+    EXPECT_EQ(&mat->columnStatistics(1), &mat->columnStatistics(3));
+
+    // Adding a row discards the statistics.
+    svector<num_t> new_row;
+    new_row.push_back(0, 1);
+    mat->addRow(new_row);
+    expected[0]++;
+    EXPECT_EQ(expected, mat->columnStatistics(2).degrees);
+  }
+
+  TEST(TestMatrix, TestBlockStatistics) {
+    std::unique_ptr<Matrix> mat(getRandomSparseMatrix(20000, 200, 0.9));
+    // Blocks built row by row are summarized as they fill, and must match a summary of the
+    // finished block.
+    ASSERT_EQ(mat->blocks_.size(), mat->blockStatistics().size());
+    ASSERT_LT(1, mat->blocks_.size());
+    std::uint64_t nnz = 0;
+    for (int b = 0; b < mat->blocks_.size(); b++) {
+      BlockStatistics const & incremental = mat->blockStatistics()[b];
+      BlockStatistics const computed = BlockStatistics::Of(*mat->blocks_[b]);
+      EXPECT_EQ(computed.num_rows, incremental.num_rows);
+      EXPECT_EQ(computed.nnz, incremental.nnz);
+      EXPECT_EQ(computed.min_column, incremental.min_column);
+      EXPECT_EQ(computed.max_column, incremental.max_column);
+      EXPECT_EQ(computed.min_value, incremental.min_value);
+      EXPECT_EQ(computed.max_value, incremental.max_value);
+      EXPECT_EQ(computed.column_sketch, incremental.column_sketch);
+      EXPECT_EQ(mat->blocks_[b]->numNonZeroElements(), incremental.nnz);
+      EXPECT_EQ(mat->blocks_[b]->getNumRows(), incremental.positive_labels + incremental.negative_labels);
+      nnz += incremental.nnz;
+    }
+    EXPECT_EQ(nnz, mat->getNNZ());
+    EXPECT_EQ(mat->numColumns_, mat->maxColumns());
+
+    // A block of even columns only.
+    Matrix evens;
+    svector<num_t> row;
+    row.setClassification(1);
+    for (int c = 10; c < 3000; c += 2) {
+      row.push_back(c, -c);
+    }
+    evens.addRow(row);
+    BlockStatistics const & statistics = evens.blockStatistics()[0];
+    EXPECT_EQ(10, statistics.min_column);
+    EXPECT_EQ(2998, statistics.max_column);
+    EXPECT_EQ(-2998, statistics.min_value);
+    EXPECT_EQ(-10, statistics.max_value);
+    EXPECT_EQ(1, statistics.positive_labels);
+    EXPECT_FALSE(statistics.mayContainColumn(9));
+    EXPECT_FALSE(statistics.mayContainColumn(11));
+    EXPECT_FALSE(statistics.mayContainColumn(3000));
+    EXPECT_TRUE(statistics.mayContainColumn(2000));
+  }
+
+  TEST(TestMatrix, TestExplicitZerosAreElements) {
+    // Zeros written out in the rows of sparse blocks are elements like any other value.
+    Matrix mat;
+    svector<num_t> row;
+    row.setClassification(1);
+    row.push_back(0, 2);
+    row.push_back(5, 0);
+    mat.addRow(row);
+    row.clear();
+    row.setClassification(-1);
+    row.push_back(2, 0);
+    mat.addRow(row);
+
+    EXPECT_EQ(6, mat.numColumns_);
+    EXPECT_EQ(mat.numColumns_, mat.maxColumns());
+    EXPECT_EQ(3, mat.getNNZ());
+    EXPECT_EQ(std::vector<int>({1, 0, 1, 0, 0, 1}), mat.columnStatistics(1).degrees);
+    EXPECT_TRUE(mat.blockStatistics()[0].mayContainColumn(5));
+    mat.blocks_[0]->finalize();
+    BlockStatistics const computed = BlockStatistics::Of(*mat.blocks_[0]);
+    EXPECT_EQ(3, computed.nnz);
+    EXPECT_EQ(5, computed.max_column);
+  }
+
+  TEST(TestMatrix, TestMinHashPartitioning) {
+    // Two kinds of rows, interleaved, which write disjoint cache lines of the model.
+    Matrix mat;
+    svector<num_t> row;
+    for (int i = 0; i < 40000; i++) {
+      row.clear();
+      row.setClassification(i % 3 == 0 ? 1 : -1);
+      int const first_column = i % 2 == 0 ? 0 : 1024;
+      for (int c = first_column; c < first_column + 64; c += 4) {
+        row.push_back(c, i);
+      }
+      mat.addRow(row);
+    }
+    ASSERT_LT(2, mat.blocks_.size());
+
+    partitioning::Placement round_robin = partitioning::roundRobin(mat.blocks_, 2);
+    partitioning::ConflictStats const before = partitioning::measureConflicts(round_robin, mat.numColumns_);
+    EXPECT_EQ(1.0, before.shared_write_fraction);
+    EXPECT_EQ(2.0, before.workers_per_line);
+
+    partitioning::Placement placement;
+    std::unique_ptr<Matrix> packed(partitioning::minHash(mat, 2, 3, &placement));
+    EXPECT_EQ(mat.numRows_, packed->numRows_);
+    EXPECT_EQ(mat.numColumns_, packed->numColumns_);
+    EXPECT_EQ(mat.getNNZ(), packed->getNNZ());
+    ASSERT_EQ(2, placement.size());
+    int placed_blocks = 0;
+    for (auto const & blocks : placement) {
+      EXPECT_FALSE(blocks.empty());
+      placed_blocks += blocks.size();
+    }
+    EXPECT_EQ(packed->blocks_.size(), placed_blocks);
+
+    partitioning::ConflictStats const after = partitioning::measureConflicts(placement, packed->numColumns_);
+    EXPECT_EQ(0.0, after.shared_write_fraction);
+    EXPECT_EQ(1.0, after.workers_per_line);
+  }
+
+  TEST(TestMatrix, TestMinHashPartitioningDenseBlocks) {
+    gflags::FlagSaver flag_saver;
+    FLAGS_dense_block_density = 0.5;
+    // Like TestMinHashPartitioning, but every row is half set, so the blocks are stored densely
+    // and their rows cover every column with zeros filled in.
+    Matrix mat;
+    svector<num_t> row;
+    for (int i = 0; i < 40000; i++) {
+      row.clear();
+      row.setClassification(i % 3 == 0 ? 1 : -1);
+      int const first_column = i % 2 == 0 ? 0 : 64;
+      for (int c = first_column; c < first_column + 64; c++) {
+        row.push_back(c, i + 1);
+      }
+      mat.addRow(row);
+    }
+    ASSERT_LT(2, mat.blocks_.size());
+    for (SparseDataBlock<num_t>* block : mat.blocks_) {
+      block->finalize();
+      ASSERT_TRUE(block->isDense());
+    }
+
+    partitioning::Placement round_robin = partitioning::roundRobin(mat.blocks_, 2);
+    partitioning::ConflictStats const before = partitioning::measureConflicts(round_robin, mat.numColumns_);
+    EXPECT_EQ(1.0, before.shared_write_fraction);
+    EXPECT_EQ(2.0, before.workers_per_line);
+
+    partitioning::Placement placement;
+    std::unique_ptr<Matrix> packed(partitioning::minHash(mat, 2, 3, &placement));
+    EXPECT_EQ(mat.numRows_, packed->numRows_);
+    EXPECT_EQ(mat.getNNZ(), packed->getNNZ());
+    partitioning::ConflictStats const after = partitioning::measureConflicts(placement, packed->numColumns_);
+    EXPECT_EQ(0.0, after.shared_write_fraction);
+    EXPECT_EQ(1.0, after.workers_per_line);
+  }
+}
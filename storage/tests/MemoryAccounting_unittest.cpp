@@ -0,0 +1,87 @@
+#include "gtest/gtest.h"
+
+#include "storage/MemoryAccounting.h"
+#include "storage/ThreadPool.h"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace obamadb {
+
+  TEST(MemoryAccountingTest, TestAllocateRelease) {
+    memory::Usage const before = memory::usage();
+    void* model = nullptr;
+    {
+      memory::SubsystemScope scope(memory::kModel);
+      EXPECT_EQ(memory::kModel, memory::current());
+      model = memory::allocate(1000);
+      {
+        memory::SubsystemScope nested(memory::kTestData);
+        EXPECT_EQ(memory::kTestData, memory::current());
+      }
+      EXPECT_EQ(memory::kModel, memory::current());
+    }
+    EXPECT_EQ(memory::kScratch, memory::current());
+    void* scratch = memory::allocate(24);
+
+    memory::Usage const during = memory::usage();
+    EXPECT_EQ(1000, during.current[memory::kModel] - before.current[memory::kModel]);
+    EXPECT_EQ(24, during.current[memory::kScratch] - before.current[memory::kScratch]);
+    EXPECT_EQ(0, during.current[memory::kTestData] - before.current[memory::kTestData]);
+    EXPECT_EQ(1024, during.total_current - before.total_current);
+
+    // Memory is given back to the subsystem it was allocated for, whatever the current one is.
+    {
+      memory::SubsystemScope scope(memory::kTrainingData);
+      memory::release(model);
+    }
+    memory::release(scratch);
+    memory::release(nullptr);
+    memory::Usage const after = memory::usage();
+    for (int s = 0; s < memory::kNumSubsystems; s++) {
+      EXPECT_EQ(before.current[s], after.current[s]);
+    }
+    EXPECT_EQ(before.total_current, after.total_current);
+  }
+
+  TEST(MemoryAccountingTest, TestPeaks) {
+    memory::beginPhase("test");
+    memory::Usage const start = memory::usage();
+    EXPECT_EQ(start.current[memory::kTrainingData], start.peak[memory::kTrainingData]);
+    EXPECT_EQ(start.total_current, start.total_peak);
+
+    memory::SubsystemScope scope(memory::kTrainingData);
+    void* first = memory::allocate(4000);
+    void* second = memory::allocate(6000);
+    memory::release(first);
+    memory::Usage const usage = memory::usage();
+    EXPECT_EQ(6000, usage.current[memory::kTrainingData] - start.current[memory::kTrainingData]);
+    EXPECT_EQ(10000, usage.peak[memory::kTrainingData] - start.current[memory::kTrainingData]);
+    EXPECT_EQ(10000, usage.total_peak - start.total_current);
+
+    // A new phase starts its peaks from the current usage.
+    memory::release(second);
+    memory::beginPhase("next");
+    memory::Usage const next = memory::usage();
+    EXPECT_EQ(next.current[memory::kTrainingData], next.peak[memory::kTrainingData]);
+    EXPECT_EQ(next.total_current, next.total_peak);
+  }
+
+  TEST(MemoryAccountingTest, TestScopesArePerThread) {
+    memory::SubsystemScope scope(memory::kTrainingData);
+    memory::Subsystem other_thread = memory::kTrainingData;
+    std::thread thread([&other_thread] { other_thread = memory::current(); });
+    thread.join();
+    EXPECT_EQ(memory::kScratch, other_thread);
+
+    // runThreads workers allocate for the caller's subsystem.
+    std::vector<int> worker_subsystems(3, memory::kScratch);
+    threading::runThreads(3, [&worker_subsystems](int thread_id) {
+      worker_subsystems[thread_id] = memory::current();
+    });
+    for (int subsystem : worker_subsystems) {
+      EXPECT_EQ(memory::kTrainingData, subsystem);
+    }
+  }
+}
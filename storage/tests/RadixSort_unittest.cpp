@@ -0,0 +1,68 @@
+#include "gtest/gtest.h"
+
+#include "storage/RadixSort.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+namespace obamadb {
+
+  TEST(RadixSortTest, TestMatchesStableSort) {
+    std::size_t const n = 50000;
+    int const threads[] = {1, 2, 5};
+    for (int num_threads : threads) {
+      std::vector<std::uint64_t> keys(n);
+      std::vector<MatrixEntry> entries(n);
+      srand(11);
+      for (int i = 0; i < n; i++) {
+        // Few distinct keys so stability is exercised, and constant high bits so passes are skipped.
+        keys[i] = (static_cast<std::uint64_t>(rand() % 1000) << 20) | (1 << 12);
+        entries[i] = MatrixEntry(i, static_cast<int>(keys[i] >> 20), 0);
+      }
+      std::vector<MatrixEntry> expected(entries);
+      std::stable_sort(expected.begin(), expected.end(), [](MatrixEntry const & a, MatrixEntry const & b) {
+        return a.column < b.column;
+      });
+
+      std::vector<std::uint64_t> keys_scratch(n);
+      std::vector<MatrixEntry> entries_scratch(n);
+      bool in_scratch = sorting::radixSort(keys.data(), entries.data(), keys_scratch.data(),
+                                           entries_scratch.data(), n, 40, num_threads);
+      std::vector<std::uint64_t> const & sorted_keys = in_scratch ? keys_scratch : keys;
+      std::vector<MatrixEntry> const & sorted = in_scratch ? entries_scratch : entries;
+      for (int i = 0; i < n; i++) {
+        ASSERT_EQ(expected[i].row, sorted[i].row);
+        ASSERT_EQ(static_cast<std::uint64_t>(sorted[i].column) << 20 | (1 << 12), sorted_keys[i]);
+      }
+    }
+  }
+
+  TEST(RadixSortTest, TestPartition) {
+    std::size_t const n = 20000;
+    int const columns = 777;
+    int const partitions = 10;
+    std::vector<MatrixEntry> entries(n);
+    srand(3);
+    for (int i = 0; i < n; i++) {
+      entries[i] = MatrixEntry(i, rand() % columns, 0);
+    }
+    std::vector<MatrixEntry> out(n);
+    std::vector<std::size_t> offsets = sorting::partition(
+      entries.data(), out.data(), n, EntryField::kColumn, columns, partitions, 3);
+
+    ASSERT_EQ(partitions + 1, offsets.size());
+    EXPECT_EQ(0, offsets[0]);
+    EXPECT_EQ(n, offsets[partitions]);
+    for (int p = 0; p < partitions; p++) {
+      for (std::size_t i = offsets[p]; i < offsets[p + 1]; i++) {
+        ASSERT_EQ(p, out[i].column * partitions / columns);
+        if (i > offsets[p]) {
+          // Input order is kept within a partition.
+          ASSERT_LT(out[i - 1].row, out[i].row);
+        }
+      }
+    }
+  }
+}
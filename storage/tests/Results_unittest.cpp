@@ -0,0 +1,53 @@
+#include "gtest/gtest.h"
+
+#include "storage/Results.h"
+
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <string>
+
+namespace obamadb {
+
+  TEST(ResultsTest, TestRecordJson) {
+    ResultRecord record("epoch");
+    record.add("trial", 2)
+      .add("bytes", static_cast<std::int64_t>(1) << 40)
+      .add("error", 0.25)
+      .add("converged", false)
+      .add("algorithm", "svm");
+    EXPECT_EQ("{\"type\":\"epoch\",\"trial\":2,\"bytes\":1099511627776,\"error\":0.25,"
+              "\"converged\":false,\"algorithm\":\"svm\"}", record.json());
+  }
+
+  TEST(ResultsTest, TestNonFiniteIsNull) {
+    ResultRecord record("trial");
+    record.add("loss", std::numeric_limits<double>::quiet_NaN())
+      .add("rate", std::numeric_limits<double>::infinity());
+    EXPECT_EQ("{\"type\":\"trial\",\"loss\":null,\"rate\":null}", record.json());
+  }
+
+  TEST(ResultsTest, TestEscaping) {
+    ResultRecord record("config");
+    record.add("file", "C:\\data\\\"quoted\".tsv")
+      .add("tab\tkey", std::string("line\nbreak\x01\x1f end"));
+    EXPECT_EQ("{\"type\":\"config\",\"file\":\"C:\\\\data\\\\\\\"quoted\\\".tsv\","
+              "\"tab\\u0009key\":\"line\\u000abreak\\u0001\\u001f end\"}", record.json());
+  }
+
+  TEST(ResultsTest, TestWriter) {
+    std::string const file_name = "results_test.jsonl";
+    {
+      ResultsWriter writer(file_name);
+      writer.submit(ResultRecord("config").add("threads", 4));
+      writer.submit(ResultRecord("trial").add("quote", "\""));
+    }
+    std::ifstream file(file_name);
+    std::string line;
+    ASSERT_TRUE(std::getline(file, line));
+    EXPECT_EQ("{\"type\":\"config\",\"threads\":4}", line);
+    ASSERT_TRUE(std::getline(file, line));
+    EXPECT_EQ("{\"type\":\"trial\",\"quote\":\"\\\"\"}", line);
+    EXPECT_FALSE(std::getline(file, line));
+  }
+}
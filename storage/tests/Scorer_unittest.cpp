@@ -0,0 +1,116 @@
+#include "gtest/gtest.h"
+
+#include "storage/DenseDataBlock.h"
+#include "storage/exvector.h"
+#include "storage/IO.h"
+#include "storage/MLTask.h"
+#include "storage/Scorer.h"
+#include "storage/SparseDataBlock.h"
+#include "storage/StorageConstants.h"
+
+#include "gflags/gflags.h"
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace obamadb {
+
+  namespace {
+    std::vector<std::string> readLines(std::string const & file_name) {
+      std::ifstream file(file_name);
+      std::vector<std::string> lines;
+      std::string line;
+      while (std::getline(file, line)) {
+        lines.push_back(line);
+      }
+      return lines;
+    }
+  }
+
+  TEST(ScorerTest, TestLinearScorer) {
+    fvector theta(14);
+    for (int c = 0; c < 14; c++) {
+      theta[c] = c * 0.1 - 0.5;
+    }
+    std::vector<SparseDataBlock<num_t>*> const blocks = IO::loadBlocks<num_t>("heart_scale.dat");
+    ASSERT_EQ(1, blocks.size());
+
+    // Small blocks, so the file is scored in several batches.
+    FLAGS_block_size = 4096;
+    tuneBlockSize(0, 1);
+    LinearScorer scorer(&theta, MLAlgorithm::kSVM, 2);
+    ScoreStats const stats = scorer.score("heart_scale.dat", "linear_scores.txt");
+    FLAGS_block_size = kStorageBlockSize;
+    tuneBlockSize(0, 1);
+    FLAGS_block_size = 0;
+
+    EXPECT_EQ(270, stats.rows);
+    std::vector<std::string> const lines = readLines("linear_scores.txt");
+    ASSERT_EQ(270, lines.size());
+    svector<num_t> row(0, nullptr);
+    char expected[64];
+    for (int r = 0; r < 270; r++) {
+      blocks[0]->getRowVectorFast(r, &row);
+      num_t const score = ml::dot(row, theta.values_);
+      snprintf(expected, sizeof(expected), "%d,%.6f", score >= 0 ? 1 : -1, score);
+      EXPECT_EQ(expected, lines[r]);
+    }
+    delete blocks[0];
+  }
+
+  TEST(ScorerTest, TestLSScorer) {
+    fvector theta(3);
+    theta[0] = 0;
+    theta[1] = 1.5;
+    theta[2] = -2;
+    {
+      std::ofstream file("ls_score.dat");
+      file << "3.25 1:1 2:0.5\n-7 2:2\n0.5 1:-1\n";
+    }
+    LinearScorer scorer(&theta, MLAlgorithm::kLS, 2);
+    ScoreStats const stats = scorer.score("ls_score.dat", "ls_scores.txt");
+
+    // The predicted targets, without a class label.
+    EXPECT_EQ(3, stats.rows);
+    std::vector<std::string> const lines = readLines("ls_scores.txt");
+    ASSERT_EQ(3, lines.size());
+    EXPECT_EQ("0.500000", lines[0]);
+    EXPECT_EQ("-4.000000", lines[1]);
+    EXPECT_EQ("-1.500000", lines[2]);
+  }
+
+  TEST(ScorerTest, TestMCScorer) {
+    DenseDataBlock<num_t> mat_l(5, 3);
+    DenseDataBlock<num_t> mat_r(4, 3);
+    mat_l.randomize();
+    mat_r.randomize();
+    {
+      std::ofstream pairs("mc_pairs.tsv");
+      pairs << "0\t0\t5\n4\t3\n2\t1\t1\n7\t0\n1\t9\n";
+    }
+    MCScorer scorer(&mat_l, &mat_r, 3.5, 2);
+    ScoreStats const stats = scorer.score("mc_pairs.tsv", "mc_scores.txt");
+
+    EXPECT_EQ(5, stats.rows);
+    std::vector<std::string> const lines = readLines("mc_scores.txt");
+    ASSERT_EQ(5, lines.size());
+    int const pairs[][2] = {{0, 0}, {4, 3}, {2, 1}, {7, 0}, {1, 9}};
+    dvector<num_t> lrow(0, nullptr);
+    dvector<num_t> rrow(0, nullptr);
+    char expected[64];
+    for (int i = 0; i < 5; i++) {
+      double prediction = 3.5;
+      // Pairs outside of the model get the mean.
+      if (pairs[i][0] < 5 && pairs[i][1] < 4) {
+        mat_l.getRowVectorFast(pairs[i][0], &lrow);
+        mat_r.getRowVectorFast(pairs[i][1], &rrow);
+        prediction += ml::dot(lrow, rrow.values_);
+      }
+      snprintf(expected, sizeof(expected), "%d\t%d\t%.6f", pairs[i][0], pairs[i][1], prediction);
+      EXPECT_EQ(expected, lines[i]);
+    }
+  }
+}
@@ -1,13 +1,20 @@
 #include "gtest/gtest.h"
 
+#include "storage/BlockArena.h"
 #include "storage/DataBlock.h"
+#include "storage/DataView.h"
 #include "storage/exvector.h"
+#include "storage/HugePages.h"
 #include "storage/IO.h"
+#include "storage/MemoryAccounting.h"
 #include "storage/SparseDataBlock.h"
 #include "storage/Utils.h"
 
+#include "gflags/gflags.h"
+
 #include <cstdlib>
 #include <memory>
+#include <vector>
 
 namespace obamadb {
 
@@ -23,11 +30,156 @@ namespace obamadb {
     EXPECT_EQ(10, r1.index_[0]);
   }
 
+  TEST(SparseDataBlockTest, TestBlocksShareArenaRegions) {
+    arena::Stats const before = arena::stats();
+    std::vector<std::unique_ptr<SparseDataBlock<num_t>>> blocks;
+    for (int i = 0; i < 8; i++) {
+      blocks.emplace_back(new SparseDataBlock<num_t>());
+      // Blocks are writable end to end.
+      memset(blocks.back()->store_, i, blocks.back()->block_size_bytes_);
+    }
+    arena::Stats const during = arena::stats();
+    EXPECT_LE(8 * kStorageBlockSize, during.used_bytes - before.used_bytes);
+    EXPECT_GT(8, during.regions - before.regions);
+    for (int i = 0; i < 8; i++) {
+      EXPECT_EQ(static_cast<char>(i), reinterpret_cast<char*>(blocks[i]->store_)[kStorageBlockSize - 1]);
+    }
+    blocks.clear();
+    arena::Stats const after = arena::stats();
+    EXPECT_EQ(before.regions, after.regions);
+    EXPECT_EQ(before.mapped_bytes, after.mapped_bytes);
+  }
+
+  TEST(SparseDataBlockTest, TestArenaRegionsGrowFromOneBlock) {
+    // A size no other test uses, so the size class starts out without regions.
+    std::uint32_t const block_bytes = 3 << 20;
+    arena::Stats const before = arena::stats();
+    std::vector<std::unique_ptr<SparseDataBlock<num_t>>> blocks;
+    blocks.emplace_back(new SparseDataBlock<num_t>(block_bytes));
+    EXPECT_EQ(1, arena::stats().regions - before.regions);
+    EXPECT_EQ(hugepages::roundUp(block_bytes), arena::stats().mapped_bytes - before.mapped_bytes);
+    // Regions of 1, 2 and 4 blocks hold 7, the 8th needs a region of 8.
+    for (int i = 1; i < 8; i++) {
+      blocks.emplace_back(new SparseDataBlock<num_t>(block_bytes));
+    }
+    EXPECT_EQ(4, arena::stats().regions - before.regions);
+    blocks.clear();
+    EXPECT_EQ(before.mapped_bytes, arena::stats().mapped_bytes);
+  }
+
+  TEST(SparseDataBlockTest, TestFinalizeCompacts) {
+    std::unique_ptr<SparseDataBlock<num_t>> block(new SparseDataBlock<num_t>());
+    num_t positive = 1;
+    for (int r = 0; r < 10; r++) {
+      svector<num_t> row(4);
+      row.setClassification(&positive);
+      for (int i = 0; i <= r % 4; i++) {
+        row.push_back(i * 10 + r, r + i);
+      }
+      ASSERT_TRUE(block->appendRow(row));
+    }
+    block->finalize();
+    EXPECT_GT(storageBlockSize() / 2, block->block_size_bytes_);
+    svector<num_t> row(0, nullptr);
+    for (int r = 0; r < 10; r++) {
+      block->getRowVectorFast(r, &row);
+      ASSERT_EQ(r % 4 + 1, row.numElements());
+      EXPECT_EQ((r % 4) * 10 + r, row.index_[row.numElements() - 1]);
+      EXPECT_EQ(r + row.numElements() - 1, row.values_[row.numElements() - 1]);
+      EXPECT_EQ(1, *row.getClassification());
+    }
+
+    // Already down to the smallest size class, a page.
+    std::uint32_t const compacted_bytes = block->block_size_bytes_;
+    EXPECT_EQ(arena::compactBytes(storageBlockSize(), 1), compacted_bytes);
+    block->trimRows(5);
+    EXPECT_EQ(5, block->num_rows_);
+    EXPECT_EQ(compacted_bytes, block->block_size_bytes_);
+    block->getRowVectorFast(4, &row);
+    EXPECT_EQ(1, row.numElements());
+    EXPECT_EQ(4, row.index_[0]);
+  }
+
+  TEST(SparseDataBlockTest, TestFinalizeCompactsAccountedBytes) {
+    num_t positive = 1;
+    svector<num_t> row(100);
+    row.setClassification(&positive);
+    for (int c = 0; c < 100; c++) {
+      row.push_back(c * 3, c);
+    }
+
+    memory::SubsystemScope scope(memory::kTrainingData);
+    std::int64_t const before = memory::usage().current[memory::kTrainingData];
+    std::unique_ptr<SparseDataBlock<num_t>> block(new SparseDataBlock<num_t>(4 << 20));
+    EXPECT_EQ(4 << 20, memory::usage().current[memory::kTrainingData] - before);
+    // About 1.2MB of rows, so the block moves to the 2MB size class of the arena.
+    for (int r = 0; r < 1500; r++) {
+      ASSERT_TRUE(block->appendRow(row));
+    }
+    arena::Stats const loaded = arena::stats();
+    block->finalize();
+    EXPECT_EQ(2 << 20, block->block_size_bytes_);
+    EXPECT_EQ(block->block_size_bytes_, memory::usage().current[memory::kTrainingData] - before);
+    EXPECT_EQ(loaded.used_bytes - (2 << 20), arena::stats().used_bytes);
+    block.reset();
+    EXPECT_EQ(before, memory::usage().current[memory::kTrainingData]);
+  }
+
+  TEST(SparseDataBlockTest, TestFinalizeDensifies) {
+    gflags::FlagSaver flag_saver;
+    FLAGS_dense_block_density = 0.5;
+    std::unique_ptr<SparseDataBlock<num_t>> block(new SparseDataBlock<num_t>());
+    for (int r = 0; r < 10; r++) {
+      svector<num_t> row(4);
+      row.setClassification(r % 2 == 0 ? 1 : -1);
+      // Every row but the first skips column r % 4.
+      for (int c = 0; c < 4; c++) {
+        if (r == 0 || c != r % 4) {
+          row.push_back(c, r * 10 + c + 1);
+        }
+      }
+      ASSERT_TRUE(block->appendRow(row));
+    }
+    int const nnz = block->numNonZeroElements();
+    block->finalize();
+    ASSERT_TRUE(block->isDense());
+    EXPECT_EQ(4, block->denseColumns());
+    EXPECT_EQ(nnz, block->numNonZeroElements());
+    EXPECT_EQ(nullptr, block->get(1, 1));
+    EXPECT_EQ(13, *block->get(1, 2));
+
+    svector<num_t> row(0, nullptr);
+    for (int r = 0; r < 10; r++) {
+      block->getRowVectorFast(r, &row);
+      ASSERT_EQ(4, row.numElements());
+      for (int c = 0; c < 4; c++) {
+        EXPECT_EQ(c, row.index_[c]);
+        EXPECT_EQ(r != 0 && c == r % 4 ? 0 : r * 10 + c + 1, row.values_[c]);
+      }
+      EXPECT_EQ(r % 2 == 0 ? 1 : -1, *row.getClassification());
+    }
+    svector<num_t> owned;
+    block->getRowVector(3, &owned);
+    EXPECT_FALSE(owned.owns_memory());
+    EXPECT_EQ(33, owned.values_[2]);
+
+    DataView view;
+    view.appendBlock(block.get());
+    bool dense = false;
+    ASSERT_TRUE(view.getNext(&row, &dense));
+    EXPECT_TRUE(dense);
+
+    block->trimRows(4);
+    EXPECT_EQ(6, block->num_rows_);
+    block->getRowVectorFast(5, &row);
+    EXPECT_EQ(54, row.values_[3]);
+  }
+
   TEST(SparseDataBlockTest, TestRandomSparseDataBlock) {
     int ncolumns = 1000;
     int blockSizeMb = 10;
     double sparsity = 0.999;
-    std::unique_ptr<SparseDataBlock<num_t>> sparseBlock(GetRandomSparseDataBlock(blockSizeMb * 1e6, ncolumns, sparsity));
+    std::unique_ptr<SparseDataBlock<num_t>> sparseBlock(GetRandomSparseDataBlock(blockSizeMb * 1e6, ncolumns, sparsity, 42));
     EXPECT_LT(ncolumns * 0.9, sparseBlock->num_columns_);
     EXPECT_EQ(blockSizeMb * 1e6, sparseBlock->block_size_bytes_);
     // the low bound is calculated by (totalSizeBytes / (floats per column + size of header + size of classification) * 0.9
@@ -0,0 +1,85 @@
+#include "gtest/gtest.h"
+
+#include "storage/DenseDataBlock.h"
+#include "storage/exvector.h"
+#include "storage/TopK.h"
+#include "storage/Utils.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace obamadb {
+
+  /**
+   * Scores every item for a user and keeps the best k scores.
+   */
+  std::vector<num_t> bruteForceTopK(DenseDataBlock<num_t> const & mat_l,
+                                    DenseDataBlock<num_t> const & mat_r,
+                                    double mean,
+                                    int user,
+                                    int k) {
+    std::vector<num_t> scores;
+    for (int item = 0; item < mat_r.getNumRows(); item++) {
+      num_t score = mean;
+      for (int d = 0; d < mat_l.getNumColumns(); d++) {
+        score += *mat_l.get(user, d) * *mat_r.get(item, d);
+      }
+      scores.push_back(score);
+    }
+    std::sort(scores.begin(), scores.end(), std::greater<num_t>());
+    scores.resize(std::min<int>(k, scores.size()));
+    return scores;
+  }
+
+  TEST(TopKTest, TestMatchesBruteForce) {
+    int const users = 53, items = 301, rank = 7, k = 10;
+    DenseDataBlock<num_t> mat_l(users, rank);
+    DenseDataBlock<num_t> mat_r(items, rank);
+    mat_l.randomize();
+    mat_r.randomize();
+    // Spread out the norms so that pruning has something to prune.
+    for (int i = 0; i < items; i++) {
+      for (int d = 0; d < rank; d++) {
+        *mat_r.get(i, d) = (*mat_r.get(i, d) - 0.5) * (1 + i % 13);
+      }
+    }
+
+    for (bool prune : {false, true}) {
+      TopKRecommender recommender(&mat_l, &mat_r, 0.5, k, prune);
+      std::vector<Recommendation> recs = recommender.recommendAll(2);
+      ASSERT_EQ(users * k, recs.size());
+      for (int u = 0; u < users; u++) {
+        std::vector<num_t> expected = bruteForceTopK(mat_l, mat_r, 0.5, u, k);
+        for (int i = 0; i < k; i++) {
+          Recommendation const & rec = recs[u * k + i];
+          EXPECT_NEAR(expected[i], rec.score, 1e-4);
+          // The score should belong to the recommended item.
+          num_t score = 0.5;
+          for (int d = 0; d < rank; d++) {
+            score += *mat_l.get(u, d) * *mat_r.get(rec.item, d);
+          }
+          EXPECT_NEAR(score, rec.score, 1e-4);
+        }
+      }
+    }
+  }
+
+  TEST(TopKTest, TestFewerItemsThanK) {
+    DenseDataBlock<num_t> mat_l(5, 3);
+    DenseDataBlock<num_t> mat_r(4, 3);
+    mat_l.randomize();
+    mat_r.randomize();
+    TopKRecommender recommender(&mat_l, &mat_r, 0, 10, true);
+    EXPECT_EQ(4, recommender.k());
+    std::vector<Recommendation> recs = recommender.recommendAll(1);
+    ASSERT_EQ(5 * 4, recs.size());
+    for (int u = 0; u < 5; u++) {
+      std::vector<bool> seen(4, false);
+      for (int i = 0; i < 4; i++) {
+        seen[recs[u * 4 + i].item] = true;
+      }
+      EXPECT_EQ(4, std::count(seen.begin(), seen.end(), true));
+    }
+  }
+}
@@ -0,0 +1,136 @@
+#include "gtest/gtest.h"
+
+#include "storage/UnorderedMatrix.h"
+
+#include <cstdlib>
+#include <set>
+#include <utility>
+
+namespace obamadb {
+
+  TEST(UnorderedMatrixTest, TestGrowAndShrink) {
+    UnorderedMatrix mat;
+    EXPECT_EQ(0, mat.committedBytes());
+
+    int const n = UnorderedMatrix::kSegmentEntries * 2 + 17;
+    for (int i = 0; i < n; i++) {
+      mat.append(i % 1000, i % 77, i);
+    }
+    EXPECT_EQ(n, mat.numElements());
+    EXPECT_EQ(1000, mat.numRows());
+    EXPECT_EQ(77, mat.numColumns());
+    EXPECT_EQ(3 * UnorderedMatrix::kSegmentEntries * sizeof(MatrixEntry), mat.committedBytes());
+
+    mat.shrinkToFit();
+    EXPECT_GE(mat.committedBytes(), n * sizeof(MatrixEntry));
+    EXPECT_GT(UnorderedMatrix::kSegmentEntries * sizeof(MatrixEntry), mat.committedBytes() - n * sizeof(MatrixEntry));
+
+    // Appending after a shrink moves the entries.
+    for (int i = n; i < n + UnorderedMatrix::kSegmentEntries; i++) {
+      mat.append(i % 1000, i % 77, i);
+    }
+    for (int i = 0; i < mat.numElements(); i++) {
+      MatrixEntry const & entry = mat.get(i);
+      ASSERT_EQ(i % 1000, entry.row);
+      ASSERT_EQ(i % 77, entry.column);
+      ASSERT_EQ(static_cast<num_t>(i), entry.value);
+    }
+  }
+
+  TEST(UnorderedMatrixTest, TestGrowPastReservation) {
+    UnorderedMatrix mat;
+    int const n = UnorderedMatrix::kInitialReservedEntries;
+    MatrixEntry* entries = mat.extend(n);
+    for (int i = 0; i < n; i++) {
+      entries[i] = MatrixEntry(i % 1000, i % 77, i);
+    }
+    mat.growDimensions(1000, 77);
+    // The reservation is full, so this append moves the entries to a larger one.
+    mat.append(5, 6, -1);
+    EXPECT_EQ(n + 1, mat.numElements());
+    EXPECT_EQ(n + UnorderedMatrix::kSegmentEntries, mat.committedBytes() / sizeof(MatrixEntry));
+    for (int i = 0; i < n; i++) {
+      MatrixEntry const & entry = mat.get(i);
+      ASSERT_EQ(i % 1000, entry.row);
+      ASSERT_EQ(i % 77, entry.column);
+      ASSERT_EQ(static_cast<num_t>(i), entry.value);
+    }
+    EXPECT_EQ(-1, mat.get(n).value);
+  }
+
+  TEST(UnorderedMatrixTest, TestShrinkEmpty) {
+    UnorderedMatrix mat;
+    mat.shrinkToFit();
+    EXPECT_EQ(0, mat.committedBytes());
+    mat.append(3, 4, 1.5);
+    EXPECT_EQ(1, mat.numElements());
+    EXPECT_EQ(4, mat.numRows());
+    EXPECT_EQ(5, mat.numColumns());
+    EXPECT_EQ(1.5, mat.get(3, 4)->value);
+  }
+
+  TEST(UnorderedMatrixTest, TestReorder) {
+    int const n = 100000;
+    int const threads[] = {1, 3};
+    for (int num_threads : threads) {
+      UnorderedMatrix row_major;
+      UnorderedMatrix hilbert;
+      srand(7);
+      for (int i = 0; i < n; i++) {
+        int row = rand() % 4096;
+        int col = rand() % 4096;
+        // The value identifies the entry so we can check that it moved along with its key.
+        row_major.append(row, col, row * 4096 + col);
+        hilbert.append(row, col, row * 4096 + col);
+      }
+
+      row_major.reorder(EntryOrder::kRowMajor, num_threads);
+      ASSERT_EQ(n, row_major.numElements());
+      for (int i = 0; i < n; i++) {
+        MatrixEntry const & entry = row_major.get(i);
+        ASSERT_EQ(static_cast<num_t>(entry.row * 4096 + entry.column), entry.value);
+        if (i > 0) {
+          MatrixEntry const & last = row_major.get(i - 1);
+          ASSERT_TRUE(last.row < entry.row || (last.row == entry.row && last.column <= entry.column));
+        }
+      }
+
+      // Each tile appears as one run and, since the tiles fill a power of two sided square,
+      // tiles which follow each other are neighbors.
+      hilbert.reorder(EntryOrder::kHilbert, num_threads);
+      ASSERT_EQ(n, hilbert.numElements());
+      int const tile = 1 << UnorderedMatrix::kHilbertTileBits;
+      std::set<std::pair<int, int>> finished_tiles;
+      for (int i = 0; i < n; i++) {
+        MatrixEntry const & entry = hilbert.get(i);
+        ASSERT_EQ(static_cast<num_t>(entry.row * 4096 + entry.column), entry.value);
+        if (i > 0) {
+          MatrixEntry const & last = hilbert.get(i - 1);
+          std::pair<int, int> last_tile(last.row / tile, last.column / tile);
+          std::pair<int, int> this_tile(entry.row / tile, entry.column / tile);
+          if (last_tile != this_tile) {
+            ASSERT_EQ(1, std::abs(last_tile.first - this_tile.first) + std::abs(last_tile.second - this_tile.second));
+            ASSERT_TRUE(finished_tiles.insert(last_tile).second);
+            ASSERT_EQ(0, finished_tiles.count(this_tile));
+          }
+        }
+      }
+    }
+  }
+
+  TEST(UnorderedMatrixTest, TestPartition) {
+    UnorderedMatrix mat;
+    for (int i = 0; i < 1000; i++) {
+      mat.append((i * 7) % 100, i % 13, i);
+    }
+    std::vector<std::size_t> offsets = mat.partition(EntryField::kRow, 4, 2);
+    ASSERT_EQ(5, offsets.size());
+    EXPECT_EQ(1000, offsets[4]);
+    EXPECT_EQ(1000, mat.numElements());
+    for (int p = 0; p < 4; p++) {
+      for (std::size_t i = offsets[p]; i < offsets[p + 1]; i++) {
+        ASSERT_EQ(p, mat.get(i).row / 25);
+      }
+    }
+  }
+}
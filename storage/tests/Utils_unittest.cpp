@@ -4,9 +4,12 @@
 #include "storage/IO.h"
 #include "storage/Utils.h"
 
+#include <cstdint>
 #include <cstdlib>
 #include <memory>
+#include <thread>
 #include <unordered_set>
+#include <vector>
 
 namespace obamadb {
 
@@ -49,6 +52,51 @@ namespace obamadb {
     EXPECT_EQ(2, *vec3.get(200));
     EXPECT_EQ(*vec.class_, *vec3.class_);
   }
-}
 
+  TEST(UtilsTest, TestThreadLocalRandom) {
+    rng::setSeed(99);
+    rng::seedThread(3);
+    std::vector<std::uint64_t> first;
+    for (int i = 0; i < 10; i++) {
+      first.push_back(rng::threadLocal().next());
+    }
+
+    // A different thread with the same stream sees the same numbers.
+    std::vector<std::uint64_t> other;
+    std::thread thread([&other]() {
+      rng::seedThread(3);
+      for (int i = 0; i < 10; i++) {
+        other.push_back(rng::threadLocal().next());
+      }
+    });
+    thread.join();
+    EXPECT_EQ(first, other);
+
+    // Changing the seed changes the stream.
+    rng::setSeed(100);
+    EXPECT_NE(first[0], rng::threadLocal().next());
+  }
 
+  TEST(UtilsTest, TestFillUniform) {
+    int const n = 100003;
+    std::vector<float> values(n, 7.0f);
+    rng::fillUniform(values.data(), n, -1.0f, 1.0f);
+    double sum = 0;
+    for (float value : values) {
+      ASSERT_GE(value, -1.0f);
+      ASSERT_LT(value, 1.0f);
+      sum += value;
+    }
+    EXPECT_NEAR(0.0, sum / n, 0.02);
+
+    std::vector<double> doubles(n, 7.0);
+    rng::fillUniform(doubles.data(), n, 0.0, 1.0);
+    sum = 0;
+    for (double value : doubles) {
+      ASSERT_GE(value, 0.0);
+      ASSERT_LT(value, 1.0);
+      sum += value;
+    }
+    EXPECT_NEAR(0.5, sum / n, 0.02);
+  }
+}